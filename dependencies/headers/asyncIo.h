@@ -0,0 +1,866 @@
+#ifndef ASYNCIO_H
+#define ASYNCIO_H
+#include <iostream>
+#include <coroutine>
+#include <exception>
+#include <optional>
+#include <functional>
+#include <type_traits>
+#include <utility>
+#include <string>
+#include <vector>
+#include <deque>
+#include <unordered_map>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <atomic>
+#include <chrono>
+#include <algorithm>
+#include <cerrno>
+#include <curl/curl.h>
+#ifdef _WIN32
+#include <winsock2.h>
+#else
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+#include "httpClient.h"
+
+//---------------------------------------------------------------------------------------------------
+//------------------COROUTINE TASKS------------------------------------------------------------------
+//---------------------------------------------------------------------------------------------------
+// Task<T> is a lazy coroutine: it starts when awaited and resumes its awaiter when it finishes.
+// Exceptions thrown inside a task come out of the co_await. Coroutine parameters should be taken
+// by value (or point to something that outlives the task), since the caller's frame may be gone by
+// the time the body runs.
+template <typename T = void>
+class Task;
+
+struct TaskPromiseBase {
+    std::coroutine_handle<> continuation = std::noop_coroutine();
+    std::exception_ptr error;
+
+    struct FinalAwaiter {
+        bool await_ready() noexcept { return false; }
+        template <typename Promise>
+        std::coroutine_handle<> await_suspend(std::coroutine_handle<Promise> finished) noexcept {
+            return finished.promise().continuation;
+        }
+        void await_resume() noexcept {}
+    };
+
+    std::suspend_always initial_suspend() noexcept { return {}; }
+    FinalAwaiter final_suspend() noexcept { return {}; }
+    void unhandled_exception() noexcept { error = std::current_exception(); }
+};
+
+template <typename T>
+struct TaskPromise : TaskPromiseBase {
+    std::optional<T> value;
+
+    Task<T> get_return_object() noexcept;
+
+    template <typename U>
+    void return_value(U&& result) { value.emplace(std::forward<U>(result)); }
+
+    T result() {
+        if (error) {
+            std::rethrow_exception(error);
+        }
+        return std::move(*value);
+    }
+};
+
+template <>
+struct TaskPromise<void> : TaskPromiseBase {
+    Task<void> get_return_object() noexcept;
+    void return_void() noexcept {}
+
+    void result() {
+        if (error) {
+            std::rethrow_exception(error);
+        }
+    }
+};
+
+template <typename T>
+class [[nodiscard]] Task {
+public:
+    using promise_type = TaskPromise<T>;
+    using Handle = std::coroutine_handle<promise_type>;
+
+    Task() = default;
+    explicit Task(Handle handle) : handle(handle) {}
+    Task(Task&& other) noexcept : handle(std::exchange(other.handle, {})) {}
+    Task& operator=(Task&& other) noexcept {
+        if (this != &other) {
+            if (handle) {
+                handle.destroy();
+            }
+            handle = std::exchange(other.handle, {});
+        }
+        return *this;
+    }
+    Task(const Task&) = delete;
+    Task& operator=(const Task&) = delete;
+    ~Task() {
+        if (handle) {
+            handle.destroy();
+        }
+    }
+
+    bool await_ready() const noexcept { return !handle || handle.done(); }
+
+    // Symmetric transfer: the awaiting coroutine jumps straight into the task, no extra stack frame
+    std::coroutine_handle<> await_suspend(std::coroutine_handle<> awaiting) noexcept {
+        handle.promise().continuation = awaiting;
+        return handle;
+    }
+
+    T await_resume() { return handle.promise().result(); }
+
+private:
+    Handle handle;
+};
+
+template <typename T>
+Task<T> TaskPromise<T>::get_return_object() noexcept {
+    return Task<T>(std::coroutine_handle<TaskPromise<T>>::from_promise(*this));
+}
+
+Task<void> TaskPromise<void>::get_return_object() noexcept {
+    return Task<void>(std::coroutine_handle<TaskPromise<void>>::from_promise(*this));
+}
+
+// Fire-and-forget coroutine: starts immediately and frees itself when done
+struct DetachedTask {
+    struct promise_type {
+        DetachedTask get_return_object() noexcept { return {}; }
+        std::suspend_never initial_suspend() noexcept { return {}; }
+        std::suspend_never final_suspend() noexcept { return {}; }
+        void return_void() noexcept {}
+        void unhandled_exception() noexcept { std::terminate(); }
+    };
+};
+
+//---------------------------------------------------------------------------------------------------
+//------------------EVENT LOOP (curl_multi_socket_action)--------------------------------------------
+//---------------------------------------------------------------------------------------------------
+// One thread drives every transfer: libcurl reports which sockets it wants watched (socket callback)
+// and when it next needs a timeout call (timer callback); the loop waits on those sockets with epoll
+// (WSAPoll on Windows) and hands ready ones to curl_multi_socket_action. A finished transfer resumes
+// the coroutine that awaited it, on the loop thread, so coroutine code needs no locking of its own.
+// Other threads hand work back through post(), which wakes the loop via a loopback UDP socket.
+// libcurl must already be initialized: curl_global_init runs once in main, not per loop.
+class EventLoop;
+
+struct HttpResponse {
+    CURLcode result = CURLE_OK;
+    long status = 0;
+    std::string body;                                   // empty when a custom write function was used
+    std::optional<std::chrono::seconds> retryAfter;     // from a Retry-After header
+    std::chrono::steady_clock::duration latency{};
+
+    bool ok() const { return result == CURLE_OK && status == 200; }
+};
+
+// Awaitable GET; the easy handle comes from the client's pool and goes back to it when the transfer ends
+class HttpRequest {
+public:
+    HttpRequest(EventLoop& loop, HttpClient& client, std::string url, curl_write_callback writeFunction,
+        void* writeData, std::chrono::milliseconds timeout)
+        : loop(loop), client(client), url(std::move(url)), writeFunction(writeFunction), writeData(writeData), timeout(timeout) {}
+
+    bool await_ready() const noexcept { return false; }
+    void await_suspend(std::coroutine_handle<> awaiting);
+    HttpResponse await_resume() { return std::move(response); }
+
+private:
+    friend class EventLoop;
+
+    EventLoop& loop;
+    HttpClient& client;
+    std::string url;
+    curl_write_callback writeFunction;
+    void* writeData;
+    std::chrono::milliseconds timeout;
+    CURL* easy = nullptr;
+    std::chrono::steady_clock::time_point started;
+    HttpResponse response;
+    std::coroutine_handle<> waiter;
+};
+
+class EventLoop {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    struct Stats {
+        size_t requests = 0;
+        size_t peakInFlight = 0;
+        size_t polls = 0;           // epoll_wait/WSAPoll calls
+        size_t socketEvents = 0;    // ready sockets handed to curl
+        size_t wakeups = 0;         // cross-thread post() wakeups
+    };
+
+    // maxHostConnections caps connections per host (0 = no cap); extra transfers queue inside libcurl
+    explicit EventLoop(long maxHostConnections = 0) {
+        multi = curl_multi_init();
+        if (!multi) {
+            std::cerr << "Failed to initialize curl multi" << std::endl;
+            return;
+        }
+        curl_multi_setopt(multi, CURLMOPT_SOCKETFUNCTION, socketCallback);
+        curl_multi_setopt(multi, CURLMOPT_SOCKETDATA, this);
+        curl_multi_setopt(multi, CURLMOPT_TIMERFUNCTION, timerCallback);
+        curl_multi_setopt(multi, CURLMOPT_TIMERDATA, this);
+        curl_multi_setopt(multi, CURLMOPT_MAX_HOST_CONNECTIONS, maxHostConnections);
+
+#ifndef _WIN32
+        epollFd = epoll_create1(EPOLL_CLOEXEC);
+        if (epollFd < 0) {
+            std::cerr << "Failed to create epoll instance" << std::endl;
+        }
+#endif
+        openWakeSocket();
+    }
+
+    ~EventLoop() {
+        if (multi) {
+            curl_multi_cleanup(multi);
+        }
+        if (wakeSocket != CURL_SOCKET_BAD) {
+            closeSocket(wakeSocket);
+        }
+#ifndef _WIN32
+        if (epollFd >= 0) {
+            close(epollFd);
+        }
+#endif
+    }
+
+    EventLoop(const EventLoop&) = delete;
+    EventLoop& operator=(const EventLoop&) = delete;
+
+    // co_await loop.get(client, url) -> HttpResponse with the body collected
+    HttpRequest get(HttpClient& client, std::string url, std::chrono::milliseconds timeout = std::chrono::milliseconds(0)) {
+        return HttpRequest(*this, client, std::move(url), nullptr, nullptr, timeout);
+    }
+
+    // Streaming form: the body goes to writeFunction chunk by chunk, on the loop thread
+    HttpRequest get(HttpClient& client, std::string url, curl_write_callback writeFunction, void* writeData,
+        std::chrono::milliseconds timeout = std::chrono::milliseconds(0)) {
+        return HttpRequest(*this, client, std::move(url), writeFunction, writeData, timeout);
+    }
+
+    struct SleepAwaiter {
+        EventLoop& loop;
+        Clock::time_point deadline;
+
+        bool await_ready() const { return Clock::now() >= deadline; }
+        void await_suspend(std::coroutine_handle<> awaiting) { loop.addTimer(deadline, awaiting); }
+        void await_resume() const noexcept {}
+    };
+
+    // co_await loop.sleepFor(d): resumes on the loop thread once d has passed
+    SleepAwaiter sleepFor(Clock::duration duration) { return SleepAwaiter{ *this, Clock::now() + duration }; }
+
+    struct ScheduleAwaiter {
+        EventLoop& loop;
+
+        bool await_ready() const { return loop.isLoopThread(); }
+        void await_suspend(std::coroutine_handle<> awaiting) { loop.post(awaiting); }
+        void await_resume() const noexcept {}
+    };
+
+    // co_await loop.schedule(): continues on the loop thread
+    ScheduleAwaiter schedule() { return ScheduleAwaiter{ *this }; }
+
+    // Thread-safe: the coroutine is resumed by the loop on its next iteration
+    void post(std::coroutine_handle<> handle) {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            posted.push_back(handle);
+        }
+        wake();
+    }
+
+    bool isLoopThread() const { return owner.load() == std::this_thread::get_id(); }
+
+    // Runs on the calling thread until done() returns true; done() is checked between iterations
+    void run(const std::function<bool()>& done) {
+        owner = std::this_thread::get_id();
+        std::vector<std::pair<curl_socket_t, int>> ready;
+        while (!done()) {
+            runReady();
+            if (done()) {
+                break;
+            }
+
+            ready.clear();
+            waitForSockets(nextTimeoutMs(), ready);
+            ++stats.polls;
+
+            int running = 0;
+            for (const auto& [socket, flags] : ready) {
+                if (socket == wakeSocket) {
+                    drainWakeSocket();
+                    continue;
+                }
+                ++stats.socketEvents;
+                curl_multi_socket_action(multi, socket, flags, &running);
+            }
+            if (curlDeadline.has_value() && Clock::now() >= *curlDeadline) {
+                curlDeadline.reset();
+                curl_multi_socket_action(multi, CURL_SOCKET_TIMEOUT, 0, &running);
+            }
+            finishTransfers();
+        }
+        owner = std::thread::id();
+    }
+
+    size_t inFlight() const { return transfers; }
+    Stats statistics() const { return stats; }
+
+private:
+    friend class HttpRequest;
+
+    struct Timer {
+        Clock::time_point deadline;
+        std::coroutine_handle<> waiter;
+        bool operator>(const Timer& other) const { return deadline > other.deadline; }
+    };
+
+    // Called from HttpRequest::await_suspend; requests from other threads are handed over through the queue
+    void startRequest(HttpRequest* request) {
+        if (!isLoopThread()) {
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                pendingRequests.push_back(request);
+            }
+            wake();
+            return;
+        }
+        addTransfer(request);
+    }
+
+    void addTransfer(HttpRequest* request) {
+        request->easy = multi ? request->client.acquire() : nullptr;
+        if (!request->easy) {
+            request->response.result = CURLE_FAILED_INIT;
+            post(request->waiter);
+            return;
+        }
+
+        CURL* easy = request->easy;
+        curl_easy_setopt(easy, CURLOPT_URL, request->url.c_str());
+        if (request->writeFunction) {
+            curl_easy_setopt(easy, CURLOPT_WRITEFUNCTION, request->writeFunction);
+            curl_easy_setopt(easy, CURLOPT_WRITEDATA, request->writeData);
+        }
+        else {
+            curl_easy_setopt(easy, CURLOPT_WRITEFUNCTION, appendToBody);
+            curl_easy_setopt(easy, CURLOPT_WRITEDATA, &request->response.body);
+        }
+        curl_easy_setopt(easy, CURLOPT_PRIVATE, request);
+        curl_easy_setopt(easy, CURLOPT_TIMEOUT_MS, static_cast<long>(request->timeout.count()));
+        request->started = Clock::now();
+
+        CURLMcode mc = curl_multi_add_handle(multi, easy);
+        if (mc != CURLM_OK) {
+            std::cerr << "curl_multi_add_handle() failed: " << curl_multi_strerror(mc) << std::endl;
+            request->client.release(easy);
+            request->easy = nullptr;
+            request->response.result = CURLE_FAILED_INIT;
+            post(request->waiter);
+            return;
+        }
+        ++stats.requests;
+        ++transfers;
+        stats.peakInFlight = std::max(stats.peakInFlight, transfers);
+    }
+
+    // Collects finished transfers, then resumes their coroutines (which may start new transfers)
+    void finishTransfers() {
+        int queued = 0;
+        while (CURLMsg* msg = curl_multi_info_read(multi, &queued)) {
+            if (msg->msg != CURLMSG_DONE) {
+                continue;
+            }
+            HttpRequest* request = nullptr;
+            curl_easy_getinfo(msg->easy_handle, CURLINFO_PRIVATE, &request);
+            CURLcode result = msg->data.result;
+            curl_multi_remove_handle(multi, request->easy);
+            --transfers;
+
+            HttpResponse& response = request->response;
+            response.result = result;
+            response.latency = Clock::now() - request->started;
+            curl_easy_getinfo(request->easy, CURLINFO_RESPONSE_CODE, &response.status);
+            curl_off_t retryAfter = 0;
+            curl_easy_getinfo(request->easy, CURLINFO_RETRY_AFTER, &retryAfter);
+            if (retryAfter > 0) {
+                response.retryAfter = std::chrono::seconds(retryAfter);
+            }
+            if (result == CURLE_OK) {
+                request->client.recordTransfer(request->easy);
+            }
+            request->client.release(request->easy);
+            request->easy = nullptr;
+
+            // The request object lives in the coroutine frame: nothing may touch it after this
+            finished.push_back(request->waiter);
+        }
+
+        for (size_t i = 0; i < finished.size(); ++i) {
+            finished[i].resume();
+        }
+        finished.clear();
+    }
+
+    // Posted coroutines, requests started from other threads and expired sleeps
+    void runReady() {
+        std::vector<std::coroutine_handle<>> resumable;
+        std::vector<HttpRequest*> requests;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            resumable.swap(posted);
+            requests.swap(pendingRequests);
+            auto now = Clock::now();
+            while (!timers.empty() && timers.front().deadline <= now) {
+                std::pop_heap(timers.begin(), timers.end(), std::greater<Timer>());
+                resumable.push_back(timers.back().waiter);
+                timers.pop_back();
+            }
+        }
+        for (HttpRequest* request : requests) {
+            addTransfer(request);
+        }
+        for (auto handle : resumable) {
+            handle.resume();
+        }
+    }
+
+    void addTimer(Clock::time_point deadline, std::coroutine_handle<> waiter) {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            timers.push_back(Timer{ deadline, waiter });
+            std::push_heap(timers.begin(), timers.end(), std::greater<Timer>());
+        }
+        if (!isLoopThread()) {
+            wake();
+        }
+    }
+
+    // Earliest of: libcurl's timer, the next sleep, 1 s (so a lost wakeup cannot hang the loop)
+    int nextTimeoutMs() {
+        auto now = Clock::now();
+        Clock::time_point deadline = now + std::chrono::seconds(1);
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (!posted.empty() || !pendingRequests.empty()) {
+                return 0;
+            }
+            if (!timers.empty()) {
+                deadline = std::min(deadline, timers.front().deadline);
+            }
+        }
+        if (curlDeadline.has_value()) {
+            deadline = std::min(deadline, *curlDeadline);
+        }
+        if (deadline <= now) {
+            return 0;
+        }
+        // Round up: waking a millisecond early would just spin once more
+        return static_cast<int>(std::chrono::duration_cast<std::chrono::milliseconds>(deadline - now).count()) + 1;
+    }
+
+    //------------------socket readiness (epoll / WSAPoll)------------------
+    void watch(curl_socket_t socket, int what) {
+        bool known = watched.count(socket) > 0;
+        watched[socket] = what;
+#ifdef _WIN32
+        (void)known;
+#else
+        epoll_event event{};
+        event.events = ((what & CURL_POLL_IN) ? uint32_t(EPOLLIN) : 0u) | ((what & CURL_POLL_OUT) ? uint32_t(EPOLLOUT) : 0u);
+        event.data.fd = socket;
+        // A socket closed without a REMOVE has already left the epoll set; its reused number needs ADD
+        bool added = epoll_ctl(epollFd, known ? EPOLL_CTL_MOD : EPOLL_CTL_ADD, socket, &event) == 0
+            || (known && errno == ENOENT && epoll_ctl(epollFd, EPOLL_CTL_ADD, socket, &event) == 0);
+        if (!added) {
+            std::cerr << "epoll_ctl() failed for socket " << socket << std::endl;
+        }
+#endif
+    }
+
+    void unwatch(curl_socket_t socket) {
+        if (watched.erase(socket) == 0) {
+            return;
+        }
+#ifndef _WIN32
+        epoll_ctl(epollFd, EPOLL_CTL_DEL, socket, nullptr);
+#endif
+    }
+
+    // Fills ready with (socket, CURL_CSELECT_* flags)
+    void waitForSockets(int timeoutMs, std::vector<std::pair<curl_socket_t, int>>& ready) {
+#ifdef _WIN32
+        pollSet.clear();
+        for (const auto& [socket, what] : watched) {
+            WSAPOLLFD entry{};
+            entry.fd = socket;
+            entry.events = static_cast<SHORT>(((what & CURL_POLL_IN) ? POLLRDNORM : 0) | ((what & CURL_POLL_OUT) ? POLLWRNORM : 0));
+            pollSet.push_back(entry);
+        }
+        int count = WSAPoll(pollSet.data(), static_cast<ULONG>(pollSet.size()), timeoutMs);
+        for (int i = 0, seen = 0; seen < count && i < static_cast<int>(pollSet.size()); ++i) {
+            SHORT revents = pollSet[i].revents;
+            if (revents == 0) {
+                continue;
+            }
+            ++seen;
+            int flags = ((revents & (POLLRDNORM | POLLHUP)) ? CURL_CSELECT_IN : 0)
+                | ((revents & POLLWRNORM) ? CURL_CSELECT_OUT : 0)
+                | ((revents & (POLLERR | POLLNVAL)) ? CURL_CSELECT_ERR : 0);
+            ready.emplace_back(pollSet[i].fd, flags);
+        }
+#else
+        epoll_event events[256];
+        int count = epoll_wait(epollFd, events, 256, timeoutMs);
+        for (int i = 0; i < count; ++i) {
+            uint32_t revents = events[i].events;
+            int flags = ((revents & (EPOLLIN | EPOLLHUP)) ? CURL_CSELECT_IN : 0)
+                | ((revents & EPOLLOUT) ? CURL_CSELECT_OUT : 0)
+                | ((revents & EPOLLERR) ? CURL_CSELECT_ERR : 0);
+            curl_socket_t socket = events[i].data.fd;
+            ready.emplace_back(socket, flags);
+        }
+#endif
+    }
+
+    //------------------cross-thread wakeup------------------
+    // A UDP socket connected to itself: a datagram sent from any thread makes it readable
+    void openWakeSocket() {
+        wakeSocket = socket(AF_INET, SOCK_DGRAM, 0);
+        if (wakeSocket == CURL_SOCKET_BAD) {
+            std::cerr << "Failed to create wakeup socket" << std::endl;
+            return;
+        }
+        sockaddr_in address{};
+        address.sin_family = AF_INET;
+        address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        address.sin_port = 0;
+#ifdef _WIN32
+        int length = sizeof(address);
+#else
+        socklen_t length = sizeof(address);
+#endif
+        if (bind(wakeSocket, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0
+            || getsockname(wakeSocket, reinterpret_cast<sockaddr*>(&address), &length) != 0
+            || connect(wakeSocket, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0) {
+            std::cerr << "Failed to set up wakeup socket" << std::endl;
+            closeSocket(wakeSocket);
+            wakeSocket = CURL_SOCKET_BAD;
+            return;
+        }
+#ifdef _WIN32
+        u_long nonBlocking = 1;
+        ioctlsocket(wakeSocket, FIONBIO, &nonBlocking);
+#else
+        fcntl(wakeSocket, F_SETFL, fcntl(wakeSocket, F_GETFL, 0) | O_NONBLOCK);
+#endif
+        watch(wakeSocket, CURL_POLL_IN);
+    }
+
+    void wake() {
+        if (isLoopThread() || wakeSocket == CURL_SOCKET_BAD || wakePending.exchange(true)) {
+            return;
+        }
+        char byte = 1;
+        send(wakeSocket, &byte, 1, 0);
+    }
+
+    void drainWakeSocket() {
+        ++stats.wakeups;
+        wakePending = false;
+        char buffer[64];
+        while (recv(wakeSocket, buffer, sizeof(buffer), 0) > 0) {
+        }
+    }
+
+    static void closeSocket(curl_socket_t socket) {
+#ifdef _WIN32
+        closesocket(socket);
+#else
+        close(socket);
+#endif
+    }
+
+    //------------------libcurl callbacks------------------
+    static int socketCallback(CURL*, curl_socket_t socket, int what, void* userData, void*) {
+        EventLoop* loop = static_cast<EventLoop*>(userData);
+        if (what == CURL_POLL_REMOVE) {
+            loop->unwatch(socket);
+        }
+        else {
+            loop->watch(socket, what);
+        }
+        return 0;
+    }
+
+    static int timerCallback(CURLM*, long timeoutMs, void* userData) {
+        EventLoop* loop = static_cast<EventLoop*>(userData);
+        if (timeoutMs < 0) {
+            loop->curlDeadline.reset();
+        }
+        else {
+            loop->curlDeadline = Clock::now() + std::chrono::milliseconds(timeoutMs);
+        }
+        return 0;
+    }
+
+    static size_t appendToBody(char* contents, size_t size, size_t nmemb, void* userData) {
+        size_t totalSize = size * nmemb;
+        static_cast<std::string*>(userData)->append(contents, totalSize);
+        return totalSize;
+    }
+
+    CURLM* multi = nullptr;
+#ifdef _WIN32
+    std::vector<WSAPOLLFD> pollSet;
+#else
+    int epollFd = -1;
+#endif
+    std::unordered_map<curl_socket_t, int> watched;   // socket -> CURL_POLL_* wanted
+    std::optional<Clock::time_point> curlDeadline;
+    curl_socket_t wakeSocket = CURL_SOCKET_BAD;
+    std::atomic<bool> wakePending{ false };
+    std::atomic<std::thread::id> owner{};
+    size_t transfers = 0;
+    std::vector<std::coroutine_handle<>> finished;
+    Stats stats;
+
+    std::mutex mutex;                               // guards the three queues below
+    std::vector<std::coroutine_handle<>> posted;
+    std::vector<HttpRequest*> pendingRequests;
+    std::vector<Timer> timers;                      // min-heap on deadline
+};
+
+void HttpRequest::await_suspend(std::coroutine_handle<> awaiting) {
+    waiter = awaiting;
+    loop.startRequest(this);
+}
+
+// Each thread that runs coroutines from synchronous code (syncUser with eventLoop) gets its own loop,
+// created on first use and kept for the thread's lifetime
+EventLoop& threadEventLoop() {
+    thread_local EventLoop loop;
+    return loop;
+}
+
+//---------------------------------------------------------------------------------------------------
+//------------------RUNNING TASKS--------------------------------------------------------------------
+//---------------------------------------------------------------------------------------------------
+template <typename T>
+DetachedTask completeInto(Task<T>& task, std::optional<T>* value, std::exception_ptr* error, bool* done) {
+    try {
+        value->emplace(co_await task);
+    }
+    catch (...) {
+        *error = std::current_exception();
+    }
+    *done = true;
+}
+
+DetachedTask completeInto(Task<void>& task, std::exception_ptr* error, bool* done) {
+    try {
+        co_await task;
+    }
+    catch (...) {
+        *error = std::current_exception();
+    }
+    *done = true;
+}
+
+// Blocks the calling thread, running loop until task finishes; this is how the synchronous API is built.
+// Must not be called from a coroutine already running on the same loop.
+template <typename T>
+T syncWait(EventLoop& loop, Task<T> task) {
+    std::optional<T> value;
+    std::exception_ptr error;
+    bool done = false;
+    completeInto(task, &value, &error, &done);
+    loop.run([&done] { return done; });
+    if (error) {
+        std::rethrow_exception(error);
+    }
+    return std::move(*value);
+}
+
+void syncWait(EventLoop& loop, Task<void> task) {
+    std::exception_ptr error;
+    bool done = false;
+    completeInto(task, &error, &done);
+    loop.run([&done] { return done; });
+    if (error) {
+        std::rethrow_exception(error);
+    }
+}
+
+struct WhenAllState {
+    size_t remaining = 0;
+    std::coroutine_handle<> waiter;
+    std::exception_ptr error;
+};
+
+DetachedTask whenAllMember(Task<void>& task, WhenAllState* state) {
+    try {
+        co_await task;
+    }
+    catch (...) {
+        if (!state->error) {
+            state->error = std::current_exception();
+        }
+    }
+    if (--state->remaining == 0 && state->waiter) {
+        state->waiter.resume();
+    }
+}
+
+// Runs all tasks concurrently and finishes when the last one does; the first exception is rethrown.
+// Single-threaded: every task must resume on the same loop as the awaiter.
+Task<void> whenAll(std::vector<Task<void>> tasks) {
+    struct AllDone {
+        WhenAllState& state;
+        bool await_ready() const { return --state.remaining == 0; }
+        void await_suspend(std::coroutine_handle<> awaiting) { state.waiter = awaiting; }
+        void await_resume() const noexcept {}
+    };
+
+    WhenAllState state;
+    state.remaining = tasks.size() + 1;  // the extra count is dropped once every task has started
+    for (auto& task : tasks) {
+        whenAllMember(task, &state);
+    }
+    co_await AllDone{ state };
+    if (state.error) {
+        std::rethrow_exception(state.error);
+    }
+}
+
+// Waits (loop thread only) until notifyAll(); used for backpressure between coroutines
+class AsyncCondition {
+public:
+    explicit AsyncCondition(EventLoop& loop) : loop(loop) {}
+
+    struct Awaiter {
+        AsyncCondition& condition;
+        bool await_ready() const noexcept { return false; }
+        void await_suspend(std::coroutine_handle<> awaiting) { condition.waiters.push_back(awaiting); }
+        void await_resume() const noexcept {}
+    };
+
+    Awaiter wait() { return Awaiter{ *this }; }
+
+    // Waiters are resumed by the loop, oldest first, not from inside the notifying coroutine
+    void notify(size_t count) {
+        count = std::min(count, waiters.size());
+        for (size_t i = 0; i < count; ++i) {
+            loop.post(waiters[i]);
+        }
+        waiters.erase(waiters.begin(), waiters.begin() + count);
+    }
+
+    void notifyAll() { notify(waiters.size()); }
+    size_t waiting() const { return waiters.size(); }
+
+private:
+    EventLoop& loop;
+    std::deque<std::coroutine_handle<>> waiters;
+};
+
+//---------------------------------------------------------------------------------------------------
+//------------------WRITER EXECUTOR------------------------------------------------------------------
+//---------------------------------------------------------------------------------------------------
+// A single thread that owns the database writes. co_await writer.run(job) runs job there and
+// resumes the coroutine on its event loop with job's result, so SQLite never blocks the loop.
+class WriterExecutor {
+public:
+    explicit WriterExecutor(EventLoop& loop) : loop(loop), worker([this] { work(); }) {}
+
+    ~WriterExecutor() {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            closed = true;
+        }
+        available.notify_one();
+        worker.join();
+    }
+
+    WriterExecutor(const WriterExecutor&) = delete;
+    WriterExecutor& operator=(const WriterExecutor&) = delete;
+
+    template <typename Job>
+    struct RunAwaiter {
+        using Result = std::invoke_result_t<Job&>;
+        static_assert(!std::is_void_v<Result>, "writer jobs return their outcome");
+
+        WriterExecutor& executor;
+        Job job;
+        std::optional<Result> result;
+
+        bool await_ready() const noexcept { return false; }
+        void await_suspend(std::coroutine_handle<> awaiting) {
+            executor.submit([this, awaiting] {
+                result.emplace(job());
+                executor.loop.post(awaiting);
+            });
+        }
+        Result await_resume() { return std::move(*result); }
+    };
+
+    template <typename Job>
+    RunAwaiter<Job> run(Job job) { return RunAwaiter<Job>{ *this, std::move(job), std::nullopt }; }
+
+    size_t jobsRun() const { return completed.load(); }
+
+private:
+    void submit(std::function<void()> job) {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            jobs.push_back(std::move(job));
+        }
+        available.notify_one();
+    }
+
+    void work() {
+        std::unique_lock<std::mutex> lock(mutex);
+        while (true) {
+            available.wait(lock, [this] { return closed || !jobs.empty(); });
+            if (jobs.empty()) {
+                return;
+            }
+            std::function<void()> job = std::move(jobs.front());
+            jobs.pop_front();
+            lock.unlock();
+            job();
+            ++completed;
+            lock.lock();
+        }
+    }
+
+    EventLoop& loop;
+    std::mutex mutex;
+    std::condition_variable available;
+    std::deque<std::function<void()>> jobs;
+    bool closed = false;
+    std::atomic<size_t> completed{ 0 };
+    std::thread worker;  // last: starts after everything above is constructed
+};
+
+#endif // ASYNCIO_H
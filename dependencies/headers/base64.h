@@ -0,0 +1,280 @@
+#ifndef BASE64_H
+#define BASE64_H
+#include <array>
+#include <cstdint>
+#include <cstring>
+#include <optional>
+#include <string>
+#include <string_view>
+
+#if defined(_M_X64) || defined(__x86_64__)
+#define BASE64_X86_64 1
+#include <immintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#define BASE64_TARGET(isa)
+#else
+#include <cpuid.h>
+#define BASE64_TARGET(isa) __attribute__((target(isa)))
+#endif
+#endif
+
+//---------------------------------------------------------------------------------------------------
+//------------------BASE64URL DECODING---------------------------------------------------------------
+//---------------------------------------------------------------------------------------------------
+// Decoder for the "-"/"_" alphabet used in MessageIDs. Padding is optional. Output goes into a
+// caller-supplied buffer of at least Base64UrlMaxDecodedSize(input.size()) bytes.
+// Long inputs go through 16/32-byte SSE4.1/AVX2 kernels, picked once at runtime from CPUID.
+
+enum class Base64Kernel {
+    Scalar,
+    SSE41,
+    AVX2
+};
+
+constexpr std::array<int8_t, 256> makeBase64UrlDecodeTable() {
+    std::array<int8_t, 256> table{};
+    for (auto& value : table) {
+        value = -1;
+    }
+    constexpr char alphabet[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789-_";
+    for (int i = 0; i < 64; ++i) {
+        table[static_cast<unsigned char>(alphabet[i])] = static_cast<int8_t>(i);
+    }
+    return table;
+}
+
+constexpr std::array<int8_t, 256> BASE64URL_DECODE_TABLE = makeBase64UrlDecodeTable();
+
+constexpr size_t Base64UrlMaxDecodedSize(size_t encodedLength) {
+    return encodedLength / 4 * 3 + (encodedLength % 4 == 3 ? 2 : encodedLength % 4 == 2 ? 1 : 0);
+}
+
+const char* base64KernelName(Base64Kernel kernel) {
+    switch (kernel) {
+    case Base64Kernel::AVX2: return "avx2";
+    case Base64Kernel::SSE41: return "sse4.1";
+    default: return "scalar";
+    }
+}
+
+Base64Kernel detectBase64Kernel() {
+#ifdef BASE64_X86_64
+#ifdef _MSC_VER
+    int info[4] = {};
+    __cpuid(info, 0);
+    int maxLeaf = info[0];
+    __cpuid(info, 1);
+    bool sse41 = (info[2] & (1 << 19)) != 0;
+    bool osAvx = (info[2] & (1 << 27)) != 0 && (info[2] & (1 << 28)) != 0 && (_xgetbv(0) & 0x6) == 0x6;
+    bool avx2 = false;
+    if (osAvx && maxLeaf >= 7) {
+        __cpuidex(info, 7, 0);
+        avx2 = (info[1] & (1 << 5)) != 0;
+    }
+#else
+    __builtin_cpu_init();
+    bool sse41 = __builtin_cpu_supports("sse4.1");
+    bool avx2 = __builtin_cpu_supports("avx2");
+#endif
+    if (avx2) return Base64Kernel::AVX2;
+    if (sse41) return Base64Kernel::SSE41;
+#endif
+    return Base64Kernel::Scalar;
+}
+
+Base64Kernel activeBase64Kernel() {
+    static const Base64Kernel kernel = detectBase64Kernel();
+    return kernel;
+}
+
+#ifdef BASE64_X86_64
+// Byte mask of lo <= v <= hi; every alphabet character is below 0x80, so the signed compare is enough
+BASE64_TARGET("sse4.1")
+__m128i base64InRangeSSE41(__m128i v, char lo, char hi) {
+    return _mm_and_si128(_mm_cmpgt_epi8(v, _mm_set1_epi8(lo - 1)), _mm_cmplt_epi8(v, _mm_set1_epi8(hi + 1)));
+}
+
+BASE64_TARGET("avx2")
+__m256i base64InRangeAVX2(__m256i v, char lo, char hi) {
+    return _mm256_and_si256(_mm256_cmpgt_epi8(v, _mm256_set1_epi8(lo - 1)), _mm256_cmpgt_epi8(_mm256_set1_epi8(hi + 1), v));
+}
+
+// Maps 16 ASCII characters to their 6-bit values; false if any byte is outside the alphabet
+BASE64_TARGET("sse4.1")
+bool base64UrlValuesSSE41(__m128i input, __m128i& values) {
+    __m128i upper = base64InRangeSSE41(input, 'A', 'Z');
+    __m128i lower = base64InRangeSSE41(input, 'a', 'z');
+    __m128i digit = base64InRangeSSE41(input, '0', '9');
+    __m128i dash = _mm_cmpeq_epi8(input, _mm_set1_epi8('-'));
+    __m128i underscore = _mm_cmpeq_epi8(input, _mm_set1_epi8('_'));
+
+    __m128i valid = _mm_or_si128(_mm_or_si128(upper, lower), _mm_or_si128(_mm_or_si128(digit, dash), underscore));
+    if (_mm_movemask_epi8(valid) != 0xFFFF) {
+        return false;
+    }
+
+    __m128i offset = _mm_and_si128(upper, _mm_set1_epi8(-'A'));
+    offset = _mm_blendv_epi8(offset, _mm_set1_epi8(26 - 'a'), lower);
+    offset = _mm_blendv_epi8(offset, _mm_set1_epi8(52 - '0'), digit);
+    offset = _mm_blendv_epi8(offset, _mm_set1_epi8(62 - '-'), dash);
+    offset = _mm_blendv_epi8(offset, _mm_set1_epi8(63 - '_'), underscore);
+    values = _mm_add_epi8(input, offset);
+    return true;
+}
+
+// 16 characters -> 12 bytes; writes 16 bytes, so the caller keeps 4 spare bytes of output room
+BASE64_TARGET("sse4.1")
+bool base64UrlDecodeBlockSSE41(const char* input, char* output) {
+    __m128i values;
+    if (!base64UrlValuesSSE41(_mm_loadu_si128(reinterpret_cast<const __m128i*>(input)), values)) {
+        return false;
+    }
+    // Merge sextet pairs into 12-bit words, then word pairs into 24-bit groups, then drop the spare byte
+    __m128i merged = _mm_maddubs_epi16(values, _mm_set1_epi32(0x01400140));
+    __m128i packed = _mm_madd_epi16(merged, _mm_set1_epi32(0x00011000));
+    packed = _mm_shuffle_epi8(packed, _mm_setr_epi8(2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(output), packed);
+    return true;
+}
+
+// 32 characters -> 24 bytes; writes 32 bytes, so the caller keeps 8 spare bytes of output room
+BASE64_TARGET("avx2")
+bool base64UrlDecodeBlockAVX2(const char* input, char* output) {
+    __m256i in = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(input));
+    __m256i upper = base64InRangeAVX2(in, 'A', 'Z');
+    __m256i lower = base64InRangeAVX2(in, 'a', 'z');
+    __m256i digit = base64InRangeAVX2(in, '0', '9');
+    __m256i dash = _mm256_cmpeq_epi8(in, _mm256_set1_epi8('-'));
+    __m256i underscore = _mm256_cmpeq_epi8(in, _mm256_set1_epi8('_'));
+
+    __m256i valid = _mm256_or_si256(_mm256_or_si256(upper, lower), _mm256_or_si256(_mm256_or_si256(digit, dash), underscore));
+    if (_mm256_movemask_epi8(valid) != -1) {
+        return false;
+    }
+
+    __m256i offset = _mm256_and_si256(upper, _mm256_set1_epi8(-'A'));
+    offset = _mm256_blendv_epi8(offset, _mm256_set1_epi8(26 - 'a'), lower);
+    offset = _mm256_blendv_epi8(offset, _mm256_set1_epi8(52 - '0'), digit);
+    offset = _mm256_blendv_epi8(offset, _mm256_set1_epi8(62 - '-'), dash);
+    offset = _mm256_blendv_epi8(offset, _mm256_set1_epi8(63 - '_'), underscore);
+    __m256i values = _mm256_add_epi8(in, offset);
+
+    __m256i merged = _mm256_maddubs_epi16(values, _mm256_set1_epi32(0x01400140));
+    __m256i packed = _mm256_madd_epi16(merged, _mm256_set1_epi32(0x00011000));
+    packed = _mm256_shuffle_epi8(packed, _mm256_setr_epi8(
+        2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1,
+        2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1));
+    // Each lane holds 12 bytes; close the gap between them
+    packed = _mm256_permutevar8x32_epi32(packed, _mm256_setr_epi32(0, 1, 2, 4, 5, 6, 7, 7));
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(output), packed);
+    return true;
+}
+#endif
+
+// Decodes with a specific kernel (scalar if the CPU lacks it); returns the number of bytes written,
+// or nullopt if the input contains a character outside the alphabet or has an impossible length
+std::optional<size_t> Base64UrlDecodeWith(Base64Kernel kernel, std::string_view encoded, char* output) {
+    // Accept padded input too
+    size_t length = encoded.size();
+    for (int pad = 0; pad < 2 && length > 0 && encoded[length - 1] == '='; ++pad) {
+        --length;
+    }
+    if (length % 4 == 1) {
+        return std::nullopt;
+    }
+
+    const char* input = encoded.data();
+    size_t i = 0;
+    size_t written = 0;
+
+#ifdef BASE64_X86_64
+    if (kernel > activeBase64Kernel()) {
+        kernel = activeBase64Kernel();
+    }
+    // Blocks store more bytes than they produce; only run them while the output has room for the overshoot
+    if (kernel == Base64Kernel::AVX2) {
+        for (; i + 32 + 12 <= length; i += 32, written += 24) {
+            if (!base64UrlDecodeBlockAVX2(input + i, output + written)) {
+                return std::nullopt;
+            }
+        }
+    }
+    if (kernel >= Base64Kernel::SSE41) {
+        for (; i + 16 + 8 <= length; i += 16, written += 12) {
+            if (!base64UrlDecodeBlockSSE41(input + i, output + written)) {
+                return std::nullopt;
+            }
+        }
+    }
+#endif
+
+    const auto& table = BASE64URL_DECODE_TABLE;
+    for (; i + 4 <= length; i += 4) {
+        int a = table[static_cast<unsigned char>(input[i])];
+        int b = table[static_cast<unsigned char>(input[i + 1])];
+        int c = table[static_cast<unsigned char>(input[i + 2])];
+        int d = table[static_cast<unsigned char>(input[i + 3])];
+        if ((a | b | c | d) < 0) {
+            return std::nullopt;
+        }
+        uint32_t n = (static_cast<uint32_t>(a) << 18) | (b << 12) | (c << 6) | d;
+        output[written++] = static_cast<char>(n >> 16);
+        output[written++] = static_cast<char>(n >> 8);
+        output[written++] = static_cast<char>(n);
+    }
+
+    // Unpadded tail: 2 characters carry one byte, 3 carry two
+    size_t remainder = length - i;
+    if (remainder >= 2) {
+        int a = table[static_cast<unsigned char>(input[i])];
+        int b = table[static_cast<unsigned char>(input[i + 1])];
+        int c = (remainder == 3) ? table[static_cast<unsigned char>(input[i + 2])] : 0;
+        if ((a | b | c) < 0) {
+            return std::nullopt;
+        }
+        uint32_t n = (static_cast<uint32_t>(a) << 18) | (b << 12) | (c << 6);
+        output[written++] = static_cast<char>(n >> 16);
+        if (remainder == 3) {
+            output[written++] = static_cast<char>(n >> 8);
+        }
+    }
+
+    return written;
+}
+
+std::optional<size_t> Base64UrlDecode(std::string_view encoded, char* output) {
+    return Base64UrlDecodeWith(activeBase64Kernel(), encoded, output);
+}
+
+// Unpadded base64url, the form used for the user segment of MessageIDs
+std::string Base64UrlEncode(std::string_view data) {
+    constexpr char alphabet[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789-_";
+    std::string encoded;
+    encoded.reserve((data.size() * 4 + 2) / 3);
+
+    size_t i = 0;
+    for (; i + 3 <= data.size(); i += 3) {
+        uint32_t n = (static_cast<uint32_t>(static_cast<unsigned char>(data[i])) << 16)
+            | (static_cast<unsigned char>(data[i + 1]) << 8) | static_cast<unsigned char>(data[i + 2]);
+        encoded += alphabet[(n >> 18) & 63];
+        encoded += alphabet[(n >> 12) & 63];
+        encoded += alphabet[(n >> 6) & 63];
+        encoded += alphabet[n & 63];
+    }
+    size_t remainder = data.size() - i;
+    if (remainder > 0) {
+        uint32_t n = static_cast<uint32_t>(static_cast<unsigned char>(data[i])) << 16;
+        if (remainder == 2) {
+            n |= static_cast<unsigned char>(data[i + 1]) << 8;
+        }
+        encoded += alphabet[(n >> 18) & 63];
+        encoded += alphabet[(n >> 12) & 63];
+        if (remainder == 2) {
+            encoded += alphabet[(n >> 6) & 63];
+        }
+    }
+    return encoded;
+}
+
+#endif // BASE64_H
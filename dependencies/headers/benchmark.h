@@ -0,0 +1,1428 @@
+#ifndef BENCHMARK_H
+#define BENCHMARK_H
+#include <iostream>
+#include <iomanip>
+#include <chrono>
+#include <cctype>
+#include <cmath>
+#include <filesystem>
+#include <string>
+#include <vector>
+#include <map>
+#include <unordered_set>
+#include <random>
+#include <sstream>
+#include <atomic>
+#include <thread>
+#include "syncFunc.h"
+#include "mockApi.h"
+#include "reportFunc.h"
+
+//---------------------------------------------------------------------------------------------------
+//------------------END-TO-END INGEST BENCHMARK------------------------------------------------------
+//---------------------------------------------------------------------------------------------------
+// Starts the mock API on a corpus, points the API base URL at it and syncs every user of the corpus
+// into an empty scratch database: /getid, then fetch/parse/store, the same path septim runs against
+// the real API. The database is deleted afterwards.
+// With a rate limit on the mock, the bodies it serves are sampled every half second, which shows
+// how the AIMD controller settles against the limit.
+struct IngestBenchmarkSettings {
+    size_t messages = 10000;                  // synthetic corpus size
+    size_t users = 10;
+    uint64_t seed = 1;
+    std::string replayCache;                  // non-empty: replay this response cache directory instead
+    MockApiSettings api;
+    PipelineOptions pipeline;
+    std::string databasePath = "septim_bench.db";
+};
+
+struct IngestBenchmarkResult {
+    size_t corpusSize = 0;
+    size_t users = 0;
+    size_t stored = 0;
+    size_t failed = 0;
+    double seconds = 0;           // all users, listing included
+    double ingestSeconds = 0;     // fetch/parse/store, overlapping the /getid stream
+    LatencyHistogram latency;     // successful /receive requests
+    double rateLimit = 0;         // the mock's maxRequestsPerSecond
+    std::vector<double> servedRates;   // /receive bodies per second, per half-second window
+    size_t peakConcurrency = 0;
+    size_t concurrencyCuts = 0;
+    HttpClient::Stats http;
+    MockApiServer::Stats server;
+
+    void print() const {
+        double rate = seconds > 0 ? stored / seconds : 0.0;
+        std::cout << std::fixed << std::setprecision(2)
+            << "Ingest benchmark: " << stored << " of " << corpusSize << " messages from " << users << " users in "
+            << seconds << " s (" << rate << " msg/s), outside the pipeline " << (seconds - ingestSeconds) << " s, ingest "
+            << ingestSeconds << " s, " << failed << " failed\n"
+            << "  /receive latency: p50 " << latency.percentileMs(50) << " ms, p90 " << latency.percentileMs(90)
+            << " ms, p99 " << latency.percentileMs(99) << " ms, max " << latency.maxMs() << " ms ("
+            << latency.samples() << " requests)\n"
+            << "  client: " << http.requests << " requests, " << http.connections << " new connections\n"
+            << "  mock API: " << server.requests << " requests, " << server.injectedErrors << " injected 500s, "
+            << server.throttled << " injected 429s, " << server.bytesSent / 1024 << " KiB sent" << std::endl;
+        if (rateLimit > 0) {
+            double settled = 0;   // windows after the first second
+            for (size_t i = 2; i < servedRates.size(); ++i) {
+                settled += servedRates[i];
+            }
+            settled = servedRates.size() > 2 ? settled / (servedRates.size() - 2) : 0.0;
+            std::cout << "  rate limit " << rateLimit << "/s: " << (seconds > 0 ? server.bodiesServed / seconds : 0.0)
+                << "/s served overall, " << settled << "/s after the first second (" << settled / rateLimit * 100
+                << "% of the limit), " << server.rateLimited << " rate-limited 429s; concurrency peak "
+                << peakConcurrency << ", " << concurrencyCuts << " cuts\n  served per half second (/s):";
+            for (double rate : servedRates) {
+                std::cout << " " << std::setprecision(0) << rate;
+            }
+            std::cout << std::endl;
+        }
+        std::cout.unsetf(std::ios::floatfield);
+        std::cout << std::setprecision(6);
+    }
+};
+
+void removeDatabaseFiles(const std::string& path) {
+    std::error_code error;
+    for (const char* suffix : { "", "-wal", "-shm", "-journal" }) {
+        std::filesystem::remove(path + suffix, error);
+    }
+}
+
+IngestBenchmarkResult runIngestBenchmark(const IngestBenchmarkSettings& settings) {
+    IngestBenchmarkResult result;
+
+    MockCorpus corpus;
+    if (!settings.replayCache.empty()) {
+        ResponseCache cache(settings.replayCache);
+        corpus = MockCorpus::fromCache(cache);
+    }
+    else {
+        corpus = MockCorpus::synthetic(settings.messages, settings.users, settings.seed);
+    }
+    result.corpusSize = corpus.size();
+    if (corpus.size() == 0) {
+        std::cerr << "Benchmark corpus is empty" << std::endl;
+        return result;
+    }
+
+    // Users in order of first appearance
+    std::vector<std::string> users;
+    std::unordered_set<std::string> seenUsers;
+    for (const auto& messageID : corpus.ids) {
+        auto view = MessageIdView::parse(messageID);
+        if (view.has_value() && seenUsers.insert(std::string(view->encodedUser)).second) {
+            users.push_back(view->decodeUser());
+        }
+    }
+    result.users = users.size();
+
+    MockApiServer server(std::move(corpus), settings.api);
+    if (!server.start()) {
+        return result;
+    }
+    std::string previousBaseUrl = apiBaseUrl();
+    setApiBaseUrl(server.baseUrl());
+
+    removeDatabaseFiles(settings.databasePath);
+    {
+        Database db(settings.databasePath, StorageProfile::Balanced);
+        // The tables a sync touches, as in septim.db
+        const char* schema =
+            "CREATE TABLE IF NOT EXISTS Settings (setting_id INTEGER PRIMARY KEY AUTOINCREMENT, user_id TEXT NOT NULL, "
+            "setting_name TEXT NOT NULL, setting_value TEXT NOT NULL);"
+            "CREATE TABLE IF NOT EXISTS Transactions (MessageID TEXT, UserID TEXT NOT NULL, CategoryID INTEGER NOT NULL, "
+            "Amount REAL NOT NULL, Message TEXT, Unix INTEGER NOT NULL, PRIMARY KEY(MessageID));";
+        if (db.isOpen() && sqlite3_exec(db, schema, nullptr, nullptr, nullptr) == SQLITE_OK && migrateSchema(db)) {
+            HttpClient client;
+            std::atomic<bool> done{ false };
+            std::thread sampler;
+            result.rateLimit = settings.api.maxRequestsPerSecond;
+            if (result.rateLimit > 0) {
+                sampler = std::thread([&] {
+                    size_t previous = 0;
+                    while (!done) {
+                        std::this_thread::sleep_for(std::chrono::milliseconds(500));
+                        size_t served = server.statistics().bodiesServed;
+                        result.servedRates.push_back((served - previous) * 2.0);
+                        previous = served;
+                    }
+                });
+            }
+            auto started = std::chrono::steady_clock::now();
+            for (const auto& userID : users) {
+                SyncResult sync = syncUser(db, userID, settings.pipeline, client);
+                result.stored += sync.stored;
+                result.failed += sync.failed;
+                result.ingestSeconds += sync.pipeline.elapsedSeconds;
+                result.latency.merge(sync.pipeline.concurrency.latency);
+                result.peakConcurrency = std::max(result.peakConcurrency, sync.pipeline.concurrency.peakLimit);
+                result.concurrencyCuts += sync.pipeline.concurrency.decreases;
+            }
+            result.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - started).count();
+            done = true;
+            if (sampler.joinable()) {
+                sampler.join();
+            }
+            result.http = client.stats();
+        }
+        else {
+            std::cerr << "Failed to prepare benchmark database " << settings.databasePath << std::endl;
+        }
+    }
+    removeDatabaseFiles(settings.databasePath);
+
+    setApiBaseUrl(previousBaseUrl);
+    server.stop();
+    result.server = server.statistics();
+    return result;
+}
+
+//---------------------------------------------------------------------------------------------------
+//------------------REPORT BENCHMARK: SQLITE VS COLUMNAR MIRROR--------------------------------------
+//---------------------------------------------------------------------------------------------------
+// Fills a scratch database with `rows` synthetic transactions (10 users, 8 categories, five years),
+// loads the columnar mirror and answers the same random per-user ranges both ways, checking that
+// the answers agree. The database is deleted afterwards.
+struct ReportBenchmarkSettings {
+    size_t rows = 1000000;
+    size_t users = 10;
+    size_t queries = 200;
+    size_t mutationRounds = 10;     // batches of random inserts and deletes applied after the timed queries
+    size_t mutationsPerRound = 2000;
+    uint64_t seed = 1;
+    std::string databasePath = "septim_report_bench.db";
+    std::string zoneDatabasePath = "septim_rollup_zones.db";   // rollup check under zones with DST at midnight
+};
+
+struct ReportBenchmarkResult {
+    size_t rows = 0;
+    double fillSeconds = 0;
+    double loadSeconds = 0;                // TransactionColumns::loadFromDatabase
+    size_t columnBytes = 0;
+    size_t queries = 0;
+    double sqliteRawMs = 0;                // per query: getReportTotalsRaw (covering index scan)
+    double sqliteRollupMs = 0;             // per query: getReportTotals (DailyTotals + partial days)
+    double columnarMs = 0;                 // per query: getReportTotalsScan over the mirror
+    double prefixMs = 0;                   // per query: getReportTotals over the mirror (daily prefix sums)
+    double sqliteAllUsersMs = 0;           // per query: getReport(db, first, last)
+    double columnarAllUsersMs = 0;
+    double sqliteGroupedMs = 0;            // per query: monthly, per category
+    double dashboardSeparateMs = 0;        // per dashboard: six getReportTotals calls
+    double dashboardBatchedMs = 0;         // per dashboard: one getReports call
+    double columnarGroupedMs = 0;
+    size_t mismatches = 0;
+    size_t mutationRounds = 0;
+    size_t mutationInserts = 0;
+    size_t mutationDeletes = 0;            // single rows, by MessageID
+    size_t mutationUserDeletes = 0;
+    size_t mutationQueries = 0;            // per round: prefix sums against the scan, SQLite raw and rollup
+    size_t mutationMismatches = 0;
+    size_t rollupZones = 0;                // the process zone, Beirut- and Santiago-style rules
+    size_t rollupZoneMismatches = 0;
+
+    void print() const {
+        std::cout << std::fixed << std::setprecision(3)
+            << "Report benchmark: " << rows << " rows (filled in " << fillSeconds << " s), mirror loaded in "
+            << loadSeconds << " s, " << columnBytes / (1024 * 1024) << " MiB\n"
+            << "  per-user range total:  SQLite raw " << sqliteRawMs << " ms, SQLite rollup " << sqliteRollupMs
+            << " ms, columnar scan " << columnarMs << " ms, prefix sums " << prefixMs << " ms\n"
+            << "  all-users range total: SQLite " << sqliteAllUsersMs << " ms, columnar " << columnarAllUsersMs << " ms\n"
+            << "  monthly by category:   SQLite " << sqliteGroupedMs << " ms, columnar " << columnarGroupedMs << " ms\n"
+            << "  dashboard, 6 ranges:   getReportTotals x6 " << dashboardSeparateMs << " ms, getReports "
+            << dashboardBatchedMs << " ms\n"
+            << "  " << queries << " queries each, " << mismatches << " mismatching answers\n"
+            << "  mutations: " << mutationRounds << " rounds, " << mutationInserts << " inserts, " << mutationDeletes
+            << " deletes, " << mutationUserDeletes << " user deletes, " << mutationQueries << " queries, "
+            << mutationMismatches << " mismatching answers\n"
+            << "  rollup day starts: " << rollupZones << " zones, " << rollupZoneMismatches << " mismatches" << std::endl;
+        std::cout.unsetf(std::ios::floatfield);
+        std::cout << std::setprecision(6);
+    }
+};
+
+// Yearly DST that switches at local midnight, as in Asia/Beirut and America/Santiago: the day the clocks
+// go forward starts at 01:00, which is where SQLite's 'localtime' day start and getStartOfDay() parted.
+// Transitions on the last (or first) Sunday of the two months, 2000..2039.
+TimeZoneTable midnightDstZone(int32_t standard, int32_t daylight, int startMonth, bool startOnLastSunday,
+    int endMonth, bool endOnLastSunday) {
+    auto sunday = [](int64_t year, int month, bool last) {
+        int64_t day = last ? daysFromCivil(month == 12 ? year + 1 : year, month == 12 ? 1 : month + 1, 1) - 1
+                           : daysFromCivil(year, month, 1);
+        int64_t weekday = day + 4 - floorDiv(day + 4, 7) * 7;   // 0 = Sunday; 1970-01-01 was a Thursday
+        return last ? day - weekday : day + (7 - weekday) % 7;
+    };
+    std::vector<TimeZoneTable::Transition> transitions;
+    for (int64_t year = 2000; year < 2040; ++year) {
+        // Local midnight under the offset in force just before the switch
+        transitions.push_back({ sunday(year, startMonth, startOnLastSunday) * TimeZoneTable::SECONDS_PER_DAY - standard, daylight });
+        transitions.push_back({ sunday(year, endMonth, endOnLastSunday) * TimeZoneTable::SECONDS_PER_DAY - daylight, standard });
+    }
+    std::sort(transitions.begin(), transitions.end(),
+        [](const auto& a, const auto& b) { return a.utcStart < b.utcStart; });
+    transitions.insert(transitions.begin(), { 0, transitions.front().offset == daylight ? standard : daylight });
+    return TimeZoneTable(std::move(transitions));
+}
+
+// Fills a fresh database under zone (nullptr: the process zone) with rows packed around every DST
+// switch and checks the rollup against the raw rows: each day_start must be a getStartOfDay()
+// boundary, and day-aligned and random ranges must give the raw answer. Returns the mismatches.
+size_t checkRollupZone(const std::string& databasePath, const TimeZoneTable* zone, uint64_t seed) {
+    TimeZoneTable::overrideLocal(zone);
+    size_t mismatches = 0;
+    removeDatabaseFiles(databasePath);
+    {
+        Database db(databasePath, StorageProfile::BulkLoad);
+        const char* schema =
+            "CREATE TABLE IF NOT EXISTS Transactions (MessageID TEXT, UserID TEXT NOT NULL, CategoryID INTEGER NOT NULL, "
+            "Amount REAL NOT NULL, Message TEXT, Unix INTEGER NOT NULL, PRIMARY KEY(MessageID));";
+        if (!db.isOpen() || sqlite3_exec(db, schema, nullptr, nullptr, nullptr) != SQLITE_OK || !migrateSchema(db)) {
+            std::cerr << "Failed to prepare rollup check database " << databasePath << std::endl;
+            TimeZoneTable::overrideLocal(nullptr);
+            return 1;
+        }
+
+        // Every 20 minutes for two days either side of each local day start where the offset changes
+        const int64_t first = daysFromCivil(2019, 1, 1) * TimeZoneTable::SECONDS_PER_DAY;
+        const int64_t last = daysFromCivil(2025, 1, 1) * TimeZoneTable::SECONDS_PER_DAY;
+        const TimeZoneTable& local = TimeZoneTable::local();
+        std::mt19937_64 random(seed);
+        std::vector<int64_t> switchDays;
+        std::vector<MessageData> rows;
+        for (int64_t day = local.startOfDay(first); day < last; day = local.nextBucketStart(day, TimeBucket::Day)) {
+            int64_t next = local.nextBucketStart(day, TimeBucket::Day);
+            bool switches = next - day != TimeZoneTable::SECONDS_PER_DAY;
+            if (switches) {
+                switchDays.push_back(day);
+            }
+            int64_t step = switches ? 1200 : 6 * 3600;
+            for (int64_t at = switches ? day - 2 * TimeZoneTable::SECONDS_PER_DAY : day; at < (switches ? next + 2 * TimeZoneTable::SECONDS_PER_DAY : next); at += step) {
+                MessageData data;
+                data.userID = random() % 2 == 0 ? "user1" : "user2";
+                data.unixTimestamp = at + static_cast<int64_t>(random() % static_cast<uint64_t>(step));
+                data.categoryID = static_cast<int>(random() % 4) + 1;
+                data.amount = static_cast<double>(static_cast<int64_t>(random() % 100000) - 50000) / 100.0;
+                data.messageID = "zone_" + std::to_string(rows.size());
+                rows.push_back(std::move(data));
+            }
+        }
+        addTransactions(db, rows);
+
+        {
+            Database::Statement stmt = db.prepare("SELECT DISTINCT day_start FROM DailyTotals;");
+            while (stmt && sqlite3_step(stmt) == SQLITE_ROW) {
+                time_t dayStart = static_cast<time_t>(sqlite3_column_int64(stmt, 0));
+                mismatches += getStartOfDay(dayStart) != dayStart;
+            }
+        }
+        mismatches += checkDailyTotals(db) != 0;
+
+        std::vector<std::pair<time_t, time_t>> ranges;
+        for (int64_t day : switchDays) {
+            for (int64_t days : { 1, 2, 7, 31 }) {
+                time_t start = getStartOfDay(static_cast<time_t>(day - TimeZoneTable::SECONDS_PER_DAY));
+                ranges.push_back({ start, static_cast<time_t>(day + days * TimeZoneTable::SECONDS_PER_DAY - 1) });
+                ranges.push_back({ static_cast<time_t>(day), static_cast<time_t>(day + days * TimeZoneTable::SECONDS_PER_DAY) });
+            }
+        }
+        for (size_t q = 0; q < 200; ++q) {
+            int64_t start = first + static_cast<int64_t>(random() % static_cast<uint64_t>(last - first));
+            ranges.push_back({ static_cast<time_t>(start), static_cast<time_t>(start + static_cast<int64_t>(random() % (90 * 86400))) });
+        }
+        auto differs = [](double a, double b) { return std::abs(a - b) > 1e-6 * std::max(1.0, std::abs(a)); };
+        for (const auto& [rangeFirst, rangeLast] : ranges) {
+            for (const char* user : { "user1", "user2" }) {
+                ReportTotals raw = getReportTotalsRaw(db, user, rangeFirst, rangeLast);
+                ReportTotals rollup = getReportTotals(db, user, rangeFirst, rangeLast);
+                mismatches += differs(raw.total, rollup.total) || raw.count != rollup.count;
+            }
+        }
+    }
+    removeDatabaseFiles(databasePath);
+    TimeZoneTable::overrideLocal(nullptr);
+    return mismatches;
+}
+
+ReportBenchmarkResult runReportBenchmark(const ReportBenchmarkSettings& settings) {
+    using Clock = std::chrono::steady_clock;
+    auto milliseconds = [](Clock::duration elapsed) { return std::chrono::duration<double, std::milli>(elapsed).count(); };
+    ReportBenchmarkResult result;
+    result.rows = settings.rows;
+    result.queries = settings.queries;
+
+    std::vector<std::string> users;
+    for (size_t u = 0; u < std::max<size_t>(settings.users, 1); ++u) {
+        users.push_back("user" + std::to_string(u + 1));
+    }
+    const int64_t firstTimestamp = 1577836800;   // 2020-01-01 00:00:00 UTC
+    const int64_t span = 5LL * 365 * 24 * 3600;
+
+    removeDatabaseFiles(settings.databasePath);
+    {
+        Database db(settings.databasePath, StorageProfile::BulkLoad);
+        const char* schema =
+            "CREATE TABLE IF NOT EXISTS Transactions (MessageID TEXT, UserID TEXT NOT NULL, CategoryID INTEGER NOT NULL, "
+            "Amount REAL NOT NULL, Message TEXT, Unix INTEGER NOT NULL, PRIMARY KEY(MessageID));";
+        if (!db.isOpen() || sqlite3_exec(db, schema, nullptr, nullptr, nullptr) != SQLITE_OK || !migrateSchema(db)) {
+            std::cerr << "Failed to prepare benchmark database " << settings.databasePath << std::endl;
+            return result;
+        }
+
+        // Rows in time order, as a sync stores them
+        std::mt19937_64 random(settings.seed);
+        auto fillStart = Clock::now();
+        const size_t batchSize = 50000;
+        std::vector<MessageData> batch;
+        batch.reserve(batchSize);
+        for (size_t i = 0; i < settings.rows; ++i) {
+            MessageData data;
+            data.userID = users[random() % users.size()];
+            data.unixTimestamp = firstTimestamp + static_cast<int64_t>(i * static_cast<uint64_t>(span) / settings.rows);
+            data.categoryID = static_cast<int>(random() % 8) + 1;
+            data.amount = static_cast<double>(static_cast<int64_t>(random() % 100000) - 50000) / 100.0;
+            char timestamp[16];
+            auto [timestampEnd, error] = std::to_chars(timestamp, timestamp + sizeof(timestamp), static_cast<uint64_t>(data.unixTimestamp), 16);
+            data.messageID = Base64UrlEncode(data.userID) + "_" + std::string(timestamp, timestampEnd) + "_" + std::to_string(i);
+            batch.push_back(std::move(data));
+            if (batch.size() == batchSize || i + 1 == settings.rows) {
+                addTransactions(db, batch);
+                batch.clear();
+            }
+        }
+        result.fillSeconds = std::chrono::duration<double>(Clock::now() - fillStart).count();
+
+        TransactionColumns columns;
+        auto loadStart = Clock::now();
+        columns.loadFromDatabase(db);
+        result.loadSeconds = std::chrono::duration<double>(Clock::now() - loadStart).count();
+        result.columnBytes = columns.memoryBytes();
+
+        // Ranges from a few hours to two years, anywhere in the five years
+        struct Query {
+            std::string user;
+            time_t first;
+            time_t last;
+        };
+        std::vector<Query> queries;
+        for (size_t q = 0; q < settings.queries; ++q) {
+            int64_t length = 3600 + static_cast<int64_t>(random() % static_cast<uint64_t>(2LL * 365 * 24 * 3600));
+            int64_t first = firstTimestamp + static_cast<int64_t>(random() % static_cast<uint64_t>(span - length));
+            queries.push_back({ users[random() % users.size()], static_cast<time_t>(first), static_cast<time_t>(first + length) });
+        }
+        auto differs = [](double a, double b) { return std::abs(a - b) > 1e-6 * std::max(1.0, std::abs(a)); };
+        double perQuery = static_cast<double>(std::max<size_t>(queries.size(), 1));
+
+        std::vector<ReportTotals> raw, rollup, columnar, prefix;
+        auto start = Clock::now();
+        for (const auto& query : queries) raw.push_back(getReportTotalsRaw(db, query.user, query.first, query.last));
+        result.sqliteRawMs = milliseconds(Clock::now() - start) / perQuery;
+        start = Clock::now();
+        for (const auto& query : queries) rollup.push_back(getReportTotals(db, query.user, query.first, query.last));
+        result.sqliteRollupMs = milliseconds(Clock::now() - start) / perQuery;
+        start = Clock::now();
+        for (const auto& query : queries) columnar.push_back(getReportTotalsScan(columns, query.user, query.first, query.last));
+        result.columnarMs = milliseconds(Clock::now() - start) / perQuery;
+        start = Clock::now();
+        for (const auto& query : queries) prefix.push_back(getReportTotals(columns, query.user, query.first, query.last));
+        result.prefixMs = milliseconds(Clock::now() - start) / perQuery;
+        for (size_t q = 0; q < queries.size(); ++q) {
+            if (differs(raw[q].total, columnar[q].total) || raw[q].count != columnar[q].count
+                || differs(rollup[q].total, columnar[q].total) || rollup[q].count != columnar[q].count
+                || differs(prefix[q].total, columnar[q].total) || prefix[q].count != columnar[q].count) {
+                ++result.mismatches;
+            }
+        }
+
+        std::vector<double> sqliteAll, columnarAll;
+        start = Clock::now();
+        for (const auto& query : queries) sqliteAll.push_back(getReport(db, query.first, query.last));
+        result.sqliteAllUsersMs = milliseconds(Clock::now() - start) / perQuery;
+        start = Clock::now();
+        for (const auto& query : queries) columnarAll.push_back(getReport(columns, query.first, query.last));
+        result.columnarAllUsersMs = milliseconds(Clock::now() - start) / perQuery;
+        for (size_t q = 0; q < queries.size(); ++q) {
+            if (differs(sqliteAll[q], columnarAll[q])) {
+                ++result.mismatches;
+            }
+        }
+
+        GroupBy monthly{ true, TimeBucket::Month };
+        std::vector<std::vector<ReportBucket>> sqliteGrouped, columnarGrouped;
+        start = Clock::now();
+        for (const auto& query : queries) sqliteGrouped.push_back(getGroupedReport(db, query.user, query.first, query.last, monthly));
+        result.sqliteGroupedMs = milliseconds(Clock::now() - start) / perQuery;
+        start = Clock::now();
+        for (const auto& query : queries) columnarGrouped.push_back(getGroupedReport(columns, query.user, query.first, query.last, monthly));
+        result.columnarGroupedMs = milliseconds(Clock::now() - start) / perQuery;
+        for (size_t q = 0; q < queries.size(); ++q) {
+            const auto& a = sqliteGrouped[q];
+            const auto& b = columnarGrouped[q];
+            bool same = a.size() == b.size();
+            for (size_t i = 0; same && i < a.size(); ++i) {
+                same = a[i].bucketStart == b[i].bucketStart && a[i].categoryID == b[i].categoryID
+                    && a[i].count == b[i].count && !differs(a[i].total, b[i].total);
+            }
+            if (!same) {
+                ++result.mismatches;
+            }
+        }
+
+        // Today, this week, this month, last month, year to date, last 30 days
+        std::vector<std::vector<ReportRange>> dashboards;
+        for (const auto& query : queries) {
+            time_t now = query.last;
+            time_t month = getStartOfMonth(now);
+            dashboards.push_back({ { getStartOfDay(now), now }, { getStartOfWeek(now), now }, { month, now },
+                { getStartOfMonth(month - 1), month - 1 }, { getStartOfYear(now), now }, { now - 30 * 86400, now } });
+        }
+        std::vector<std::vector<ReportTotals>> separate, batched;
+        start = Clock::now();
+        for (size_t q = 0; q < queries.size(); ++q) {
+            std::vector<ReportTotals>& answers = separate.emplace_back();
+            for (const auto& range : dashboards[q]) {
+                answers.push_back(getReportTotals(db, queries[q].user, range.first, range.last));
+            }
+        }
+        result.dashboardSeparateMs = milliseconds(Clock::now() - start) / perQuery;
+        start = Clock::now();
+        for (size_t q = 0; q < queries.size(); ++q) {
+            batched.push_back(getReports(db, queries[q].user, dashboards[q]));
+        }
+        result.dashboardBatchedMs = milliseconds(Clock::now() - start) / perQuery;
+        for (size_t q = 0; q < queries.size(); ++q) {
+            for (size_t r = 0; r < separate[q].size(); ++r) {
+                if (differs(separate[q][r].total, batched[q][r].total) || separate[q][r].count != batched[q][r].count) {
+                    ++result.mismatches;
+                }
+            }
+        }
+
+        // Mutations through the attached mirror, as the sync and the delete command apply them. Rows before and
+        // after the five years grow the prefix windows backwards and forwards, new users and categories create
+        // trees, rows in the middle take the merge path, and deletes go through eraseAt and eraseUser. Some
+        // MessageIDs carry a timestamp other than Unix, so erase has to fall back to its full search.
+        db.attachColumns(&columns);
+        const int64_t yearSeconds = 365LL * 24 * 3600;
+        int64_t windowFirst = firstTimestamp;
+        int64_t windowLast = firstTimestamp + span;
+        size_t nextUser = users.size();
+        std::vector<int64_t> outliers;
+        Database::Statement maxRowid = db.prepare("SELECT MAX(rowid) FROM Transactions;");
+        Database::Statement rowCount = db.prepare("SELECT COUNT(*) FROM Transactions;");
+        for (size_t round = 0; round < settings.mutationRounds; ++round) {
+            if (round % 3 == 1) {
+                users.push_back("user" + std::to_string(++nextUser));
+            }
+            std::vector<MessageData> inserts;
+            for (size_t i = 0; i < settings.mutationsPerRound; ++i) {
+                MessageData data;
+                data.userID = users[random() % users.size()];
+                int64_t placement = static_cast<int64_t>(random() % 4);
+                if (random() % 100 == 0) {
+                    // Garbage from the API: far future or before 1970, outside the indexed days
+                    data.unixTimestamp = random() % 2 == 0
+                        ? 1000000000000LL + static_cast<int64_t>(random() % static_cast<uint64_t>(yearSeconds))
+                        : -static_cast<int64_t>(random() % static_cast<uint64_t>(50 * yearSeconds)) - 1;
+                }
+                else if (placement == 0) {
+                    data.unixTimestamp = windowFirst - 1 - static_cast<int64_t>(random() % static_cast<uint64_t>(yearSeconds));
+                }
+                else if (placement == 1) {
+                    data.unixTimestamp = windowLast + 1 + static_cast<int64_t>(random() % static_cast<uint64_t>(yearSeconds));
+                }
+                else {
+                    data.unixTimestamp = windowFirst + static_cast<int64_t>(random() % static_cast<uint64_t>(windowLast - windowFirst));
+                }
+                data.categoryID = random() % 20 == 0 ? -1 : static_cast<int>(random() % (8 + round)) + 1;
+                data.amount = static_cast<double>(static_cast<int64_t>(random() % 100000) - 50000) / 100.0;
+                int64_t idTimestamp = random() % 10 == 0 ? data.unixTimestamp + 86400 : data.unixTimestamp;
+                char timestamp[16];
+                auto [timestampEnd, error] = std::to_chars(timestamp, timestamp + sizeof(timestamp), static_cast<uint64_t>(idTimestamp), 16);
+                data.messageID = Base64UrlEncode(data.userID) + "_" + std::string(timestamp, timestampEnd) + "_m"
+                    + std::to_string(round) + "_" + std::to_string(i);
+                inserts.push_back(std::move(data));
+            }
+            for (const MessageData& data : inserts) {
+                if (data.unixTimestamp >= 0 && data.unixTimestamp < 1000000000000LL) {
+                    windowFirst = std::min(windowFirst, data.unixTimestamp);
+                    windowLast = std::max(windowLast, data.unixTimestamp);
+                }
+                else {
+                    outliers.push_back(data.unixTimestamp);
+                }
+            }
+            result.mutationInserts += addTransactions(db, inserts).inserted;
+
+            // Deletes sample rowids, so they hit the original rows and the inserts of earlier rounds alike
+            int64_t rowidLimit = 0;
+            if (sqlite3_step(maxRowid) == SQLITE_ROW) {
+                rowidLimit = sqlite3_column_int64(maxRowid, 0);
+            }
+            sqlite3_reset(maxRowid);
+            std::vector<std::string> doomed;
+            Database::Statement pick = db.prepare("SELECT MessageID FROM Transactions WHERE rowid = ?;");
+            for (size_t i = 0; rowidLimit > 0 && i < settings.mutationsPerRound / 4; ++i) {
+                sqlite3_bind_int64(pick, 1, 1 + static_cast<int64_t>(random() % static_cast<uint64_t>(rowidLimit)));
+                if (sqlite3_step(pick) == SQLITE_ROW) {
+                    doomed.emplace_back(reinterpret_cast<const char*>(sqlite3_column_text(pick, 0)));
+                }
+                sqlite3_reset(pick);
+            }
+            // deleteRow's steps without its per-row message
+            Database::Statement remove = db.prepare("DELETE FROM Transactions WHERE MessageID = ?;");
+            for (const std::string& messageID : doomed) {
+                sqlite3_bind_text(remove, 1, messageID.c_str(), static_cast<int>(messageID.size()), SQLITE_STATIC);
+                if (sqlite3_step(remove) == SQLITE_DONE && sqlite3_changes(db) > 0) {
+                    ++result.mutationDeletes;
+                    if (!columns.erase(messageID)) {
+                        ++result.mutationMismatches;
+                    }
+                }
+                sqlite3_reset(remove);
+            }
+            if (round % 4 == 2) {
+                deleteRow(db, "Transactions", "UserID", users[random() % users.size()]);
+                ++result.mutationUserDeletes;
+            }
+
+            for (size_t q = 0; q < settings.queries; ++q) {
+                int64_t length = 3600 + static_cast<int64_t>(random() % static_cast<uint64_t>(2 * yearSeconds));
+                int64_t first = windowFirst - 86400 + static_cast<int64_t>(random() % static_cast<uint64_t>(windowLast - windowFirst + 86400));
+                if (q % 10 == 0 && !outliers.empty()) {
+                    // Around an outlier, or everything from before 1970 to past the far-future ones
+                    first = q % 20 == 0 ? outliers[random() % outliers.size()] - 3 * 86400 : -100 * yearSeconds;
+                    length = q % 20 == 0 ? 7 * 86400 : 1000000000000LL + 200 * yearSeconds;
+                }
+                const std::string& user = users[random() % users.size()];
+                std::optional<int> category;
+                if (random() % 4 == 0) {
+                    category = random() % 5 == 0 ? -1 : static_cast<int>(random() % (8 + round)) + 1;
+                }
+                time_t last = static_cast<time_t>(first + length);
+                ReportTotals scanned = getReportTotalsScan(columns, user, static_cast<time_t>(first), last, category);
+                ReportTotals summed = getReportTotals(columns, user, static_cast<time_t>(first), last, category);
+                ReportTotals sqliteRaw = getReportTotalsRaw(db, user, static_cast<time_t>(first), last, category);
+                ReportTotals sqliteRollup = getReportTotals(db, user, static_cast<time_t>(first), last, category);
+                if (differs(scanned.total, summed.total) || scanned.count != summed.count
+                    || differs(sqliteRaw.total, summed.total) || sqliteRaw.count != summed.count
+                    || differs(sqliteRollup.total, summed.total) || sqliteRollup.count != summed.count) {
+                    ++result.mutationMismatches;
+                }
+                ++result.mutationQueries;
+            }
+            if (sqlite3_step(rowCount) != SQLITE_ROW || static_cast<size_t>(sqlite3_column_int64(rowCount, 0)) != columns.size()) {
+                ++result.mutationMismatches;
+            }
+            sqlite3_reset(rowCount);
+            ++result.mutationRounds;
+        }
+        db.attachColumns(nullptr);
+    }
+    removeDatabaseFiles(settings.databasePath);
+
+    const TimeZoneTable beirut = midnightDstZone(2 * 3600, 3 * 3600, 3, true, 10, true);
+    const TimeZoneTable santiago = midnightDstZone(-4 * 3600, -3 * 3600, 9, false, 4, false);
+    for (const TimeZoneTable* zone : { static_cast<const TimeZoneTable*>(nullptr), &beirut, &santiago }) {
+        result.rollupZoneMismatches += checkRollupZone(settings.zoneDatabasePath, zone, settings.seed);
+        ++result.rollupZones;
+    }
+    return result;
+}
+
+//---------------------------------------------------------------------------------------------------
+//------------------CALENDAR BENCHMARK---------------------------------------------------------------
+//---------------------------------------------------------------------------------------------------
+// Day/week/month starts of random timestamps (2000..2035) the old way, localtime + mktime, against the
+// transition table (calendar.h), one call at a time and through the batch API on sorted and
+// unsorted input. Every answer of the table is checked against the C library.
+struct CalendarBenchmarkSettings {
+    size_t timestamps = 1000000;
+    uint64_t seed = 1;
+};
+
+struct CalendarBenchmarkResult {
+    size_t timestamps = 0;
+    size_t transitions = 0;
+    double tableBuildMs = 0;     // TimeZoneTable::probeLocal over 1970..2100
+    double libraryNs[3] = {};    // per timestamp, day/week/month: localtime + mktime
+    double tableNs[3] = {};      // per timestamp: bucketStart
+    double batchSortedNs[3] = {};
+    double batchUnsortedNs[3] = {};
+    size_t mismatches = 0;
+
+    void print() const {
+        const char* names[3] = { "day", "week", "month" };
+        std::cout << std::fixed << std::setprecision(1)
+            << "Calendar benchmark: " << timestamps << " timestamps, " << transitions << " transitions, table built in "
+            << tableBuildMs << " ms\n";
+        for (int b = 0; b < 3; ++b) {
+            std::cout << "  " << std::left << std::setw(6) << names[b] << std::right
+                << " localtime+mktime " << libraryNs[b] << " ns, table " << tableNs[b] << " ns, batch sorted "
+                << batchSortedNs[b] << " ns, batch unsorted " << batchUnsortedNs[b] << " ns per timestamp\n";
+        }
+        std::cout << "  " << mismatches << " answers differ from the C library" << std::endl;
+        std::cout.unsetf(std::ios::floatfield);
+        std::cout << std::setprecision(6);
+    }
+};
+
+// The boundaries as util.h computed them before the transition table
+time_t libraryBucketStart(time_t timestamp, TimeBucket bucket) {
+    std::optional<struct tm> timeInfo = TimeZoneTable::libraryLocalTime(timestamp);
+    if (!timeInfo.has_value()) {
+        return -1;
+    }
+    if (bucket == TimeBucket::Week) {
+        timeInfo->tm_mday -= (timeInfo->tm_wday + 6) % 7;
+    }
+    else if (bucket == TimeBucket::Month) {
+        timeInfo->tm_mday = 1;
+    }
+    timeInfo->tm_hour = timeInfo->tm_min = timeInfo->tm_sec = 0;
+    timeInfo->tm_isdst = -1;
+    return mktime(&*timeInfo);
+}
+
+CalendarBenchmarkResult runCalendarBenchmark(const CalendarBenchmarkSettings& settings) {
+    using Clock = std::chrono::steady_clock;
+    CalendarBenchmarkResult result;
+    result.timestamps = settings.timestamps;
+    const double count = static_cast<double>(std::max<size_t>(settings.timestamps, 1));
+    auto nanoseconds = [count](Clock::duration elapsed) { return std::chrono::duration<double, std::nano>(elapsed).count() / count; };
+
+    auto start = Clock::now();
+    TimeZoneTable table = TimeZoneTable::probeLocal(0, daysFromCivil(2100, 1, 1) * TimeZoneTable::SECONDS_PER_DAY);
+    result.tableBuildMs = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+    result.transitions = table.transitionCount();
+
+    std::mt19937_64 random(settings.seed);
+    std::uniform_int_distribution<int64_t> instant(946684800, 2082758400);   // 2000-01-01 .. 2036-01-01 UTC
+    std::vector<int64_t> unsorted(settings.timestamps);
+    for (int64_t& timestamp : unsorted) {
+        timestamp = instant(random);
+    }
+    std::vector<int64_t> sorted = unsorted;
+    std::sort(sorted.begin(), sorted.end());
+
+    const TimeBucket buckets[3] = { TimeBucket::Day, TimeBucket::Week, TimeBucket::Month };
+    std::vector<int64_t> expected(unsorted.size());
+    std::vector<int64_t> starts(unsorted.size());
+    for (int b = 0; b < 3; ++b) {
+        start = Clock::now();
+        for (size_t i = 0; i < unsorted.size(); ++i) {
+            expected[i] = libraryBucketStart(static_cast<time_t>(unsorted[i]), buckets[b]);
+        }
+        result.libraryNs[b] = nanoseconds(Clock::now() - start);
+
+        start = Clock::now();
+        for (size_t i = 0; i < unsorted.size(); ++i) {
+            starts[i] = table.bucketStart(unsorted[i], buckets[b]);
+        }
+        result.tableNs[b] = nanoseconds(Clock::now() - start);
+        for (size_t i = 0; i < unsorted.size(); ++i) {
+            result.mismatches += starts[i] != expected[i];
+        }
+
+        start = Clock::now();
+        table.bucketStarts(unsorted, buckets[b], starts);
+        result.batchUnsortedNs[b] = nanoseconds(Clock::now() - start);
+        for (size_t i = 0; i < unsorted.size(); ++i) {
+            result.mismatches += starts[i] != expected[i];
+        }
+
+        start = Clock::now();
+        table.bucketStarts(sorted, buckets[b], starts);
+        result.batchSortedNs[b] = nanoseconds(Clock::now() - start);
+        for (size_t i = 0; i < sorted.size(); i += 97) {
+            result.mismatches += starts[i] != libraryBucketStart(static_cast<time_t>(sorted[i]), buckets[b]);
+        }
+    }
+    return result;
+}
+
+//---------------------------------------------------------------------------------------------------
+//------------------DATE-TIME TEXT BENCHMARK---------------------------------------------------------
+//---------------------------------------------------------------------------------------------------
+// "dd-mm-yyyy HH:MM:SS" through the hand-rolled routines in util.h against the strftime/get_time code
+// they replaced: random timestamps (1970..2100) are formatted one by one and in both batch orders,
+// parsed back, and the canonical text is fuzzed with random edits. The only difference allowed is
+// the documented one: get_time accepts input that ends early and leaves the missing fields at zero.
+struct DateTimeBenchmarkSettings {
+    size_t timestamps = 1000000;
+    uint64_t seed = 1;
+};
+
+struct DateTimeBenchmarkResult {
+    size_t timestamps = 0;
+    double formatLibraryNs = 0;     // per timestamp: localtime + strftime
+    double formatNs = 0;            // formatLocalDateTime
+    double formatBatchNs = 0;       // formatLocalDateTimes over sorted timestamps
+    double parseLibraryNs = 0;      // istringstream + get_time
+    double parseFieldsNs = 0;       // parseDateTimeFields
+    double parseUnixNs = 0;         // parseLocalDateTime
+    size_t formatMismatches = 0;    // unixToString, including years past 9999
+    size_t batchMismatches = 0;     // formatLocalDateTimes, unsorted and sorted
+    size_t roundTripFailures = 0;   // parseLocalDateTime(text) is not an instant with that text
+    size_t edited = 0;
+    size_t parseMismatches = 0;
+    size_t truncatedAccepted = 0;   // accepted by get_time only because the input ended early
+    size_t mismatches = 0;
+
+    void print() const {
+        std::cout << std::fixed << std::setprecision(1)
+            << "Date-time benchmark: " << timestamps << " timestamps, " << edited << " edited strings\n"
+            << "  format: localtime+strftime " << formatLibraryNs << " ns, formatLocalDateTime " << formatNs
+            << " ns, sorted batch " << formatBatchNs << " ns\n"
+            << "  parse:  get_time " << parseLibraryNs << " ns, parseDateTimeFields " << parseFieldsNs
+            << " ns, parseLocalDateTime " << parseUnixNs << " ns\n"
+            << "  " << formatMismatches << " format, " << batchMismatches << " batch, " << roundTripFailures
+            << " round-trip and " << parseMismatches << " parse mismatches; " << truncatedAccepted
+            << " truncated strings accepted by get_time only" << std::endl;
+        std::cout.unsetf(std::ios::floatfield);
+        std::cout << std::setprecision(6);
+    }
+};
+
+// unixToString as it was before util.h formatted by hand
+std::string referenceUnixToString(time_t raw_time) {
+    std::optional<struct tm> timeInfo = TimeZoneTable::libraryLocalTime(raw_time);
+    if (!timeInfo) {
+        return {};
+    }
+    char buffer[80];
+    return std::string(buffer, strftime(buffer, sizeof(buffer), "%d-%m-%Y %H:%M:%S", &*timeInfo));
+}
+
+// optStringToStructTm as it was; endOfInput tells whether get_time ran out of text
+std::optional<struct tm> referenceParseDateTime(const std::string& text, bool& endOfInput) {
+    struct tm timeInfo = {};
+    std::istringstream stream(text);
+    stream >> std::get_time(&timeInfo, "%d-%m-%Y %H:%M:%S");
+    endOfInput = stream.eof();
+    if (stream.fail()) {
+        return std::nullopt;
+    }
+    return timeInfo;
+}
+
+bool sameDateTime(const struct tm& expected, const DateTimeFields& fields) {
+    return expected.tm_year + 1900 == fields.year && expected.tm_mon + 1 == fields.month && expected.tm_mday == fields.day
+        && expected.tm_hour == fields.hour && expected.tm_min == fields.minute && expected.tm_sec == fields.second;
+}
+
+DateTimeBenchmarkResult runDateTimeBenchmark(const DateTimeBenchmarkSettings& settings) {
+    using Clock = std::chrono::steady_clock;
+    DateTimeBenchmarkResult result;
+    result.timestamps = settings.timestamps;
+    const double count = static_cast<double>(std::max<size_t>(settings.timestamps, 1));
+    auto nanoseconds = [count](Clock::duration elapsed) { return std::chrono::duration<double, std::nano>(elapsed).count() / count; };
+
+    std::mt19937_64 random(settings.seed);
+    std::uniform_int_distribution<int64_t> instant(0, 4102444800);   // 1970-01-01 .. 2100-01-01 UTC
+    std::vector<time_t> timestamps(settings.timestamps);
+    for (time_t& timestamp : timestamps) {
+        timestamp = static_cast<time_t>(instant(random));
+    }
+
+    // One by one, and the batch in random order: the date part changes on almost every record
+    std::vector<std::string> texts;
+    texts.reserve(timestamps.size());
+    std::vector<char> records(timestamps.size() * DATE_TIME_LENGTH);
+    formatLocalDateTimes(timestamps, records);
+    for (size_t i = 0; i < timestamps.size(); ++i) {
+        std::string expected = referenceUnixToString(timestamps[i]);
+        result.formatMismatches += unixToString(timestamps[i]) != expected;
+        result.batchMismatches += std::string_view(records.data() + i * DATE_TIME_LENGTH, DATE_TIME_LENGTH) != expected;
+        // A repeated local hour names two instants; the parser picks the earlier, which prints the same
+        std::optional<time_t> back = parseLocalDateTime(expected);
+        result.roundTripFailures += !back || (*back != timestamps[i] && unixToString(*back) != expected);
+        texts.push_back(std::move(expected));
+    }
+    // Years past 9999 leave the fixed width and fall back to the C library
+    for (int64_t year : { 10000, 12345, 99999 }) {
+        time_t timestamp = static_cast<time_t>(daysFromCivil(year, 6, 15) * TimeZoneTable::SECONDS_PER_DAY);
+        result.formatMismatches += unixToString(timestamp) != referenceUnixToString(timestamp);
+    }
+
+    // Sorted, as listings and exports pass them: the date part is reused within a day
+    std::vector<time_t> sorted = timestamps;
+    std::sort(sorted.begin(), sorted.end());
+    formatLocalDateTimes(sorted, records);
+    for (size_t i = 0; i < sorted.size(); ++i) {
+        result.batchMismatches += std::string_view(records.data() + i * DATE_TIME_LENGTH, DATE_TIME_LENGTH)
+            != referenceUnixToString(sorted[i]);
+    }
+
+    // Zero to three edits (replace, delete, insert, truncate) of canonical text, so most strings are
+    // near misses of the format rather than noise
+    const char alphabet[] = "0123456789-: \t\nx+";
+    for (size_t i = 0; i < timestamps.size(); ++i) {
+        std::string text = texts[random() % texts.size()];
+        size_t edits = random() % 4;
+        for (size_t e = 0; e < edits; ++e) {
+            size_t kind = random() % 4;
+            size_t pos = random() % (text.size() + 1);
+            char c = alphabet[random() % (sizeof(alphabet) - 1)];
+            if (kind == 0 && pos < text.size()) {
+                text[pos] = c;
+            }
+            else if (kind == 1 && pos < text.size()) {
+                text.erase(pos, 1);
+            }
+            else if (kind == 2) {
+                text.insert(text.begin() + static_cast<std::ptrdiff_t>(pos), c);
+            }
+            else {
+                text.resize(pos);
+            }
+        }
+        ++result.edited;
+        bool endOfInput = false;
+        std::optional<struct tm> expected = referenceParseDateTime(text, endOfInput);
+        std::optional<DateTimeFields> fields = parseDateTimeFields(text);
+        if (expected && !fields && endOfInput) {
+            ++result.truncatedAccepted;
+        }
+        else if (expected.has_value() != fields.has_value() || (expected && !sameDateTime(*expected, *fields))) {
+            ++result.parseMismatches;
+        }
+    }
+
+    size_t checksum = 0;
+    auto start = Clock::now();
+    for (time_t timestamp : sorted) checksum += referenceUnixToString(timestamp).size();
+    result.formatLibraryNs = nanoseconds(Clock::now() - start);
+    char buffer[DATE_TIME_LENGTH];
+    start = Clock::now();
+    for (time_t timestamp : sorted) checksum += formatLocalDateTime(timestamp, buffer) + static_cast<size_t>(buffer[0]);
+    result.formatNs = nanoseconds(Clock::now() - start);
+    start = Clock::now();
+    checksum += formatLocalDateTimes(sorted, records);
+    result.formatBatchNs = nanoseconds(Clock::now() - start);
+
+    bool endOfInput = false;
+    start = Clock::now();
+    for (const std::string& text : texts) checksum += static_cast<size_t>(referenceParseDateTime(text, endOfInput)->tm_sec);
+    result.parseLibraryNs = nanoseconds(Clock::now() - start);
+    start = Clock::now();
+    for (const std::string& text : texts) checksum += static_cast<size_t>(parseDateTimeFields(text)->second);
+    result.parseFieldsNs = nanoseconds(Clock::now() - start);
+    start = Clock::now();
+    for (const std::string& text : texts) checksum += static_cast<size_t>(*parseLocalDateTime(text));
+    result.parseUnixNs = nanoseconds(Clock::now() - start);
+    result.mismatches = result.formatMismatches + result.batchMismatches + result.roundTripFailures + result.parseMismatches;
+    // Keeps the timed calls from being optimized away
+    if (checksum == 0) {
+        ++result.mismatches;
+    }
+    return result;
+}
+
+//---------------------------------------------------------------------------------------------------
+//------------------BASE64URL BENCHMARK--------------------------------------------------------------
+//---------------------------------------------------------------------------------------------------
+// Differential check and timing of base64.h: random payloads are encoded, optionally padded, and
+// decoded by the pre-SIMD decoder and by every kernel; all must give back the payload. Inputs with an
+// impossible length or a byte outside the alphabet must be rejected by every kernel (the old decoder
+// produced garbage for those, so it is not run on them).
+struct Base64BenchmarkSettings {
+    size_t inputs = 200000;
+    uint64_t seed = 1;
+};
+
+struct Base64BenchmarkResult {
+    static constexpr size_t KERNELS = 3;
+    size_t inputs = 0;
+    Base64Kernel active = Base64Kernel::Scalar;
+    // ns per encoded byte for user segments (10..16 chars) and 1 KiB strings
+    double referenceShortNs = 0;
+    double referenceLongNs = 0;
+    double shortNs[KERNELS] = {};
+    double longNs[KERNELS] = {};
+    size_t mismatches = 0;
+
+    void print() const {
+        std::cout << std::fixed << std::setprecision(2)
+            << "Base64url benchmark: " << inputs << " random inputs checked, CPU kernel " << base64KernelName(active) << "\n"
+            << "  reference  " << referenceShortNs << " ns/byte short, " << referenceLongNs << " ns/byte long\n";
+        for (size_t k = 0; k < KERNELS; ++k) {
+            Base64Kernel kernel = static_cast<Base64Kernel>(k);
+            std::cout << "  " << std::left << std::setw(10) << base64KernelName(kernel) << std::right << " "
+                << shortNs[k] << " ns/byte short, " << longNs[k] << " ns/byte long"
+                << (kernel > active ? " (not supported, ran as " + std::string(base64KernelName(active)) + ")" : "") << "\n";
+        }
+        std::cout << "  " << mismatches << " decodes differ from the payload" << std::endl;
+        std::cout.unsetf(std::ios::floatfield);
+        std::cout << std::setprecision(6);
+    }
+};
+
+// The decoder httpFunc.h had before base64.h; only defined for alphabet input of a possible length
+std::string referenceBase64Decode(const std::string& encoded) {
+    static const std::string base64Chars =
+        "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789-_";
+
+    std::string decoded;
+    std::vector<int> decodeTable(256, -1);
+
+    for (size_t i = 0; i < base64Chars.size(); ++i) {
+        decodeTable[base64Chars[i]] = static_cast<int>(i);
+    }
+
+    // Add padding only if necessary
+    std::string input = encoded;
+    size_t remainder = input.size() % 4;
+    if (remainder > 0) {
+        input.append(4 - remainder, '=');
+    }
+
+    for (size_t i = 0; i < input.size(); i += 4) {
+        int n = (decodeTable[input[i]] << 18) +
+            (decodeTable[input[i + 1]] << 12) +
+            ((i + 2 < input.size() && input[i + 2] != '=') ? (decodeTable[input[i + 2]] << 6) : 0) +
+            ((i + 3 < input.size() && input[i + 3] != '=') ? decodeTable[input[i + 3]] : 0);
+
+        decoded += static_cast<char>((n >> 16) & 0xFF);
+        if (i + 2 < input.size() && input[i + 2] != '=') {
+            decoded += static_cast<char>((n >> 8) & 0xFF);
+        }
+        if (i + 3 < input.size() && input[i + 3] != '=') {
+            decoded += static_cast<char>(n & 0xFF);
+        }
+    }
+    return decoded;
+}
+
+Base64BenchmarkResult runBase64Benchmark(const Base64BenchmarkSettings& settings) {
+    using Clock = std::chrono::steady_clock;
+    constexpr size_t KERNELS = Base64BenchmarkResult::KERNELS;
+    Base64BenchmarkResult result;
+    result.inputs = settings.inputs;
+    result.active = activeBase64Kernel();
+    std::mt19937_64 random(settings.seed);
+    std::uniform_int_distribution<int> byte(0, 255);
+
+    auto randomPayload = [&](size_t size) {
+        std::string payload(size, '\0');
+        for (char& c : payload) {
+            c = static_cast<char>(byte(random));
+        }
+        return payload;
+    };
+    auto padded = [](std::string encoded) {
+        encoded.append((4 - encoded.size() % 4) % 4, '=');
+        return encoded;
+    };
+
+    // Correctness: lengths 0..199 reach every kernel's block loop and every tail length
+    std::string output;
+    std::uniform_int_distribution<size_t> payloadSize(0, 150);
+    for (size_t n = 0; n < settings.inputs; ++n) {
+        std::string payload = randomPayload(payloadSize(random));
+        std::string encoded = Base64UrlEncode(payload);
+        if (n % 2 == 1) {
+            encoded = padded(std::move(encoded));
+        }
+        result.mismatches += referenceBase64Decode(encoded) != payload;
+        output.assign(Base64UrlMaxDecodedSize(encoded.size()), '\0');
+        for (size_t k = 0; k < KERNELS; ++k) {
+            auto written = Base64UrlDecodeWith(static_cast<Base64Kernel>(k), encoded, output.data());
+            result.mismatches += !written.has_value() || std::string_view(output.data(), *written) != payload;
+        }
+
+        // The same input with one byte outside the alphabet (other than padding), or cut to an impossible length
+        std::string invalid = Base64UrlEncode(payload);
+        if (!invalid.empty()) {
+            std::uniform_int_distribution<size_t> position(0, invalid.size() - 1);
+            char replacement;
+            do {
+                replacement = static_cast<char>(byte(random));
+            } while (BASE64URL_DECODE_TABLE[static_cast<unsigned char>(replacement)] >= 0 || replacement == '=');
+            invalid[position(random)] = replacement;
+        }
+        std::string truncated = Base64UrlEncode(payload);
+        truncated.resize(truncated.size() / 4 * 4 + 1);
+        for (size_t k = 0; k < KERNELS; ++k) {
+            output.assign(Base64UrlMaxDecodedSize(truncated.size()) + 1, '\0');
+            if (!invalid.empty()) {
+                result.mismatches += Base64UrlDecodeWith(static_cast<Base64Kernel>(k), invalid, output.data()).has_value();
+            }
+            result.mismatches += Base64UrlDecodeWith(static_cast<Base64Kernel>(k), truncated, output.data()).has_value();
+        }
+    }
+
+    // Timing: user segments of MessageIDs, and long strings where the block kernels dominate
+    std::uniform_int_distribution<size_t> userSize(7, 12);
+    std::vector<std::string> shortInputs(20000);
+    size_t shortBytes = 0;
+    for (std::string& input : shortInputs) {
+        input = Base64UrlEncode(randomPayload(userSize(random)));
+        shortBytes += input.size();
+    }
+    std::vector<std::string> longInputs(256);
+    size_t longBytes = 0;
+    for (std::string& input : longInputs) {
+        input = Base64UrlEncode(randomPayload(768));
+        longBytes += input.size();
+    }
+    constexpr int ROUNDS = 20;
+    size_t checksum = 0;
+    auto nanosecondsPerByte = [](Clock::duration elapsed, size_t bytes) {
+        return std::chrono::duration<double, std::nano>(elapsed).count() / static_cast<double>(bytes * ROUNDS);
+    };
+    auto timeReference = [&](const std::vector<std::string>& inputs, size_t bytes) {
+        auto start = Clock::now();
+        for (int round = 0; round < ROUNDS; ++round) {
+            for (const std::string& input : inputs) {
+                checksum += referenceBase64Decode(input).size();
+            }
+        }
+        return nanosecondsPerByte(Clock::now() - start, bytes);
+    };
+    auto timeKernel = [&](Base64Kernel kernel, const std::vector<std::string>& inputs, size_t bytes) {
+        char buffer[1024];
+        auto start = Clock::now();
+        for (int round = 0; round < ROUNDS; ++round) {
+            for (const std::string& input : inputs) {
+                checksum += Base64UrlDecodeWith(kernel, input, buffer).value_or(0);
+            }
+        }
+        return nanosecondsPerByte(Clock::now() - start, bytes);
+    };
+    result.referenceShortNs = timeReference(shortInputs, shortBytes);
+    result.referenceLongNs = timeReference(longInputs, longBytes);
+    for (size_t k = 0; k < KERNELS; ++k) {
+        result.shortNs[k] = timeKernel(static_cast<Base64Kernel>(k), shortInputs, shortBytes);
+        result.longNs[k] = timeKernel(static_cast<Base64Kernel>(k), longInputs, longBytes);
+    }
+    // Keeps the decodes from being optimized away
+    if (checksum == 0) {
+        ++result.mismatches;
+    }
+    return result;
+}
+
+//---------------------------------------------------------------------------------------------------
+//------------------MESSAGEID BENCHMARK--------------------------------------------------------------
+//---------------------------------------------------------------------------------------------------
+// Round trip of messageId.h over random IDs shaped like the API's, plus respellings of them (uppercase
+// hex, leading zeros in the timestamp) and over-long suffixes. Every ID must parse; a canonical one
+// must pack and come back unchanged from toString(), any other must be refused by pack().
+// KnownMessageIds then holds half of the IDs and must answer for every ID and respelling exactly as a
+// set of the strings would.
+struct MessageIdBenchmarkSettings {
+    size_t ids = 200000;
+    uint64_t seed = 1;
+};
+
+struct MessageIdBenchmarkResult {
+    size_t ids = 0;
+    size_t packed = 0;       // canonical IDs
+    size_t refused = 0;      // respelled or over-long IDs
+    size_t knownLookups = 0;
+    double parseNs = 0;      // per ID
+    double packNs = 0;
+    double toStringNs = 0;
+    size_t mismatches = 0;
+
+    void print() const {
+        std::cout << std::fixed << std::setprecision(1)
+            << "MessageID benchmark: " << ids << " ids, " << packed << " packed, " << refused << " refused\n"
+            << "  parse " << parseNs << " ns, pack " << packNs << " ns, toString " << toStringNs << " ns per id\n"
+            << "  " << mismatches << " ids do not round-trip or are misreported by KnownMessageIds ("
+            << knownLookups << " lookups)" << std::endl;
+        std::cout.unsetf(std::ios::floatfield);
+        std::cout << std::setprecision(6);
+    }
+};
+
+// base64url(user) _ hex timestamp _ hex suffix for 64 users; canonical unless respelled
+std::vector<std::string> makeBenchmarkMessageIds(size_t count, uint64_t seed, std::vector<bool>& canonical) {
+    std::mt19937_64 random(seed);
+    std::uniform_int_distribution<int> letter('a', 'z');
+    std::uniform_int_distribution<int> userLength(4, 12);
+    std::uniform_int_distribution<int64_t> instant(1500000000, 2000000000);
+    std::uniform_int_distribution<int> suffixLength(0, 20);
+    std::uniform_int_distribution<int> nibble(0, 15);
+    std::uniform_int_distribution<int> percent(0, 99);
+    constexpr char digits[] = "0123456789abcdef";
+
+    std::vector<std::string> users(64);
+    for (std::string& user : users) {
+        user.resize(static_cast<size_t>(userLength(random)));
+        for (char& c : user) {
+            c = static_cast<char>(letter(random));
+        }
+        user = Base64UrlEncode(user);
+    }
+    std::uniform_int_distribution<size_t> userIndex(0, users.size() - 1);
+
+    std::vector<std::string> ids;
+    ids.reserve(count);
+    canonical.assign(count, true);
+    for (size_t n = 0; n < count; ++n) {
+        const std::string& user = users[userIndex(random)];
+        char timestamp[16];
+        auto [timestampEnd, error] = std::to_chars(timestamp, timestamp + sizeof(timestamp), static_cast<uint64_t>(instant(random)), 16);
+        std::string timestampHex(timestamp, timestampEnd);
+        std::string suffix(static_cast<size_t>(suffixLength(random)), '\0');
+        for (char& c : suffix) {
+            c = digits[nibble(random)];
+        }
+
+        int respelling = percent(random);
+        if (respelling < 5) {
+            timestampHex.insert(0, "0");
+            canonical[n] = false;
+        }
+        else if (respelling < 10) {
+            for (char& c : timestampHex) {
+                c = static_cast<char>(std::toupper(static_cast<unsigned char>(c)));
+            }
+            canonical[n] = timestampHex.find_first_of("ABCDEF") == std::string::npos;
+        }
+        else if (respelling < 15) {
+            for (char& c : suffix) {
+                c = static_cast<char>(std::toupper(static_cast<unsigned char>(c)));
+            }
+            canonical[n] = suffix.find_first_of("ABCDEF") == std::string::npos;
+        }
+        canonical[n] = canonical[n] && suffix.size() <= PackedMessageId::MAX_RANDOM_DIGITS;
+        ids.push_back(user + "_" + timestampHex + "_" + suffix);
+    }
+    return ids;
+}
+
+MessageIdBenchmarkResult runMessageIdBenchmark(const MessageIdBenchmarkSettings& settings) {
+    using Clock = std::chrono::steady_clock;
+    MessageIdBenchmarkResult result;
+    result.ids = settings.ids;
+    const double count = static_cast<double>(std::max<size_t>(settings.ids, 1));
+    auto nanoseconds = [count](Clock::duration elapsed) { return std::chrono::duration<double, std::nano>(elapsed).count() / count; };
+
+    std::vector<bool> canonical;
+    std::vector<std::string> ids = makeBenchmarkMessageIds(settings.ids, settings.seed, canonical);
+
+    auto start = Clock::now();
+    std::vector<std::optional<MessageIdView>> views(ids.size());
+    for (size_t i = 0; i < ids.size(); ++i) {
+        views[i] = MessageIdView::parse(ids[i]);
+    }
+    result.parseNs = nanoseconds(Clock::now() - start);
+
+    UserInterner users;
+    std::vector<std::optional<PackedMessageId>> packed(ids.size());
+    start = Clock::now();
+    for (size_t i = 0; i < ids.size(); ++i) {
+        if (views[i].has_value()) {
+            packed[i] = PackedMessageId::pack(*views[i], users);
+        }
+    }
+    result.packNs = nanoseconds(Clock::now() - start);
+
+    std::vector<std::string> strings(ids.size());
+    start = Clock::now();
+    for (size_t i = 0; i < ids.size(); ++i) {
+        if (packed[i].has_value()) {
+            strings[i] = packed[i]->toString(users);
+        }
+    }
+    result.toStringNs = nanoseconds(Clock::now() - start);
+
+    for (size_t i = 0; i < ids.size(); ++i) {
+        if (!views[i].has_value()) {
+            ++result.mismatches;
+            continue;
+        }
+        if (packed[i].has_value() != canonical[i]) {
+            ++result.mismatches;
+            continue;
+        }
+        if (packed[i].has_value()) {
+            ++result.packed;
+            result.mismatches += strings[i] != ids[i];
+            // The lookup form must find the same key
+            auto lookup = PackedMessageId::pack(*views[i], static_cast<const UserInterner&>(users));
+            result.mismatches += lookup != packed[i];
+        }
+        else {
+            ++result.refused;
+        }
+    }
+
+    KnownMessageIds known;
+    std::unordered_set<std::string> expected;
+    for (size_t i = 0; i < ids.size(); i += 2) {
+        result.mismatches += known.add(ids[i]) != expected.insert(ids[i]).second;
+    }
+    auto check = [&](const std::string& messageID) {
+        ++result.knownLookups;
+        result.mismatches += known.contains(messageID) != (expected.count(messageID) > 0);
+    };
+    for (const std::string& messageID : ids) {
+        check(messageID);
+        size_t separator = messageID.rfind('_', messageID.rfind('_') - 1);
+        check(messageID.substr(0, separator + 1) + "0" + messageID.substr(separator + 1));
+        std::string upper = messageID;
+        for (size_t c = separator + 1; c < upper.size(); ++c) {
+            upper[c] = static_cast<char>(std::toupper(static_cast<unsigned char>(upper[c])));
+        }
+        check(upper);
+    }
+    return result;
+}
+
+//---------------------------------------------------------------------------------------------------
+//------------------/receive DECODER BENCHMARK-------------------------------------------------------
+//---------------------------------------------------------------------------------------------------
+// The typed decoder (MessageData::TryDecode) against the nlohmann DOM path (parse + FromJSON) on a
+// synthetic corpus: time and heap allocations per body. Both must give identical MessageData, also
+// on messages with escapes and non-ASCII text, pretty-printed bodies and unknown keys; every
+// truncated body must be refused by the typed decoder.
+
+// Allocations are counted without touching the global operator new: the DOM is rebuilt as a basic_json
+// whose allocator counts (tree nodes, object and array storage, string contents), and the typed
+// decoder only allocates when a string field of its reused MessageData has to grow. nlohmann's parser
+// keeps a few internal stacks on std::allocator; those are not counted, so the DOM figure is a floor.
+thread_local size_t countedAllocations = 0;
+
+template <typename T>
+struct CountingAllocator {
+    using value_type = T;
+
+    CountingAllocator() = default;
+    template <typename U>
+    CountingAllocator(const CountingAllocator<U>&) noexcept {}
+
+    T* allocate(std::size_t n) {
+        ++countedAllocations;
+        return std::allocator<T>().allocate(n);
+    }
+    void deallocate(T* memory, std::size_t n) noexcept {
+        std::allocator<T>().deallocate(memory, n);
+    }
+
+    template <typename U>
+    bool operator==(const CountingAllocator<U>&) const noexcept { return true; }
+};
+
+using CountedString = std::basic_string<char, std::char_traits<char>, CountingAllocator<char>>;
+using CountedJson = nlohmann::basic_json<std::map, std::vector, CountedString, bool, std::int64_t, std::uint64_t, double,
+    CountingAllocator>;
+
+// Allocations of MessageData::FromJSON(nlohmann::json::parse(body)): the DOM, plus the three
+// get<std::string>() copies that outgrow the small-string buffer of a fresh MessageData
+size_t countDomAllocations(const std::string& body) {
+    countedAllocations = 0;
+    CountedJson json = CountedJson::parse(body);
+    const CountedJson& item = json.at("Item");
+    const size_t inlineCapacity = std::string().capacity();
+    size_t copies = 0;
+    for (const char* key : { "UserID", "Message", "MessageID" }) {
+        copies += item.at(key).get_ref<const CountedString&>().size() > inlineCapacity;
+    }
+    return countedAllocations + copies;
+}
+
+// Allocations of MessageData::TryDecode into a reused struct: one per string field that had to grow
+size_t countTypedAllocations(std::string_view body, MessageData& data) {
+    const size_t capacities[3] = { data.userID.capacity(), data.message.capacity(), data.messageID.capacity() };
+    MessageData::TryDecode(body, data);
+    return (data.userID.capacity() != capacities[0]) + (data.message.capacity() != capacities[1])
+        + (data.messageID.capacity() != capacities[2]);
+}
+
+struct DecoderBenchmarkSettings {
+    size_t messages = 100000;
+    uint64_t seed = 1;
+};
+
+struct DecoderBenchmarkResult {
+    size_t bodies = 0;
+    double averageBodyBytes = 0;
+    double typedNs = 0;          // per body
+    double domNs = 0;
+    double typedAllocations = 0; // per body
+    double domAllocations = 0;   // a floor: nlohmann's parser stacks are not counted
+    size_t mismatches = 0;
+
+    void print() const {
+        std::cout << std::fixed << std::setprecision(1)
+            << "Decoder benchmark: " << bodies << " /receive bodies of " << averageBodyBytes << " bytes on average\n"
+            << "  typed decoder " << typedNs << " ns, " << typedAllocations << " allocations per body\n"
+            << "  nlohmann DOM  " << domNs << " ns, at least " << domAllocations << " allocations per body\n"
+            << "  " << mismatches << " bodies decoded differently" << std::endl;
+        std::cout.unsetf(std::ios::floatfield);
+        std::cout << std::setprecision(6);
+    }
+};
+
+bool sameMessageData(const MessageData& a, const MessageData& b) {
+    return a.userID == b.userID && a.message == b.message && a.categoryID == b.categoryID
+        && a.amount == b.amount && a.messageID == b.messageID && a.unixTimestamp == b.unixTimestamp;
+}
+
+DecoderBenchmarkResult runDecoderBenchmark(const DecoderBenchmarkSettings& settings) {
+    using Clock = std::chrono::steady_clock;
+    DecoderBenchmarkResult result;
+    MockCorpus corpus = MockCorpus::synthetic(settings.messages, 10, settings.seed);
+    std::vector<std::string> bodies;
+    bodies.reserve(corpus.size());
+    size_t bytes = 0;
+    for (const auto& messageID : corpus.ids) {
+        bodies.push_back(corpus.bodies.at(messageID));
+        bytes += bodies.back().size();
+    }
+    result.bodies = bodies.size();
+    result.averageBodyBytes = bodies.empty() ? 0 : static_cast<double>(bytes) / bodies.size();
+    const double count = static_cast<double>(std::max<size_t>(bodies.size(), 1));
+
+    // Timing: decode into one reused struct per path, as the pipeline's parse stage does
+    MessageData typed;
+    auto start = Clock::now();
+    for (const std::string& body : bodies) {
+        result.mismatches += !MessageData::TryDecode(body, typed);
+    }
+    result.typedNs = std::chrono::duration<double, std::nano>(Clock::now() - start).count() / count;
+
+    MessageData dom;
+    start = Clock::now();
+    for (const std::string& body : bodies) {
+        dom = MessageData::FromJSON(nlohmann::json::parse(body));
+    }
+    result.domNs = std::chrono::duration<double, std::nano>(Clock::now() - start).count() / count;
+
+    // Allocations in a separate pass, so counting does not weigh on the timings
+    MessageData reused;
+    size_t typedAllocations = 0;
+    size_t domAllocations = 0;
+    for (const std::string& body : bodies) {
+        typedAllocations += countTypedAllocations(body, reused);
+        domAllocations += countDomAllocations(body);
+    }
+    result.typedAllocations = typedAllocations / count;
+    result.domAllocations = domAllocations / count;
+
+    // Equality on the corpus plus shapes the synthetic corpus does not produce
+    std::mt19937_64 random(settings.seed);
+    const char* messages[] = { "quote \" and backslash \\", "tab\tnewline\ncontrol \x01", "UTF-8: \xD0\x9F\xD1\x80\xD0\xB8\xD0\xB2\xD1\x96\xD1\x82 \xE2\x82\xAC \xF0\x9F\x98\x80", "" };
+    std::vector<std::string> checked = bodies;
+    for (size_t i = 0; i < std::min<size_t>(bodies.size(), 1000); ++i) {
+        nlohmann::json json = nlohmann::json::parse(bodies[i]);
+        json["Item"]["Message"] = messages[random() % std::size(messages)];
+        json["Item"]["Amount"] = static_cast<double>(static_cast<int64_t>(random())) / 1e7;
+        json["Item"]["Extra"] = { { "nested", { 1, 2.5e-3, nullptr, "\\u00e9" } } };
+        json["ResponseMetadata"] = { { "RequestId", "x" } };
+        checked.push_back(json.dump(i % 2 == 0 ? -1 : 2, ' ', i % 3 == 0));
+    }
+    for (const std::string& body : checked) {
+        MessageData reference = MessageData::FromJSON(nlohmann::json::parse(body));
+        result.mismatches += !MessageData::TryDecode(body, typed) || !sameMessageData(typed, reference);
+        std::string truncated = body.substr(0, random() % body.size());
+        result.mismatches += MessageData::TryDecode(truncated, typed);
+    }
+    return result;
+}
+
+#endif // BENCHMARK_H
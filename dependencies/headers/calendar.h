@@ -0,0 +1,289 @@
+#ifndef CALENDAR_H
+#define CALENDAR_H
+#include <algorithm>
+#include <cstdint>
+#include <ctime>
+#include <optional>
+#include <span>
+#include <vector>
+
+enum class TimeBucket {
+    None,
+    Day,
+    Week,
+    Month
+};
+
+//---------------------------------------------------------------------------------------------------
+//------------------CIVIL DATES----------------------------------------------------------------------
+//---------------------------------------------------------------------------------------------------
+// Proleptic Gregorian calendar in days since 1970-01-01, integer arithmetic only
+struct CivilDate {
+    int64_t year = 1970;
+    int month = 1;   // 1..12
+    int day = 1;     // 1..31
+};
+
+int64_t floorDiv(int64_t value, int64_t divisor) {
+    int64_t quotient = value / divisor;
+    return (value % divisor != 0 && (value < 0) != (divisor < 0)) ? quotient - 1 : quotient;
+}
+
+int64_t daysFromCivil(int64_t year, int month, int day) {
+    year -= month <= 2;
+    int64_t era = floorDiv(year, 400);
+    int64_t yearOfEra = year - era * 400;                                          // 0..399
+    int64_t dayOfYear = (153 * (month + (month > 2 ? -3 : 9)) + 2) / 5 + day - 1;  // 0..365, from March 1
+    int64_t dayOfEra = yearOfEra * 365 + yearOfEra / 4 - yearOfEra / 100 + dayOfYear;
+    return era * 146097 + dayOfEra - 719468;
+}
+
+CivilDate civilFromDays(int64_t days) {
+    days += 719468;
+    int64_t era = floorDiv(days, 146097);
+    int64_t dayOfEra = days - era * 146097;                                               // 0..146096
+    int64_t yearOfEra = (dayOfEra - dayOfEra / 1460 + dayOfEra / 36524 - dayOfEra / 146096) / 365;
+    int64_t dayOfYear = dayOfEra - (365 * yearOfEra + yearOfEra / 4 - yearOfEra / 100);  // from March 1
+    int64_t monthIndex = (5 * dayOfYear + 2) / 153;                                        // 0 = March
+    CivilDate date;
+    date.day = static_cast<int>(dayOfYear - (153 * monthIndex + 2) / 5 + 1);
+    date.month = static_cast<int>(monthIndex < 10 ? monthIndex + 3 : monthIndex - 9);
+    date.year = yearOfEra + era * 400 + (date.month <= 2);
+    return date;
+}
+
+//---------------------------------------------------------------------------------------------------
+//------------------TIME ZONE TRANSITION TABLE-------------------------------------------------------
+//---------------------------------------------------------------------------------------------------
+// A zone as a sorted list of (UTC instant, UTC offset) transitions. Day, week and month starts are a
+// binary search for the offset plus civil-date arithmetic; no localtime/mktime call, no global lock,
+// and the table is immutable once built, so it can be shared between threads.
+// local() probes the C library once for the process zone. Outside the probed years the nearest
+// known offset is used.
+// Where local midnight does not exist (a DST gap at 00:00) the day starts at the transition; where
+// it exists twice the earlier instant is taken.
+class TimeZoneTable {
+public:
+    static constexpr int64_t SECONDS_PER_DAY = 86400;
+
+    struct Transition {
+        int64_t utcStart = 0;   // first instant the offset applies
+        int32_t offset = 0;     // local minus UTC, seconds
+    };
+
+    // transitions sorted by utcStart; an empty list is UTC
+    explicit TimeZoneTable(std::vector<Transition> transitions = {}) {
+        if (transitions.empty()) {
+            transitions.push_back({ 0, 0 });
+        }
+        for (const Transition& transition : transitions) {
+            utcStarts.push_back(transition.utcStart);
+            localStarts.push_back(transition.utcStart + transition.offset);
+            offsets.push_back(transition.offset);
+        }
+    }
+
+    // Samples the C library zone once a day over [from, to) and pins every change of offset to the
+    // second by bisection. A change that reverts within the same day would be missed; no zone does that.
+    static TimeZoneTable probeLocal(int64_t from, int64_t to) {
+        std::optional<int32_t> first = probeOffset(from);
+        if (!first.has_value()) {
+            return TimeZoneTable();
+        }
+        std::vector<Transition> transitions{ { from, *first } };
+        int32_t previous = *first;
+        for (int64_t sample = from + SECONDS_PER_DAY; sample < to; sample += SECONDS_PER_DAY) {
+            std::optional<int32_t> offset = probeOffset(sample);
+            if (!offset.has_value()) {
+                break;
+            }
+            int64_t known = sample - SECONDS_PER_DAY;   // last second known to have `previous`
+            while (*offset != previous) {
+                int64_t low = known;
+                int64_t high = sample;
+                while (high - low > 1) {
+                    int64_t middle = low + (high - low) / 2;
+                    if (probeOffset(middle) == previous) {
+                        low = middle;
+                    }
+                    else {
+                        high = middle;
+                    }
+                }
+                previous = probeOffset(high).value_or(*offset);
+                transitions.push_back({ high, previous });
+                known = high;
+            }
+        }
+        return TimeZoneTable(std::move(transitions));
+    }
+
+    // The process zone, probed on first use over 1970..2100, unless overrideLocal() replaced it
+    static const TimeZoneTable& local() {
+        if (const TimeZoneTable* zone = localOverride()) {
+            return *zone;
+        }
+        static const TimeZoneTable table = probeLocal(0, daysFromCivil(2100, 1, 1) * SECONDS_PER_DAY);
+        return table;
+    }
+
+    // Makes local() answer with zone (nullptr restores the process zone), so checks can run the report
+    // and rollup code under other rules without changing TZ. zone must outlive its use; not synchronized
+    // with other threads reading local().
+    static void overrideLocal(const TimeZoneTable* zone) {
+        localOverride() = zone;
+    }
+
+    int32_t offsetAt(int64_t utc) const {
+        return offsets[entryAt(utcStarts, utc)];
+    }
+
+    int64_t toLocal(int64_t utc) const {
+        return utc + offsetAt(utc);
+    }
+
+    // Local wall-clock seconds (as if UTC) to the instant they name; see the class comment for gaps and overlaps
+    int64_t toUtc(int64_t local) const {
+        size_t i = entryAt(localStarts, local);
+        if (i > 0 && local < utcStarts[i] + offsets[i - 1]) {
+            return local - offsets[i - 1];   // repeated hour: the earlier instant
+        }
+        if (i + 1 < utcStarts.size() && local - offsets[i] >= utcStarts[i + 1]) {
+            return utcStarts[i + 1];         // skipped hour: the first instant after it
+        }
+        return local - offsets[i];
+    }
+
+    int64_t startOfDay(int64_t utc) const {
+        return toUtc(localDay(utc) * SECONDS_PER_DAY);
+    }
+
+    // Weeks start on Monday
+    int64_t startOfWeek(int64_t utc) const {
+        return toUtc(weekStartDay(localDay(utc)) * SECONDS_PER_DAY);
+    }
+
+    int64_t startOfMonth(int64_t utc) const {
+        CivilDate date = civilFromDays(localDay(utc));
+        return toUtc(daysFromCivil(date.year, date.month, 1) * SECONDS_PER_DAY);
+    }
+
+    int64_t startOfYear(int64_t utc) const {
+        CivilDate date = civilFromDays(localDay(utc));
+        return toUtc(daysFromCivil(date.year, 1, 1) * SECONDS_PER_DAY);
+    }
+
+    int64_t bucketStart(int64_t utc, TimeBucket bucket) const {
+        switch (bucket) {
+        case TimeBucket::Day: return startOfDay(utc);
+        case TimeBucket::Week: return startOfWeek(utc);
+        case TimeBucket::Month: return startOfMonth(utc);
+        default: return utc;
+        }
+    }
+
+    // Start of the bucket after the one holding utc
+    int64_t nextBucketStart(int64_t utc, TimeBucket bucket) const {
+        int64_t day = localDay(utc);
+        switch (bucket) {
+        case TimeBucket::Day: return toUtc((day + 1) * SECONDS_PER_DAY);
+        case TimeBucket::Week: return toUtc((weekStartDay(day) + 7) * SECONDS_PER_DAY);
+        case TimeBucket::Month: {
+            CivilDate date = civilFromDays(day);
+            int64_t next = date.month == 12 ? daysFromCivil(date.year + 1, 1, 1) : daysFromCivil(date.year, date.month + 1, 1);
+            return toUtc(next * SECONDS_PER_DAY);
+        }
+        default: return utc;
+        }
+    }
+
+    // starts[i] = bucketStart(timestamps[i], bucket). The current bucket's bounds are kept, so runs of
+    // timestamps in the same bucket (any sorted input) cost a comparison each.
+    void bucketStarts(std::span<const int64_t> timestamps, TimeBucket bucket, std::span<int64_t> starts) const {
+        if (bucket == TimeBucket::None) {
+            std::copy(timestamps.begin(), timestamps.end(), starts.begin());
+            return;
+        }
+        int64_t currentStart = 0;
+        int64_t currentEnd = 0;   // exclusive; empty until the first timestamp
+        for (size_t i = 0; i < timestamps.size(); ++i) {
+            int64_t utc = timestamps[i];
+            if (utc < currentStart || utc >= currentEnd) {
+                currentStart = bucketStart(utc, bucket);
+                currentEnd = nextBucketStart(utc, bucket);
+            }
+            starts[i] = currentStart;
+        }
+    }
+
+    size_t transitionCount() const { return utcStarts.size(); }
+
+    // FNV-1a over the transitions: equal for equal zone rules, stable across runs and machines
+    uint64_t fingerprint() const {
+        uint64_t hash = 0xCBF29CE484222325ULL;
+        auto mix = [&hash](int64_t value) {
+            for (int byte = 0; byte < 8; ++byte) {
+                hash ^= static_cast<uint64_t>(value >> (byte * 8)) & 0xFF;
+                hash *= 0x100000001B3ULL;
+            }
+        };
+        for (size_t i = 0; i < utcStarts.size(); ++i) {
+            mix(utcStarts[i]);
+            mix(offsets[i]);
+        }
+        return hash;
+    }
+
+    // localtime_s on Windows, localtime_r elsewhere
+    static std::optional<struct tm> libraryLocalTime(time_t timestamp) {
+        struct tm timeInfo;
+#ifdef _WIN32
+        if (localtime_s(&timeInfo, &timestamp) != 0) {
+            return std::nullopt;
+        }
+#else
+        if (localtime_r(&timestamp, &timeInfo) == nullptr) {
+            return std::nullopt;
+        }
+#endif
+        return timeInfo;
+    }
+
+private:
+    // Index of the last entry starting at or before value; entry 0 also covers everything before it
+    static size_t entryAt(const std::vector<int64_t>& starts, int64_t value) {
+        size_t i = static_cast<size_t>(std::upper_bound(starts.begin(), starts.end(), value) - starts.begin());
+        return i > 0 ? i - 1 : 0;
+    }
+
+    int64_t localDay(int64_t utc) const {
+        return floorDiv(toLocal(utc), SECONDS_PER_DAY);
+    }
+
+    static const TimeZoneTable*& localOverride() {
+        static const TimeZoneTable* zone = nullptr;
+        return zone;
+    }
+
+    // 1970-01-01 was a Thursday
+    static int64_t weekStartDay(int64_t day) {
+        return day - (day + 3 - floorDiv(day + 3, 7) * 7);
+    }
+
+    // Offset the C library gives for one instant
+    static std::optional<int32_t> probeOffset(int64_t utc) {
+        std::optional<struct tm> timeInfo = libraryLocalTime(static_cast<time_t>(utc));
+        if (!timeInfo.has_value()) {
+            return std::nullopt;
+        }
+        int64_t local = daysFromCivil(timeInfo->tm_year + 1900, timeInfo->tm_mon + 1, timeInfo->tm_mday) * SECONDS_PER_DAY
+            + timeInfo->tm_hour * 3600 + timeInfo->tm_min * 60 + timeInfo->tm_sec;
+        return static_cast<int32_t>(local - utc);
+    }
+
+    std::vector<int64_t> utcStarts;
+    std::vector<int64_t> localStarts;   // utcStarts[i] + offsets[i]: where each entry starts on the wall clock
+    std::vector<int32_t> offsets;
+};
+
+#endif // CALENDAR_H
@@ -0,0 +1,310 @@
+#ifndef COLUMNSTORE_H
+#define COLUMNSTORE_H
+#include <iostream>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <unordered_map>
+#include <optional>
+#include <algorithm>
+#include <numeric>
+#include <type_traits>
+#include <span>
+#include <ctime>
+#include <sqlite3.h>
+#include "database.h"
+#include "messageData.h"
+#include "messageId.h"
+#include "prefixIndex.h"
+
+//---------------------------------------------------------------------------------------------------
+//------------------COLUMNAR MIRROR OF TRANSACTIONS--------------------------------------------------
+//---------------------------------------------------------------------------------------------------
+// Struct-of-arrays copy of the columns reports read (Unix, Amount, CategoryID, interned UserID),
+// rows sorted by Unix, so a time range is two binary searches and a tight loop over plain arrays
+// (see the columnar overloads in reportFunc.h). Message text is not mirrored.
+// Attached to a Database (Database::attachColumns), it is updated by addTransaction(s) after the
+// rows are committed and by deleteRow; like the connection itself it is not thread-safe.
+// 32 bytes per row: the 64-bit hash of each MessageID identifies rows for deletes.
+// Daily prefix sums per user (prefixIndex.h) are maintained alongside, for O(log n) range totals.
+class TransactionColumns {
+public:
+    struct Row {
+        int64_t unixTime = 0;
+        double amount = 0.0;
+        int32_t category = 0;
+        uint32_t user = 0;
+        uint64_t idHash = 0;
+    };
+
+    // Replaces the contents with every row of Transactions; false if the table could not be read
+    bool loadFromDatabase(Database& db) {
+        clear();
+        Database::Statement countStmt = db.prepare("SELECT COUNT(*) FROM Transactions;");
+        if (countStmt && sqlite3_step(countStmt) == SQLITE_ROW) {
+            reserve(static_cast<size_t>(sqlite3_column_int64(countStmt, 0)));
+        }
+
+        Database::Statement stmt = db.prepare("SELECT Unix, Amount, CategoryID, UserID, MessageID FROM Transactions;");
+        if (!stmt) {
+            return false;
+        }
+        int rc;
+        while ((rc = sqlite3_step(stmt)) == SQLITE_ROW) {
+            Row row;
+            row.unixTime = sqlite3_column_int64(stmt, 0);
+            row.amount = sqlite3_column_double(stmt, 1);
+            row.category = sqlite3_column_int(stmt, 2);
+            row.user = internUser(columnText(stmt, 3));
+            row.idHash = hashMessageId(columnText(stmt, 4));
+            append(row);
+        }
+        if (rc != SQLITE_DONE) {
+            std::cerr << "Execution failed: " << sqlite3_errmsg(db) << std::endl;
+            clear();
+            return false;
+        }
+        // Rows come in rowid (insertion) order, which is nearly sorted; sort only if needed
+        if (!std::is_sorted(unixTimes.begin(), unixTimes.end())) {
+            std::vector<size_t> order(size());
+            std::iota(order.begin(), order.end(), size_t(0));
+            std::stable_sort(order.begin(), order.end(), [this](size_t a, size_t b) { return unixTimes[a] < unixTimes[b]; });
+            permute(order);
+        }
+        dailyTotals.rebuild(unixTimes, amounts, categories, users);
+        return true;
+    }
+
+    void insert(std::string_view messageID, std::string_view userID, double amount, int category, int64_t unixTime) {
+        Row row = makeRow(messageID, userID, amount, category, unixTime);
+        dailyTotals.add(row.user, row.category, row.unixTime, row.amount, 1);
+        size_t position = static_cast<size_t>(std::upper_bound(unixTimes.begin(), unixTimes.end(), row.unixTime) - unixTimes.begin());
+        unixTimes.insert(unixTimes.begin() + position, row.unixTime);
+        amounts.insert(amounts.begin() + position, row.amount);
+        categories.insert(categories.begin() + position, row.category);
+        users.insert(users.begin() + position, row.user);
+        idHashes.insert(idHashes.begin() + position, row.idHash);
+    }
+
+    // Batch form: rows newer than everything mirrored (the usual sync) are appended, anything else is
+    // merged in one linear pass instead of shifting the columns once per row
+    void insert(std::span<const MessageData* const> rows) {
+        if (rows.empty()) {
+            return;
+        }
+        std::vector<Row> added;
+        added.reserve(rows.size());
+        for (const MessageData* data : rows) {
+            added.push_back(makeRow(data->messageID, data->userID, data->amount, data->categoryID, data->unixTimestamp));
+        }
+        std::stable_sort(added.begin(), added.end(), [](const Row& a, const Row& b) { return a.unixTime < b.unixTime; });
+
+        size_t existing = size();
+        reserve(existing + added.size());
+        for (const Row& row : added) {
+            append(row);
+            dailyTotals.add(row.user, row.category, row.unixTime, row.amount, 1);
+        }
+        if (existing > 0 && added.front().unixTime < unixTimes[existing - 1]) {
+            std::vector<size_t> order(size());
+            std::iota(order.begin(), order.end(), size_t(0));
+            std::inplace_merge(order.begin(), order.begin() + existing, order.end(),
+                [this](size_t a, size_t b) { return unixTimes[a] < unixTimes[b]; });
+            permute(order);
+        }
+    }
+
+    // Removes the row of messageID; false if it is not mirrored
+    bool erase(std::string_view messageID) {
+        uint64_t hash = hashMessageId(messageID);
+        // The MessageID carries the timestamp, which is normally the row's Unix: search that second first
+        if (auto view = MessageIdView::parse(messageID)) {
+            auto [first, last] = std::equal_range(unixTimes.begin(), unixTimes.end(), view->timestamp);
+            for (auto it = first; it != last; ++it) {
+                size_t row = static_cast<size_t>(it - unixTimes.begin());
+                if (idHashes[row] == hash) {
+                    eraseAt(row);
+                    return true;
+                }
+            }
+        }
+        for (size_t row = 0; row < size(); ++row) {
+            if (idHashes[row] == hash) {
+                eraseAt(row);
+                return true;
+            }
+        }
+        return false;
+    }
+
+    // Removes every row of userID; returns how many
+    size_t eraseUser(std::string_view userID) {
+        std::optional<uint32_t> key = userKey(userID);
+        if (!key.has_value()) {
+            return 0;
+        }
+        size_t kept = 0;
+        for (size_t row = 0; row < size(); ++row) {
+            if (users[row] != *key) {
+                moveRow(row, kept++);
+            }
+        }
+        size_t removed = size() - kept;
+        resize(kept);
+        dailyTotals.eraseUser(*key);
+        return removed;
+    }
+
+    void clear() {
+        resize(0);
+        dailyTotals.clear();
+    }
+
+    void reserve(size_t rows) {
+        unixTimes.reserve(rows);
+        amounts.reserve(rows);
+        categories.reserve(rows);
+        users.reserve(rows);
+        idHashes.reserve(rows);
+    }
+
+    // Rows with first <= Unix <= last, as [begin, end) indices into the columns
+    std::pair<size_t, size_t> rangeOf(time_t first, time_t last) const {
+        auto begin = std::lower_bound(unixTimes.begin(), unixTimes.end(), static_cast<int64_t>(first));
+        auto end = std::upper_bound(begin, unixTimes.end(), static_cast<int64_t>(last));
+        return { static_cast<size_t>(begin - unixTimes.begin()), static_cast<size_t>(end - unixTimes.begin()) };
+    }
+
+    std::optional<uint32_t> userKey(std::string_view userID) const {
+        auto it = userKeys.find(userID);
+        if (it == userKeys.end()) {
+            return std::nullopt;
+        }
+        return it->second;
+    }
+
+    const std::string& userName(uint32_t key) const { return userNames[key]; }
+
+    size_t size() const { return unixTimes.size(); }
+    size_t userCount() const { return userNames.size(); }
+    const std::vector<int64_t>& unixColumn() const { return unixTimes; }
+    const std::vector<double>& amountColumn() const { return amounts; }
+    const std::vector<int32_t>& categoryColumn() const { return categories; }
+    const std::vector<uint32_t>& userColumn() const { return users; }
+    const DailyPrefixSums& dailySums() const { return dailyTotals; }
+
+    size_t memoryBytes() const {
+        return unixTimes.capacity() * sizeof(int64_t) + amounts.capacity() * sizeof(double)
+            + categories.capacity() * sizeof(int32_t) + users.capacity() * sizeof(uint32_t)
+            + idHashes.capacity() * sizeof(uint64_t);
+    }
+
+    void printStats() const {
+        std::cout << "Columnar Transactions: " << size() << " rows, " << userCount() << " users, "
+            << memoryBytes() / (1024 * 1024) << " MiB, daily prefix sums " << dailyTotals.memoryBytes() / 1024 << " KiB" << std::endl;
+    }
+
+    // FNV-1a over the MessageID text
+    static uint64_t hashMessageId(std::string_view messageID) {
+        uint64_t hash = 0xCBF29CE484222325ULL;
+        for (char c : messageID) {
+            hash ^= static_cast<unsigned char>(c);
+            hash *= 0x100000001B3ULL;
+        }
+        return hash;
+    }
+
+private:
+    struct UserHash {
+        using is_transparent = void;
+        size_t operator()(std::string_view user) const { return std::hash<std::string_view>{}(user); }
+    };
+
+    static std::string_view columnText(sqlite3_stmt* stmt, int column) {
+        const char* text = reinterpret_cast<const char*>(sqlite3_column_text(stmt, column));
+        return text ? std::string_view(text, static_cast<size_t>(sqlite3_column_bytes(stmt, column))) : std::string_view();
+    }
+
+    uint32_t internUser(std::string_view userID) {
+        auto it = userKeys.find(userID);
+        if (it != userKeys.end()) {
+            return it->second;
+        }
+        uint32_t key = static_cast<uint32_t>(userNames.size());
+        userNames.emplace_back(userID);
+        userKeys.emplace(userNames.back(), key);
+        return key;
+    }
+
+    Row makeRow(std::string_view messageID, std::string_view userID, double amount, int category, int64_t unixTime) {
+        Row row;
+        row.unixTime = unixTime;
+        row.amount = amount;
+        row.category = category;
+        row.user = internUser(userID);
+        row.idHash = hashMessageId(messageID);
+        return row;
+    }
+
+    void append(const Row& row) {
+        unixTimes.push_back(row.unixTime);
+        amounts.push_back(row.amount);
+        categories.push_back(row.category);
+        users.push_back(row.user);
+        idHashes.push_back(row.idHash);
+    }
+
+    void moveRow(size_t from, size_t to) {
+        unixTimes[to] = unixTimes[from];
+        amounts[to] = amounts[from];
+        categories[to] = categories[from];
+        users[to] = users[from];
+        idHashes[to] = idHashes[from];
+    }
+
+    void eraseAt(size_t row) {
+        dailyTotals.add(users[row], categories[row], unixTimes[row], -amounts[row], -1);
+        unixTimes.erase(unixTimes.begin() + row);
+        amounts.erase(amounts.begin() + row);
+        categories.erase(categories.begin() + row);
+        users.erase(users.begin() + row);
+        idHashes.erase(idHashes.begin() + row);
+    }
+
+    void resize(size_t rows) {
+        unixTimes.resize(rows);
+        amounts.resize(rows);
+        categories.resize(rows);
+        users.resize(rows);
+        idHashes.resize(rows);
+    }
+
+    // Reorders every column so that new row i is old row order[i]
+    void permute(const std::vector<size_t>& order) {
+        auto gather = [&order](auto& column) {
+            std::remove_reference_t<decltype(column)> sorted;
+            sorted.reserve(column.capacity());
+            for (size_t index : order) {
+                sorted.push_back(column[index]);
+            }
+            column.swap(sorted);
+        };
+        gather(unixTimes);
+        gather(amounts);
+        gather(categories);
+        gather(users);
+        gather(idHashes);
+    }
+
+    std::vector<int64_t> unixTimes;
+    std::vector<double> amounts;
+    std::vector<int32_t> categories;
+    std::vector<uint32_t> users;
+    std::vector<uint64_t> idHashes;
+
+    std::vector<std::string> userNames;
+    std::unordered_map<std::string, uint32_t, UserHash, std::equal_to<>> userKeys;
+    DailyPrefixSums dailyTotals;
+};
+
+#endif // COLUMNSTORE_H
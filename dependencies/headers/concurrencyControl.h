@@ -0,0 +1,223 @@
+#ifndef CONCURRENCYCONTROL_H
+#define CONCURRENCYCONTROL_H
+#include <iostream>
+#include <vector>
+#include <chrono>
+#include <algorithm>
+#include <optional>
+#include <array>
+#include <cmath>
+#include <cstdint>
+
+//---------------------------------------------------------------------------------------------------
+//------------------LATENCY HISTOGRAM----------------------------------------------------------------
+//---------------------------------------------------------------------------------------------------
+// Fixed-size log histogram of request latencies: 16 buckets per power of two (about 4.4% wide)
+// from 1 us to ~70 min, so percentiles cost no allocation however many requests are recorded.
+class LatencyHistogram {
+public:
+    static constexpr int BUCKETS_PER_OCTAVE = 16;
+    static constexpr int BUCKET_COUNT = 32 * BUCKETS_PER_OCTAVE;
+
+    void record(std::chrono::steady_clock::duration latency) {
+        int64_t micros = std::chrono::duration_cast<std::chrono::microseconds>(latency).count();
+        ++buckets[bucketFor(micros)];
+        ++count;
+        maxMicros = std::max(maxMicros, micros);
+    }
+
+    void merge(const LatencyHistogram& other) {
+        for (int i = 0; i < BUCKET_COUNT; ++i) {
+            buckets[i] += other.buckets[i];
+        }
+        count += other.count;
+        maxMicros = std::max(maxMicros, other.maxMicros);
+    }
+
+    size_t samples() const { return count; }
+
+    // Upper edge of the bucket holding the p-th percentile (0..100), in milliseconds
+    double percentileMs(double p) const {
+        if (count == 0) {
+            return 0.0;
+        }
+        size_t rank = static_cast<size_t>(std::ceil(p / 100.0 * count));
+        rank = std::clamp<size_t>(rank, 1, count);
+        size_t seen = 0;
+        for (int i = 0; i < BUCKET_COUNT; ++i) {
+            seen += buckets[i];
+            if (seen >= rank) {
+                double upperMicros = std::pow(2.0, static_cast<double>(i + 1) / BUCKETS_PER_OCTAVE);
+                return std::min(upperMicros, static_cast<double>(maxMicros)) / 1000.0;
+            }
+        }
+        return maxMicros / 1000.0;
+    }
+
+    double maxMs() const { return maxMicros / 1000.0; }
+
+private:
+    static int bucketFor(int64_t micros) {
+        if (micros <= 1) {
+            return 0;
+        }
+        int bucket = static_cast<int>(std::log2(static_cast<double>(micros)) * BUCKETS_PER_OCTAVE);
+        return std::min(bucket, BUCKET_COUNT - 1);
+    }
+
+    std::array<uint64_t, BUCKET_COUNT> buckets{};
+    size_t count = 0;
+    int64_t maxMicros = 0;
+};
+
+//---------------------------------------------------------------------------------------------------
+//------------------ADAPTIVE CONCURRENCY (AIMD)------------------------------------------------------
+//---------------------------------------------------------------------------------------------------
+// Decides how many requests may be in flight against the API gateway.
+//   additive increase        - every success while the limit is in use adds 1/limit (about +1 per round trip)
+//   multiplicative decrease  - 429/503/timeouts cut the limit by decreaseFactor, a p99 latency well above
+//                              the best p99 seen so far cuts it by latencyDecreaseFactor
+// Only responses to requests started after the last cut can cut again, so one burst of 429s
+// counts once. Retry-After (or a short backoff without it) pauses new requests entirely.
+// Not thread-safe: owned by the thread that runs the curl_multi loop.
+struct ConcurrencySettings {
+    size_t initial = 4;
+    size_t minimum = 1;
+    size_t maximum = 64;
+    double decreaseFactor = 0.5;
+    double latencyDecreaseFactor = 0.8;
+    double latencyTolerance = 2.0;          // p99 above tolerance * baseline p99 counts as congestion
+    size_t latencyWindow = 64;              // successes per p99 sample
+    std::chrono::milliseconds requestTimeout{ 15000 };
+    int maxAttempts = 5;                    // per MessageID, including the first try
+    bool adaptive = true;                   // false: stay at `initial`, still honour Retry-After
+};
+
+class ConcurrencyController {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    struct Stats {
+        size_t successes = 0;
+        size_t throttled = 0;       // 429 / 503
+        size_t timeouts = 0;
+        size_t latencyCuts = 0;
+        size_t decreases = 0;
+        size_t peakLimit = 0;
+        double finalLimit = 0;
+        LatencyHistogram latency;   // successful requests only
+    };
+
+    explicit ConcurrencyController(const ConcurrencySettings& settings = ConcurrencySettings())
+        : settings(settings),
+          currentLimit(static_cast<double>(std::clamp(settings.initial, settings.minimum, settings.maximum))) {
+        peak = limit();
+    }
+
+    const ConcurrencySettings& config() const { return settings; }
+
+    size_t limit() const { return static_cast<size_t>(currentLimit); }
+
+    // True while a Retry-After/backoff pause is running; no new requests should start
+    bool paused(Clock::time_point now) const { return now < pauseUntil; }
+    Clock::time_point resumeAt() const { return pauseUntil; }
+
+    void onSuccess(Clock::time_point started, Clock::duration latency, size_t inFlight) {
+        ++stats.successes;
+        stats.latency.record(latency);
+        consecutiveThrottles = 0;
+        if (!settings.adaptive) {
+            return;
+        }
+
+        // Growing a limit that is not being used would only store up a burst for later
+        if (inFlight + 1 >= limit()) {
+            currentLimit = std::min(currentLimit + 1.0 / currentLimit, static_cast<double>(settings.maximum));
+            peak = std::max(peak, limit());
+        }
+
+        latencies.push_back(latency);
+        if (latencies.size() < settings.latencyWindow) {
+            return;
+        }
+        auto p99 = percentile99();
+        latencies.clear();
+
+        // The baseline drifts up slowly so a lasting change in server latency is eventually accepted
+        if (baseline == Clock::duration::zero() || p99 < baseline) {
+            baseline = p99;
+        }
+        else {
+            baseline += baseline / 64;
+        }
+        if (p99 > baseline * settings.latencyTolerance) {
+            ++stats.latencyCuts;
+            decrease(started, settings.latencyDecreaseFactor);
+        }
+    }
+
+    // 429/503: cut and pause for Retry-After, or for a backoff that doubles with every throttle in a row.
+    // Like a cut, the backoff only doubles for requests started after the previous throttle.
+    void onThrottle(Clock::time_point started, std::optional<std::chrono::seconds> retryAfter) {
+        ++stats.throttled;
+        auto now = Clock::now();
+        if (started >= lastThrottle) {
+            ++consecutiveThrottles;
+        }
+        lastThrottle = now;
+        decrease(started, settings.decreaseFactor);
+
+        Clock::duration pause = retryAfter.has_value()
+            ? Clock::duration(*retryAfter)
+            : Clock::duration(std::chrono::milliseconds(50) * (1 << std::min(consecutiveThrottles - 1, 5)));
+        pauseUntil = std::max(pauseUntil, now + pause);
+    }
+
+    void onTimeout(Clock::time_point started) {
+        ++stats.timeouts;
+        decrease(started, settings.decreaseFactor);
+    }
+
+    Stats statistics() const {
+        Stats result = stats;
+        result.peakLimit = peak;
+        result.finalLimit = currentLimit;
+        return result;
+    }
+
+    void printStats() const {
+        Stats current = statistics();
+        std::cout << "Concurrency: limit " << limit() << " (peak " << current.peakLimit << "), "
+            << current.decreases << " cuts (" << current.throttled << " throttled, "
+            << current.timeouts << " timeouts, " << current.latencyCuts << " latency)" << std::endl;
+    }
+
+private:
+    void decrease(Clock::time_point started, double factor) {
+        if (!settings.adaptive || started < lastDecrease) {
+            return;
+        }
+        ++stats.decreases;
+        currentLimit = std::max(currentLimit * factor, static_cast<double>(settings.minimum));
+        lastDecrease = Clock::now();
+    }
+
+    Clock::duration percentile99() {
+        size_t index = (latencies.size() * 99) / 100;
+        std::nth_element(latencies.begin(), latencies.begin() + index, latencies.end());
+        return latencies[index];
+    }
+
+    ConcurrencySettings settings;
+    double currentLimit;
+    size_t peak = 0;
+    Clock::time_point lastDecrease{};
+    Clock::time_point lastThrottle{};
+    Clock::time_point pauseUntil{};
+    Clock::duration baseline = Clock::duration::zero();
+    std::vector<Clock::duration> latencies;
+    int consecutiveThrottles = 0;
+    Stats stats;
+};
+
+#endif // CONCURRENCYCONTROL_H
@@ -0,0 +1,256 @@
+#ifndef DATABASE_H
+#define DATABASE_H
+#include <iostream>
+#include <string>
+#include <string_view>
+#include <functional>
+#include <unordered_map>
+#include <optional>
+#include <sqlite3.h>
+#include "calendar.h"
+
+//---------------------------------------------------------------------------------------------------
+//------------------STORAGE PROFILES-----------------------------------------------------------------
+//---------------------------------------------------------------------------------------------------
+// Open-time tuning applied as one set of PRAGMAs:
+//   durable   - WAL + synchronous=FULL: every commit survives power loss
+//   balanced  - WAL + synchronous=NORMAL: a crash can lose the last commits but never corrupts
+//   bulk-load - WAL + synchronous=OFF, big cache and mmap: for rebuilds/imports that can be rerun
+enum class StorageProfile {
+    Durable,
+    Balanced,
+    BulkLoad
+};
+
+struct StorageSettings {
+    const char* name;
+    const char* journalMode;
+    const char* synchronous;
+    int cacheSizeKiB;        // negative cache_size = KiB rather than pages
+    long long mmapSize;      // bytes
+    const char* tempStore;
+    int busyTimeoutMs;
+};
+
+StorageSettings storageSettings(StorageProfile profile) {
+    switch (profile) {
+    case StorageProfile::Durable:
+        return { "durable", "WAL", "FULL", 8 * 1024, 0, "DEFAULT", 5000 };
+    case StorageProfile::BulkLoad:
+        return { "bulk-load", "WAL", "OFF", 256 * 1024, 1024LL * 1024 * 1024, "MEMORY", 10000 };
+    case StorageProfile::Balanced:
+    default:
+        return { "balanced", "WAL", "NORMAL", 32 * 1024, 256LL * 1024 * 1024, "MEMORY", 5000 };
+    }
+}
+
+std::optional<StorageProfile> parseStorageProfile(std::string_view name) {
+    if (name == "durable") return StorageProfile::Durable;
+    if (name == "balanced") return StorageProfile::Balanced;
+    if (name == "bulk-load") return StorageProfile::BulkLoad;
+    return std::nullopt;
+}
+
+class TransactionColumns;   // columnStore.h
+
+//---------------------------------------------------------------------------------------------------
+//------------------DATABASE HANDLE WITH STATEMENT CACHE---------------------------------------------
+//---------------------------------------------------------------------------------------------------
+// Owns the sqlite3* connection and a cache of prepared statements keyed by SQL text,
+// so repeated queries skip sqlite3_prepare. Converts implicitly to sqlite3* for the C API.
+class Database {
+public:
+    struct CacheStats {
+        size_t hits = 0;
+        size_t misses = 0;
+        size_t cached = 0;
+    };
+
+    // Borrowed statement: reset and cleared when it goes out of scope, ready for the next user.
+    // Converts implicitly to sqlite3_stmt*, so the sqlite3_bind_*/step/column calls work as usual.
+    class Statement {
+    public:
+        Statement() = default;
+        Statement(sqlite3_stmt* stmt, bool* inUse) : stmt(stmt), inUse(inUse) {}
+        ~Statement() { release(); }
+
+        Statement(Statement&& other) noexcept : stmt(other.stmt), inUse(other.inUse) {
+            other.stmt = nullptr;
+            other.inUse = nullptr;
+        }
+        Statement& operator=(Statement&& other) noexcept {
+            if (this != &other) {
+                release();
+                stmt = other.stmt;
+                inUse = other.inUse;
+                other.stmt = nullptr;
+                other.inUse = nullptr;
+            }
+            return *this;
+        }
+        Statement(const Statement&) = delete;
+        Statement& operator=(const Statement&) = delete;
+
+        operator sqlite3_stmt* () const { return stmt; }
+        explicit operator bool() const { return stmt != nullptr; }
+
+    private:
+        void release() {
+            if (!stmt) {
+                return;
+            }
+            if (inUse) {
+                sqlite3_reset(stmt);
+                sqlite3_clear_bindings(stmt);
+                *inUse = false;
+            }
+            else {
+                sqlite3_finalize(stmt);  // one-off statement, not in the cache
+            }
+            stmt = nullptr;
+            inUse = nullptr;
+        }
+
+        sqlite3_stmt* stmt = nullptr;
+        bool* inUse = nullptr;  // cache slot flag; null for uncached statements
+    };
+
+    explicit Database(const std::string& path, StorageProfile profile = StorageProfile::Balanced) {
+        int rc = sqlite3_open(path.c_str(), &db);
+        if (rc != SQLITE_OK) {
+            std::cerr << "DB Error: " << sqlite3_errmsg(db) << std::endl;
+            sqlite3_close(db);
+            db = nullptr;
+            return;
+        }
+        applyStorageProfile(profile);
+        sqlite3_create_function(db, "septim_day_start", 1, SQLITE_UTF8 | SQLITE_DETERMINISTIC, nullptr,
+            dayStartFunction, nullptr, nullptr);
+    }
+
+    ~Database() {
+        clearCache();
+        if (db) {
+            sqlite3_close(db);
+        }
+    }
+
+    Database(const Database&) = delete;
+    Database& operator=(const Database&) = delete;
+
+    bool isOpen() const { return db != nullptr; }
+    StorageProfile storageProfile() const { return profile; }
+    const char* storageProfileName() const { return storageSettings(profile).name; }
+
+    // Applies every PRAGMA of the profile; must run outside a transaction (journal_mode cannot change inside one)
+    bool applyStorageProfile(StorageProfile newProfile) {
+        StorageSettings settings = storageSettings(newProfile);
+        std::string pragmas =
+            std::string("PRAGMA journal_mode=") + settings.journalMode + ";"
+            "PRAGMA synchronous=" + settings.synchronous + ";"
+            "PRAGMA cache_size=" + std::to_string(-settings.cacheSizeKiB) + ";"
+            "PRAGMA mmap_size=" + std::to_string(settings.mmapSize) + ";"
+            "PRAGMA temp_store=" + settings.tempStore + ";";
+
+        char* errorMessage = nullptr;
+        if (sqlite3_exec(db, pragmas.c_str(), nullptr, nullptr, &errorMessage) != SQLITE_OK) {
+            std::cerr << "Failed to apply storage profile '" << settings.name << "': "
+                << (errorMessage ? errorMessage : sqlite3_errmsg(db)) << std::endl;
+            sqlite3_free(errorMessage);
+            return false;
+        }
+        sqlite3_busy_timeout(db, settings.busyTimeoutMs);
+
+        profile = newProfile;
+        std::cout << "Storage profile: " << settings.name << std::endl;
+        return true;
+    }
+    sqlite3* handle() const { return db; }
+    operator sqlite3* () const { return db; }
+
+    // Returns a ready-to-bind statement for sql, compiling it only the first time it is seen.
+    // If the cached statement is already borrowed (nested use), a one-off statement is compiled instead.
+    Statement prepare(std::string_view sql) {
+        auto it = cache.find(sql);
+        if (it != cache.end() && !it->second.inUse) {
+            ++hits;
+            it->second.inUse = true;
+            return Statement(it->second.stmt, &it->second.inUse);
+        }
+
+        ++misses;
+        sqlite3_stmt* stmt = nullptr;
+        bool cacheable = (it == cache.end());
+        int rc = sqlite3_prepare_v3(db, sql.data(), static_cast<int>(sql.size()),
+            cacheable ? SQLITE_PREPARE_PERSISTENT : 0, &stmt, nullptr);
+        if (rc != SQLITE_OK) {
+            std::cerr << "Failed to prepare statement: " << sqlite3_errmsg(db) << std::endl;
+            return Statement();
+        }
+
+        if (!cacheable) {
+            return Statement(stmt, nullptr);
+        }
+        CachedStatement& slot = cache[std::string(sql)];
+        slot.stmt = stmt;
+        slot.inUse = true;
+        return Statement(stmt, &slot.inUse);
+    }
+
+    CacheStats cacheStats() const {
+        CacheStats stats;
+        stats.hits = hits;
+        stats.misses = misses;
+        stats.cached = cache.size();
+        return stats;
+    }
+
+    void printCacheStats() const {
+        std::cout << "Statement cache: " << hits << " hits, " << misses << " misses, "
+            << cache.size() << " cached" << std::endl;
+    }
+
+    // Columnar mirror of Transactions that addTransaction(s) and deleteRow keep in step; null for none.
+    // The mirror is borrowed and must outlive the attachment.
+    void attachColumns(TransactionColumns* mirror) { columns = mirror; }
+    TransactionColumns* attachedColumns() const { return columns; }
+
+    // Finalizes every cached statement; must not be called while a Statement is borrowed
+    void clearCache() {
+        for (auto& [sql, cached] : cache) {
+            sqlite3_finalize(cached.stmt);
+        }
+        cache.clear();
+    }
+
+private:
+    // septim_day_start(unix): local start of the day holding unix, from the zone table getStartOfDay()
+    // uses, so the DailyTotals triggers and the report code agree on every day boundary
+    static void dayStartFunction(sqlite3_context* context, int, sqlite3_value** argv) {
+        if (sqlite3_value_type(argv[0]) == SQLITE_NULL) {
+            sqlite3_result_null(context);
+            return;
+        }
+        sqlite3_result_int64(context, TimeZoneTable::local().startOfDay(sqlite3_value_int64(argv[0])));
+    }
+
+    // Transparent hash so lookups by string_view/const char* do not allocate
+    struct SqlHash {
+        using is_transparent = void;
+        size_t operator()(std::string_view sql) const { return std::hash<std::string_view>{}(sql); }
+    };
+
+    struct CachedStatement {
+        sqlite3_stmt* stmt = nullptr;
+        bool inUse = false;
+    };
+
+    sqlite3* db = nullptr;
+    StorageProfile profile = StorageProfile::Balanced;
+    std::unordered_map<std::string, CachedStatement, SqlHash, std::equal_to<>> cache;
+    size_t hits = 0;
+    size_t misses = 0;
+    TransactionColumns* columns = nullptr;
+};
+
+#endif // DATABASE_H
@@ -0,0 +1,182 @@
+#ifndef HTTPCLIENT_H
+#define HTTPCLIENT_H
+#include <iostream>
+#include <vector>
+#include <string>
+#include <mutex>
+#include <array>
+#include <atomic>
+#include <curl/curl.h>
+
+//---------------------------------------------------------------------------------------------------
+//------------------REUSABLE HTTP CLIENT-------------------------------------------------------------
+//---------------------------------------------------------------------------------------------------
+// Owns a pool of easy handles and a CURLSH share so DNS results, open connections and
+// TLS sessions survive between requests instead of being thrown away by curl_easy_cleanup.
+class HttpClient {
+public:
+    struct Stats {
+        size_t requests = 0;
+        size_t connections = 0;   // new TCP connections opened
+        size_t handshakes = 0;    // TLS handshakes performed (full or resumed)
+    };
+
+    HttpClient() {
+        share = curl_share_init();
+        if (!share) {
+            std::cerr << "Failed to initialize curl share" << std::endl;
+            return;
+        }
+        curl_share_setopt(share, CURLSHOPT_LOCKFUNC, lockCallback);
+        curl_share_setopt(share, CURLSHOPT_UNLOCKFUNC, unlockCallback);
+        curl_share_setopt(share, CURLSHOPT_USERDATA, this);
+        curl_share_setopt(share, CURLSHOPT_SHARE, CURL_LOCK_DATA_DNS);
+        curl_share_setopt(share, CURLSHOPT_SHARE, CURL_LOCK_DATA_CONNECT);
+        curl_share_setopt(share, CURLSHOPT_SHARE, CURL_LOCK_DATA_SSL_SESSION);
+    }
+
+    ~HttpClient() {
+        // Easy handles must go before the share they are attached to
+        for (CURL* handle : idle) {
+            curl_easy_cleanup(handle);
+        }
+        if (share) {
+            curl_share_cleanup(share);
+        }
+    }
+
+    HttpClient(const HttpClient&) = delete;
+    HttpClient& operator=(const HttpClient&) = delete;
+
+    // Takes a handle from the pool (or creates one) with the shared caches attached
+    CURL* acquire() {
+        CURL* handle = nullptr;
+        {
+            std::lock_guard<std::mutex> lock(poolMutex);
+            if (!idle.empty()) {
+                handle = idle.back();
+                idle.pop_back();
+            }
+        }
+        if (!handle) {
+            handle = curl_easy_init();
+            if (!handle) {
+                std::cerr << "Failed to initialize curl" << std::endl;
+                return nullptr;
+            }
+        }
+
+        if (share) {
+            curl_easy_setopt(handle, CURLOPT_SHARE, share);
+        }
+        curl_easy_setopt(handle, CURLOPT_TCP_KEEPALIVE, 1L);
+        curl_easy_setopt(handle, CURLOPT_NOSIGNAL, 1L);
+        return handle;
+    }
+
+    // Returns a handle to the pool; its options are reset but its connections stay cached
+    void release(CURL* handle) {
+        if (!handle) {
+            return;
+        }
+        curl_easy_reset(handle);
+        std::lock_guard<std::mutex> lock(poolMutex);
+        idle.push_back(handle);
+    }
+
+    // Accounts for a finished transfer: how many connections and handshakes it needed
+    void recordTransfer(CURL* handle) {
+        long newConnections = 0;
+        curl_off_t appConnectTime = 0;
+        curl_easy_getinfo(handle, CURLINFO_NUM_CONNECTS, &newConnections);
+        curl_easy_getinfo(handle, CURLINFO_APPCONNECT_TIME_T, &appConnectTime);
+
+        requests.fetch_add(1, std::memory_order_relaxed);
+        connections.fetch_add(static_cast<size_t>(newConnections), std::memory_order_relaxed);
+        if (newConnections > 0 && appConnectTime > 0) {
+            handshakes.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+
+    // Performs a blocking GET on a pooled handle; the body is appended to responseBody
+    CURLcode get(const std::string& url, std::string& responseBody, long* httpCode = nullptr) {
+        return get(url, appendToString, &responseBody, httpCode);
+    }
+
+    // Performs a blocking GET on a pooled handle; the body is handed to writeFunction chunk by chunk
+    CURLcode get(const std::string& url, curl_write_callback writeFunction, void* writeData, long* httpCode = nullptr) {
+        CURL* handle = acquire();
+        if (!handle) {
+            return CURLE_FAILED_INIT;
+        }
+
+        curl_easy_setopt(handle, CURLOPT_URL, url.c_str());
+        curl_easy_setopt(handle, CURLOPT_WRITEFUNCTION, writeFunction);
+        curl_easy_setopt(handle, CURLOPT_WRITEDATA, writeData);
+
+        CURLcode res = curl_easy_perform(handle);
+        if (res == CURLE_OK) {
+            recordTransfer(handle);
+        }
+        // Also after an aborted write, so callers can tell an error status from a broken body
+        if (httpCode) {
+            curl_easy_getinfo(handle, CURLINFO_RESPONSE_CODE, httpCode);
+        }
+        release(handle);
+        return res;
+    }
+
+    Stats stats() const {
+        Stats result;
+        result.requests = requests.load(std::memory_order_relaxed);
+        result.connections = connections.load(std::memory_order_relaxed);
+        result.handshakes = handshakes.load(std::memory_order_relaxed);
+        return result;
+    }
+
+    void resetStats() {
+        requests = 0;
+        connections = 0;
+        handshakes = 0;
+    }
+
+    void printStats() const {
+        Stats current = stats();
+        std::cout << "HTTP: " << current.requests << " requests, "
+            << current.connections << " new connections, "
+            << current.handshakes << " TLS handshakes" << std::endl;
+    }
+
+private:
+    static size_t appendToString(char* contents, size_t size, size_t nmemb, void* userData) {
+        size_t totalSize = size * nmemb;
+        static_cast<std::string*>(userData)->append(contents, totalSize);
+        return totalSize;
+    }
+
+    static void lockCallback(CURL*, curl_lock_data data, curl_lock_access, void* userPtr) {
+        static_cast<HttpClient*>(userPtr)->shareMutexes[data % CURL_LOCK_DATA_LAST].lock();
+    }
+
+    static void unlockCallback(CURL*, curl_lock_data data, void* userPtr) {
+        static_cast<HttpClient*>(userPtr)->shareMutexes[data % CURL_LOCK_DATA_LAST].unlock();
+    }
+
+    CURLSH* share = nullptr;
+    std::array<std::mutex, CURL_LOCK_DATA_LAST> shareMutexes;
+
+    std::mutex poolMutex;
+    std::vector<CURL*> idle;
+
+    std::atomic<size_t> requests{ 0 };
+    std::atomic<size_t> connections{ 0 };
+    std::atomic<size_t> handshakes{ 0 };
+};
+
+// Process-wide client used by the free HTTP functions unless another one is passed in
+HttpClient& defaultHttpClient() {
+    static HttpClient client;
+    return client;
+}
+
+#endif // HTTPCLIENT_H
@@ -1,3 +1,5 @@
+#ifndef HTTPFUNC_H
+#define HTTPFUNC_H
 #include <iostream>
 #include <vector>
 #include <string>
@@ -9,6 +11,20 @@
 #include <locale>
 #include <codecvt>
 #include <stdexcept>
+#include <optional>
+#include <span>
+#include <deque>
+#include <functional>
+#include <string_view>
+#include <mutex>
+#include <condition_variable>
+#include "httpClient.h"
+#include "asyncIo.h"
+#include "messageData.h"
+#include "messageId.h"
+#include "concurrencyControl.h"
+#include "responseCache.h"
+#include "knownIds.h"
 
 
 size_t WriteCallback(void* contents, size_t size, size_t nmemb, std::string* userData) {
@@ -17,242 +33,853 @@ size_t WriteCallback(void* contents, size_t size, size_t nmemb, std::string* use
     return totalSize;
 }
 
-struct MessageData {
-    std::string userID;
-    std::string message;
-    int categoryID;
-    double amount;
-    std::string messageID;
-    int64_t unixTimestamp;
+const std::string DEFAULT_API_BASE_URL = "https://m4mq3nellj.execute-api.us-east-1.amazonaws.com/production";
 
-    // Method to initialize the struct from a JSON object
-    static MessageData FromJSON(const nlohmann::json& json) {
-        if (!json.contains("Item")) {
-            throw std::runtime_error("Missing 'Item' key in JSON response");
-        }
+// Base URL of the message API, without a trailing slash; every endpoint is derived from it.
+// Set it before any request starts (septim --api-url, or the benchmark pointing at the local mock).
+std::string& apiBaseUrl() {
+    static std::string url = DEFAULT_API_BASE_URL;
+    return url;
+}
+
+void setApiBaseUrl(std::string url) {
+    while (!url.empty() && url.back() == '/') {
+        url.pop_back();
+    }
+    apiBaseUrl() = std::move(url);
+}
+
+std::string receiveEndpoint() { return apiBaseUrl() + "/receive"; }
+std::string getidEndpoint() { return apiBaseUrl() + "/getid"; }
+
+// IDs per /getid page when the listing is filtered server-side
+const size_t GETID_PAGE_SIZE = 5000;
+
+// Percent-encodes a query value. The base64url alphabet and hex pass unchanged; '=' padding and
+// anything a server puts into a NextToken do not.
+std::string escapeQueryValue(std::string_view value) {
+    char* escaped = curl_easy_escape(nullptr, value.data(), static_cast<int>(value.size()));
+    if (!escaped) {
+        return std::string();
+    }
+    std::string result(escaped);
+    curl_free(escaped);
+    return result;
+}
+
+// /getid pushdown: only `encodedUser`'s IDs from `since` on, one page after the `after` cursor
+// (the previous page's NextToken, passed back as the server sent it).
+// A server that does not know the parameters ignores them and sends the full list.
+std::string getidQueryUrl(std::string_view encodedUser, time_t since, std::string_view after = std::string_view()) {
+    std::string url = getidEndpoint();
+    url += "?user=";
+    url += escapeQueryValue(encodedUser);
+    url += "&since=" + std::to_string(static_cast<long long>(since));
+    url += "&limit=" + std::to_string(GETID_PAGE_SIZE);
+    if (!after.empty()) {
+        url += "&after=";
+        url += escapeQueryValue(after);
+    }
+    return url;
+}
+
+// Parses a raw /receive response body into MessageData; the typed decoder handles the usual shape, the DOM path everything else
+std::optional<MessageData> ParseMessageData(const std::string& responseBody) {
+    MessageData decoded;
+    if (MessageData::TryDecode(responseBody, decoded)) {
+        return decoded;
+    }
 
-        const auto& itemJson = json.at("Item");
-        MessageData data;
+    try {
+        auto jsonResponse = nlohmann::json::parse(responseBody);
 
-        if (itemJson.contains("UserID")) {
-            data.userID = itemJson.at("UserID").get<std::string>();
+        // Convert the JSON response into a MessageData object
+        if (jsonResponse.is_object()) {
+            return MessageData::FromJSON(jsonResponse);
         }
         else {
-            throw std::runtime_error("Missing 'UserID' key in 'Item'");
+            std::cerr << "Invalid JSON structure: " << responseBody << std::endl;
+            return std::nullopt;
         }
+    }
+    catch (const std::exception& e) {
+        std::cerr << "JSON parsing error: " << e.what() << std::endl;
+        return std::nullopt;
+    }
+}
 
-        // Repeat for other fields with appropriate type conversions
-        data.message = itemJson.at("Message").get<std::string>();
-        data.categoryID = itemJson.at("CategoryID").get<int>();
-        data.amount = itemJson.at("Amount").get<double>();
-        data.messageID = itemJson.at("MessageID").get<std::string>();
-        data.unixTimestamp = itemJson.at("Unix").get<int64_t>();
+// A finished /receive transfer as MessageData; only a 200 response goes into the cache
+std::optional<MessageData> receivedMessageData(const std::string& messageID, CURLcode result, long status,
+    const std::string& responseBody, ResponseCache* cache) {
+    if (result != CURLE_OK) {
+        std::cerr << "Transfer failed: " << curl_easy_strerror(result) << std::endl;
+        return std::nullopt;
+    }
+    std::cout << "Raw JSON Response: " << responseBody << std::endl;
+
+    // Parse the JSON response
+    auto data = ParseMessageData(responseBody);
+    if (data.has_value() && cache && status == 200) {
+        cache->put(messageID, *data);
+    }
+    return data;
+}
 
-        return data;
+// Fetches one message on loop; with a cache, a cached copy is returned without touching the network
+Task<std::optional<MessageData>> GetMessageDataAsync(EventLoop& loop, std::string messageID,
+    HttpClient& client = defaultHttpClient(), ResponseCache* cache = nullptr) {
+    if (cache) {
+        if (auto cached = cache->get(messageID)) {
+            co_return std::move(cached);
+        }
     }
 
+    HttpResponse response = co_await loop.get(client, receiveEndpoint() + "?message_id=" + messageID);
+    co_return receivedMessageData(messageID, response.result, response.status, response.body, cache);
+}
 
-    // For debugging or displaying
-    void Print() const {
-        std::cout << "UserID: " << userID << "\n"
-            << "Message: " << message << "\n"
-            << "CategoryID: " << categoryID << "\n"
-            << "Amount: " << amount << "\n"
-            << "MessageID: " << messageID << "\n"
-            << "Unix Timestamp: " << unixTimestamp << std::endl;
+// Blocking form of GetMessageDataAsync: a plain transfer on a pooled handle, no event loop to set up
+std::optional<MessageData> GetMessageData(const std::string& messageID, HttpClient& client = defaultHttpClient(),
+    ResponseCache* cache = nullptr) {
+    if (cache) {
+        if (auto cached = cache->get(messageID)) {
+            return cached;
+        }
     }
-};
 
-std::optional<MessageData> GetMessageData(const std::string& messageID) {
-    CURL* curl;
-    CURLcode res;
     std::string responseBody;
+    long status = 0;
+    CURLcode result = client.get(receiveEndpoint() + "?message_id=" + messageID, responseBody, &status);
+    return receivedMessageData(messageID, result, status, responseBody, cache);
+}
 
-    std::string url = "https://m4mq3nellj.execute-api.us-east-1.amazonaws.com/production/receive?message_id=" + messageID;
+//---------------------------------------------------------------------------------------------------
+//------------------MESSAGE ID FEED------------------------------------------------------------------
+//---------------------------------------------------------------------------------------------------
+// MessageIDs handed from a lister (the streaming /getid parse) to a fetch stage while the listing is
+// still downloading. The lister push()es and finally close()s; readers take IDs by position, so
+// fetching starts with the first listed ID instead of after the last. The listener is called (under
+// the feed's lock) after every push and on close, to wake the reader: curl_multi_wakeup for
+// GetMessageBodiesBatch, an AsyncCondition for ingestMessagesAsync (whose lister runs on the same loop).
+class MessageIdFeed {
+public:
+    MessageIdFeed() = default;
+
+    // A complete list: already closed
+    explicit MessageIdFeed(std::span<const std::string> messageIDs) : ids(messageIDs.begin(), messageIDs.end()), closed(true) {}
+
+    void push(std::string messageID) {
+        std::lock_guard<std::mutex> lock(mutex);
+        ids.push_back(std::move(messageID));
+        arrived.notify_all();
+        if (listener) {
+            listener();
+        }
+    }
 
-    curl = curl_easy_init();
-    if (curl) {
-        curl_easy_setopt(curl, CURLOPT_URL, url.c_str());
-        curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, WriteCallback);
-        curl_easy_setopt(curl, CURLOPT_WRITEDATA, &responseBody);
+    void close() {
+        std::lock_guard<std::mutex> lock(mutex);
+        closed = true;
+        arrived.notify_all();
+        if (listener) {
+            listener();
+        }
+    }
 
-        res = curl_easy_perform(curl);
-        if (res != CURLE_OK) {
-            std::cerr << "curl_easy_perform() failed: " << curl_easy_strerror(res) << std::endl;
-            curl_easy_cleanup(curl);
-            return std::nullopt;
+    // Copies the ID at position; false if it has not been listed (yet)
+    bool get(size_t position, std::string& messageID) const {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (position >= ids.size()) {
+            return false;
         }
-        std::cout << "Raw JSON Response: " << responseBody << std::endl;
+        messageID = ids[position];
+        return true;
+    }
 
-        curl_easy_cleanup(curl);
+    bool has(size_t position) const {
+        std::lock_guard<std::mutex> lock(mutex);
+        return position < ids.size();
+    }
 
-        // Parse the JSON response
-        try {
-            auto jsonResponse = nlohmann::json::parse(responseBody);
+    // True once position can never be filled
+    bool exhausted(size_t position) const {
+        std::lock_guard<std::mutex> lock(mutex);
+        return closed && position >= ids.size();
+    }
 
-            // Convert the JSON response into a MessageData object
-            if (jsonResponse.is_object()) {
-                return MessageData::FromJSON(jsonResponse);
-            }
-            else {
-                std::cerr << "Invalid JSON structure: " << responseBody << std::endl;
-                return std::nullopt;
-            }
-        }
-        catch (const std::exception& e) {
-            std::cerr << "JSON parsing error: " << e.what() << std::endl;
-            return std::nullopt;
-        }
+    // Blocks until position is listed or the feed is closed
+    void waitFor(size_t position) const {
+        std::unique_lock<std::mutex> lock(mutex);
+        arrived.wait(lock, [&] { return position < ids.size() || closed; });
     }
-    else {
-        std::cerr << "Failed to initialize curl" << std::endl;
-        return std::nullopt;
+
+    size_t size() const {
+        std::lock_guard<std::mutex> lock(mutex);
+        return ids.size();
     }
-}
 
+    void setListener(std::function<void()> callback) {
+        std::lock_guard<std::mutex> lock(mutex);
+        listener = std::move(callback);
+    }
+
+private:
+    mutable std::mutex mutex;
+    mutable std::condition_variable arrived;
+    std::deque<std::string> ids;
+    bool closed = false;
+    std::function<void()> listener;
+};
 
-// Base64 decoding helper function
-std::string Base64Decode(const std::string& encoded) {
-    static const std::string base64Chars =
-        "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789-_";
+//---------------------------------------------------------------------------------------------------
+//------------------CONCURRENT FETCHING (curl_multi)-------------------------------------------------
+//---------------------------------------------------------------------------------------------------
+struct BatchTransfer {
+    CURL* easy = nullptr;
+    std::string messageID;
+    std::string url;
+    std::string responseBody;
+    int attempts = 0;
+    std::chrono::steady_clock::time_point started;
+};
 
-    std::string decoded;
-    std::vector<int> decodeTable(256, -1);
+// Starts (or restarts) a transfer on an easy handle for the given MessageID
+void startBatchTransfer(CURLM* multi, BatchTransfer& transfer, const std::string& endpoint, const std::string& messageID,
+    long timeoutMs = 0) {
+    transfer.messageID = messageID;
+    transfer.url = endpoint + "?message_id=" + messageID;
+    transfer.responseBody.clear();
+    transfer.started = std::chrono::steady_clock::now();
+
+    curl_easy_setopt(transfer.easy, CURLOPT_URL, transfer.url.c_str());
+    curl_easy_setopt(transfer.easy, CURLOPT_WRITEFUNCTION, WriteCallback);
+    curl_easy_setopt(transfer.easy, CURLOPT_WRITEDATA, &transfer.responseBody);
+    curl_easy_setopt(transfer.easy, CURLOPT_PRIVATE, &transfer);
+    curl_easy_setopt(transfer.easy, CURLOPT_TIMEOUT_MS, timeoutMs);
+    curl_multi_add_handle(multi, transfer.easy);
+}
 
-    for (size_t i = 0; i < base64Chars.size(); ++i) {
-        decodeTable[base64Chars[i]] = static_cast<int>(i);
+// Fetches many raw /receive bodies; how many transfers run at once is decided by controller
+// (AIMD, see concurrencyControl.h) or, without one, fixed at maxConcurrency.
+// 429/503 responses, 5xx gateway errors and timeouts are retried up to maxAttempts times.
+// onBody gets every HTTP 200 body as soon as its transfer completes (completion order, not input order);
+// returning false stops new transfers from starting, the ones in flight still finish.
+// IDs are taken from the feed as they are listed; it returns once the feed is closed and drained.
+// Returns the number of bodies delivered.
+size_t GetMessageBodiesBatch(MessageIdFeed& messageIDs,
+    const std::function<bool(const std::string& messageID, std::string&& body)>& onBody,
+    size_t maxConcurrency = 16,
+    const std::string& endpoint = receiveEndpoint(),
+    HttpClient& client = defaultHttpClient(),
+    ConcurrencyController* controller = nullptr) {
+    using Clock = std::chrono::steady_clock;
+    if (messageIDs.exhausted(0)) {
+        return 0;
     }
 
-    // Add padding only if necessary
-    std::string input = encoded;
-    size_t remainder = input.size() % 4;
-    if (remainder > 0) {
-        input.append(4 - remainder, '=');
+    ConcurrencySettings fixedSettings;
+    fixedSettings.initial = fixedSettings.minimum = fixedSettings.maximum = std::max<size_t>(maxConcurrency, 1);
+    fixedSettings.adaptive = false;
+    ConcurrencyController fixedController(fixedSettings);
+    ConcurrencyController& control = controller ? *controller : fixedController;
+    const ConcurrencySettings& settings = control.config();
+
+    CURLM* multi = curl_multi_init();
+    if (!multi) {
+        std::cerr << "Failed to initialize curl multi" << std::endl;
+        return 0;
     }
+    // A newly listed ID ends the wait in curl_multi_poll
+    messageIDs.setListener([multi] { curl_multi_wakeup(multi); });
+
+    // Handles are opened as transfers need them, never more than settings.maximum
+    std::deque<BatchTransfer> transfers;  // deque keeps addresses stable for CURLOPT_PRIVATE
+    std::vector<BatchTransfer*> idle;
+    auto freeTransfer = [&]() -> BatchTransfer* {
+        if (idle.empty() && transfers.size() < settings.maximum) {
+            BatchTransfer& transfer = transfers.emplace_back();
+            transfer.easy = client.acquire();
+            if (!transfer.easy) {
+                transfers.pop_back();
+                return nullptr;
+            }
+            idle.push_back(&transfer);
+        }
+        if (idle.empty()) {
+            return nullptr;
+        }
+        BatchTransfer* transfer = idle.back();
+        idle.pop_back();
+        return transfer;
+    };
+
+    struct Retry {
+        std::string messageID;
+        int attempts;
+    };
+    std::deque<Retry> retries;
+    size_t nextID = 0;
+    size_t inFlight = 0;
+    size_t succeeded = 0;
+    bool stopping = false;
+    bool outOfHandles = false;
+    long timeoutMs = static_cast<long>(settings.requestTimeout.count());
+
+    auto hasWork = [&]() { return !stopping && (!retries.empty() || messageIDs.has(nextID)); };
+    auto listing = [&]() { return !stopping && !messageIDs.exhausted(nextID); };
+
+    // Fills free handles up to the controller's limit, retries first
+    auto startTransfers = [&]() {
+        auto now = Clock::now();
+        while (hasWork() && inFlight < control.limit() && !control.paused(now)) {
+            BatchTransfer* transfer = freeTransfer();
+            if (!transfer) {
+                outOfHandles = inFlight == 0;
+                break;
+            }
+            std::string messageID;
+            if (!retries.empty()) {
+                messageID = std::move(retries.front().messageID);
+                transfer->attempts = retries.front().attempts + 1;
+                retries.pop_front();
+            }
+            else {
+                messageIDs.get(nextID++, messageID);
+                transfer->attempts = 1;
+            }
+            startBatchTransfer(multi, *transfer, endpoint, messageID, timeoutMs);
+            ++inFlight;
+        }
+    };
 
-    for (size_t i = 0; i < input.size(); i += 4) {
-        int n = (decodeTable[input[i]] << 18) +
-            (decodeTable[input[i + 1]] << 12) +
-            ((i + 2 < input.size() && input[i + 2] != '=') ? (decodeTable[input[i + 2]] << 6) : 0) +
-            ((i + 3 < input.size() && input[i + 3] != '=') ? decodeTable[input[i + 3]] : 0);
-
-        decoded += static_cast<char>((n >> 16) & 0xFF);
-        if (i + 2 < input.size() && input[i + 2] != '=') {
-            decoded += static_cast<char>((n >> 8) & 0xFF);
+    auto retryLater = [&](const BatchTransfer& transfer, const char* reason) {
+        if (transfer.attempts < settings.maxAttempts) {
+            retries.push_back(Retry{ transfer.messageID, transfer.attempts });
         }
-        if (i + 3 < input.size() && input[i + 3] != '=') {
-            decoded += static_cast<char>(n & 0xFF);
+        else {
+            std::cerr << "Giving up on MessageID " << transfer.messageID << " after "
+                << transfer.attempts << " attempts: " << reason << std::endl;
+        }
+    };
+
+    startTransfers();
+    while (!outOfHandles && (inFlight > 0 || hasWork() || listing())) {
+        int running = 0;
+        CURLMcode mc = curl_multi_perform(multi, &running);
+        if (mc != CURLM_OK) {
+            std::cerr << "curl_multi_perform() failed: " << curl_multi_strerror(mc) << std::endl;
+            break;
         }
-    }
 
-    return decoded;
-}
+        int queued = 0;
+        while (CURLMsg* msg = curl_multi_info_read(multi, &queued)) {
+            if (msg->msg != CURLMSG_DONE) {
+                continue;
+            }
 
+            BatchTransfer* transfer = nullptr;
+            curl_easy_getinfo(msg->easy_handle, CURLINFO_PRIVATE, &transfer);
+            CURLcode res = msg->data.result;
+            curl_multi_remove_handle(multi, transfer->easy);
+            --inFlight;
 
+            long httpCode = 0;
+            curl_easy_getinfo(transfer->easy, CURLINFO_RESPONSE_CODE, &httpCode);
 
+            if (res == CURLE_OK) {
+                client.recordTransfer(transfer->easy);
+            }
 
+            if (res == CURLE_OPERATION_TIMEDOUT) {
+                control.onTimeout(transfer->started);
+                retryLater(*transfer, "timeout");
+            }
+            else if (res != CURLE_OK) {
+                std::cerr << "Transfer failed for MessageID " << transfer->messageID << ": " << curl_easy_strerror(res) << std::endl;
+            }
+            else if (httpCode == 429 || httpCode == 503) {
+                curl_off_t retryAfter = 0;
+                curl_easy_getinfo(transfer->easy, CURLINFO_RETRY_AFTER, &retryAfter);
+                control.onThrottle(transfer->started, retryAfter > 0
+                    ? std::optional<std::chrono::seconds>(std::chrono::seconds(retryAfter)) : std::nullopt);
+                retryLater(*transfer, "throttled");
+            }
+            else if (httpCode == 500 || httpCode == 502 || httpCode == 504) {
+                control.onTimeout(transfer->started);
+                retryLater(*transfer, "gateway error");
+            }
+            else if (httpCode != 200) {
+                std::cerr << "HTTP " << httpCode << " for MessageID: " << transfer->messageID << std::endl;
+            }
+            else {
+                control.onSuccess(transfer->started, Clock::now() - transfer->started, inFlight);
+                ++succeeded;
+                stopping = !onBody(transfer->messageID, std::move(transfer->responseBody)) || stopping;
+            }
 
-// Decodes MessageID and returns userID, timestamp, and randomHex
-std::optional<std::tuple<std::string, int, std::string>> DecodeMessageID(const std::string& messageID) {
-    size_t firstUnderscore = messageID.find("_");
-    size_t secondUnderscore = messageID.find("_", firstUnderscore + 1);
+            // The handle (and its connection) goes back to the free list for the next pending ID
+            idle.push_back(transfer);
+        }
 
-    if (firstUnderscore == std::string::npos || secondUnderscore == std::string::npos) {
-        return std::nullopt;
+        startTransfers();
+
+        // Sleep until there is network activity, or until a Retry-After pause ends
+        auto now = Clock::now();
+        int waitMs = 1000;
+        if (control.paused(now)) {
+            auto pause = std::chrono::duration_cast<std::chrono::milliseconds>(control.resumeAt() - now).count() + 1;
+            waitMs = static_cast<int>(std::min<long long>(pause, waitMs));
+        }
+        if (inFlight > 0 || hasWork() || listing()) {
+            curl_multi_poll(multi, nullptr, 0, waitMs, nullptr);
+        }
     }
+    messageIDs.setListener(nullptr);
 
-    try {
-        std::string userIDEncoded = messageID.substr(0, firstUnderscore);
-        std::string timestampHex = messageID.substr(firstUnderscore + 1, secondUnderscore - firstUnderscore - 1);
-        std::string randomHex = messageID.substr(secondUnderscore + 1);
+    for (auto& transfer : transfers) {
+        if (transfer.easy) {
+            curl_multi_remove_handle(multi, transfer.easy);
+            client.release(transfer.easy);
+        }
+    }
+    curl_multi_cleanup(multi);
+
+    return succeeded;
+}
+
+size_t GetMessageBodiesBatch(std::span<const std::string> messageIDs,
+    const std::function<bool(const std::string& messageID, std::string&& body)>& onBody,
+    size_t maxConcurrency = 16,
+    const std::string& endpoint = receiveEndpoint(),
+    HttpClient& client = defaultHttpClient(),
+    ConcurrencyController* controller = nullptr) {
+    MessageIdFeed feed(messageIDs);
+    return GetMessageBodiesBatch(feed, onBody, maxConcurrency, endpoint, client, controller);
+}
 
-        std::string userID = Base64Decode(userIDEncoded);
+// Fetches many messages with up to maxConcurrency transfers in flight.
+// onResult is called for every message as soon as its transfer completes (completion order, not input order).
+// Returns the number of messages that were fetched and parsed successfully.
+size_t GetMessageDataBatch(std::span<const std::string> messageIDs,
+    const std::function<void(MessageData&&)>& onResult,
+    size_t maxConcurrency = 16,
+    const std::string& endpoint = receiveEndpoint(),
+    HttpClient& client = defaultHttpClient()) {
+    size_t succeeded = 0;
+    GetMessageBodiesBatch(messageIDs, [&](const std::string& messageID, std::string&& body) {
+        if (auto data = ParseMessageData(body)) {
+            ++succeeded;
+            onResult(std::move(*data));
+        }
+        else {
+            std::cerr << "Failed to retrieve data for MessageID: " << messageID << std::endl;
+        }
+        return true;
+    }, maxConcurrency, endpoint, client);
+    return succeeded;
+}
+
+// Convenience overload: collects the results in completion order
+std::vector<MessageData> GetMessageDataBatch(std::span<const std::string> messageIDs, size_t maxConcurrency = 16,
+    const std::string& endpoint = receiveEndpoint(), HttpClient& client = defaultHttpClient()) {
+    std::vector<MessageData> results;
+    results.reserve(messageIDs.size());
+    GetMessageDataBatch(messageIDs, [&results](MessageData&& data) { results.push_back(std::move(data)); },
+        maxConcurrency, endpoint, client);
+    return results;
+}
 
-        // Convert timestamp
-        int timestamp = std::stoi(timestampHex, nullptr, 16);
 
-        return std::make_tuple(userID, timestamp, randomHex);
+// Base64 decoding helper function; returns an empty string for input outside the base64url alphabet
+std::string Base64Decode(std::string_view encoded) {
+    std::string decoded(Base64UrlMaxDecodedSize(encoded.size()), '\0');
+    auto written = Base64UrlDecode(encoded, decoded.data());
+    if (!written.has_value()) {
+        return std::string();
     }
-    catch (const std::exception& e) {
-        std::cerr << "Error decoding MessageID: " << e.what() << std::endl;
+    decoded.resize(*written);
+    return decoded;
+}
+
+// Decodes MessageID and returns userID, timestamp, and randomHex
+std::optional<std::tuple<std::string, int64_t, std::string>> DecodeMessageID(std::string_view messageID) {
+    auto view = MessageIdView::parse(messageID);
+    if (!view.has_value()) {
         return std::nullopt;
     }
+    return std::make_tuple(view->decodeUser(), view->timestamp, std::string(view->randomHex));
 }
 
-
-
-// Filters MessageIDs for a specific user
+// Filters MessageIDs for a specific user; the target is encoded once and compared against each ID's user segment
 std::vector<std::string> FilterMessageIDsByUserID(const std::vector<std::string>& messageIDs, const std::string& targetUserID) {
     std::vector<std::string> filteredMessageIDs;
+    std::string encodedTarget = Base64UrlEncode(targetUserID);
+    size_t malformed = 0;
 
     for (const auto& messageID : messageIDs) {
-        auto decoded = DecodeMessageID(messageID);
-        if (decoded.has_value()) {
-            const auto& [userID, timestamp, randomHex] = decoded.value();
-            if (userID == targetUserID) {
-                std::cout << "MessageID: " << messageID << " matches targetUserID." << std::endl;
-                filteredMessageIDs.push_back(messageID);
-            }
+        auto view = MessageIdView::parse(messageID);
+        if (!view.has_value()) {
+            ++malformed;
+            continue;
         }
-        else {
-            std::cerr << "Failed to decode MessageID: " << messageID << std::endl;
+        if (view->hasEncodedUser(encodedTarget)) {
+            filteredMessageIDs.push_back(messageID);
         }
     }
 
+    if (malformed > 0) {
+        std::cerr << "Failed to decode " << malformed << " MessageIDs" << std::endl;
+    }
+    std::cout << filteredMessageIDs.size() << " of " << messageIDs.size()
+        << " MessageIDs match targetUserID." << std::endl;
     return filteredMessageIDs;
 }
 
-// Fetches data from API and filters MessageIDs by userID
-std::vector<std::string> getActualID(const std::string& targetUserID, time_t actualTimestamp) {
-    CURL* curl;
-    CURLcode res;
-    std::string responseBody;
-    std::vector<std::string> filteredMessageIDs;
+//---------------------------------------------------------------------------------------------------
+//------------------STREAMING /getid PARSER----------------------------------------------------------
+//---------------------------------------------------------------------------------------------------
+// Push parser for the /getid body: {"MessageIDs": ["...", ...], "NextToken": "...", ...}.
+// Bytes are fed as curl delivers them and every string of the top-level "MessageIDs" array is
+// handed to onID as soon as it is complete, so only the ID being read is ever held in memory.
+// A string "NextToken" is kept for paging; values of other keys are skipped, whatever their shape.
+class MessageIDStreamParser {
+public:
+    explicit MessageIDStreamParser(std::function<void(std::string_view)> onID) : onID(std::move(onID)) {}
+
+    // Returns false once the input is known to be malformed
+    bool feed(const char* data, size_t size) {
+        for (size_t i = 0; i < size && !failed; ++i) {
+            char c = data[i];
+            if (inString) {
+                readStringChar(c);
+            }
+            else {
+                readStructuralChar(c);
+            }
+        }
+        return !failed;
+    }
 
-    curl = curl_easy_init();
-    if (curl) {
-        curl_easy_setopt(curl, CURLOPT_URL, "https://m4mq3nellj.execute-api.us-east-1.amazonaws.com/production/getid");
-        curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, WriteCallback);
-        curl_easy_setopt(curl, CURLOPT_WRITEDATA, &responseBody);
+    // Call after the last chunk; true if a complete document with a "MessageIDs" array was seen
+    bool finish() const {
+        return !failed && !inString && containers.empty() && sawRoot && sawMessageIDs;
+    }
 
-        res = curl_easy_perform(curl);
-        if (res != CURLE_OK) {
-            std::cerr << "curl_easy_perform() failed: " << curl_easy_strerror(res) << std::endl;
+    bool foundMessageIDs() const { return sawMessageIDs; }
+    const std::string& nextPageToken() const { return nextToken; }
+    size_t idCount() const { return ids; }
+
+    static size_t WriteCallback(char* contents, size_t size, size_t nmemb, void* userData) {
+        size_t totalSize = size * nmemb;
+        auto* parser = static_cast<MessageIDStreamParser*>(userData);
+        // Returning less than totalSize makes curl abort the transfer
+        return parser->feed(contents, totalSize) ? totalSize : 0;
+    }
+
+private:
+    void readStringChar(char c) {
+        if (unicodeDigits > 0) {
+            int digit = hexValue(c);
+            if (digit < 0) {
+                failed = true;
+                return;
+            }
+            unicodeValue = (unicodeValue << 4) | digit;
+            if (--unicodeDigits == 0) {
+                appendCodePoint(unicodeValue);
+            }
+            return;
+        }
+        if (escaped) {
+            escaped = false;
+            switch (c) {
+            case '"': case '\\': case '/': current += c; break;
+            case 'b': current += '\b'; break;
+            case 'f': current += '\f'; break;
+            case 'n': current += '\n'; break;
+            case 'r': current += '\r'; break;
+            case 't': current += '\t'; break;
+            case 'u': unicodeDigits = 4; unicodeValue = 0; break;
+            default: failed = true; break;
+            }
+            return;
+        }
+        if (c == '\\') {
+            escaped = true;
+        }
+        else if (c == '"') {
+            inString = false;
+            onStringEnd();
         }
         else {
-            try {
-                auto jsonResponse = nlohmann::json::parse(responseBody);
-
-                if (jsonResponse.contains("MessageIDs")) {
-                    std::vector<std::string> messageIDs = jsonResponse["MessageIDs"].get<std::vector<std::string>>();
-
-                    for (const auto& messageID : messageIDs) {
-                        auto decoded = DecodeMessageID(messageID);
-                        if (decoded.has_value()) {
-                            const auto& [userID, timestamp, randomHex] = decoded.value();
-                            if (userID == targetUserID && timestamp >= actualTimestamp) {
-                                filteredMessageIDs.push_back(messageID);
-                            }
-                            else {
-                                std::cout << "Skipped MessageID: " << messageID << std::endl;
-                            }
-                        }
-                    }
-                }
-                else {
-                    std::cerr << "JSON does not contain 'MessageIDs' key." << std::endl;
+            current += c;
+        }
+    }
+
+    void readStructuralChar(char c) {
+        switch (c) {
+        case ' ': case '\t': case '\n': case '\r':
+            return;
+        case '"':
+            inString = true;
+            current.clear();
+            return;
+        case '{':
+        case '[':
+            if (containers.empty()) {
+                if (sawRoot || c != '{') {
+                    failed = true;
+                    return;
                 }
+                sawRoot = true;
+            }
+            if (insideMessageIDs()) {
+                failed = true;  // only strings are expected inside the MessageIDs array
+                return;
+            }
+            containers.push_back(c);
+            if (c == '[' && containers.size() == 2 && currentKey == "MessageIDs") {
+                sawMessageIDs = true;
             }
-            catch (const std::exception& e) {
-                std::cerr << "Error parsing JSON or filtering MessageIDs: " << e.what() << std::endl;
+            expectingKey = (c == '{');
+            return;
+        case '}':
+        case ']':
+            if (containers.empty() || containers.back() != (c == '}' ? '{' : '[')) {
+                failed = true;
+                return;
             }
+            containers.pop_back();
+            expectingKey = false;
+            return;
+        case ':':
+            expectingKey = false;
+            return;
+        case ',':
+            expectingKey = !containers.empty() && containers.back() == '{';
+            return;
+        default:
+            // Numbers, true/false/null: only valid as values outside the MessageIDs array
+            if (containers.empty() || insideMessageIDs()) {
+                failed = true;
+            }
+            return;
         }
+    }
 
-        curl_easy_cleanup(curl);
+    void onStringEnd() {
+        if (containers.size() == 1 && expectingKey) {
+            currentKey = current;
+        }
+        else if (containers.size() == 1 && currentKey == "NextToken") {
+            nextToken = current;
+        }
+        else if (insideMessageIDs()) {
+            ++ids;
+            onID(current);
+        }
     }
-    else {
-        std::cerr << "Failed to initialize curl" << std::endl;
+
+    bool insideMessageIDs() const {
+        return containers.size() == 2 && containers[1] == '[' && currentKey == "MessageIDs";
     }
 
-    return filteredMessageIDs;
+    void appendCodePoint(unsigned int codePoint) {
+        // Surrogate pairs never occur in MessageIDs; encode BMP code points as UTF-8
+        if (codePoint < 0x80) {
+            current += static_cast<char>(codePoint);
+        }
+        else if (codePoint < 0x800) {
+            current += static_cast<char>(0xC0 | (codePoint >> 6));
+            current += static_cast<char>(0x80 | (codePoint & 0x3F));
+        }
+        else {
+            current += static_cast<char>(0xE0 | (codePoint >> 12));
+            current += static_cast<char>(0x80 | ((codePoint >> 6) & 0x3F));
+            current += static_cast<char>(0x80 | (codePoint & 0x3F));
+        }
+    }
+
+    static int hexValue(char c) {
+        if (c >= '0' && c <= '9') return c - '0';
+        if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+        if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+        return -1;
+    }
+
+    std::function<void(std::string_view)> onID;
+    std::vector<char> containers;  // open '{' / '[' from the root down
+    std::string currentKey;        // last key read in the root object
+    std::string current;           // string being read
+    std::string nextToken;
+    bool expectingKey = false;
+    bool inString = false;
+    bool escaped = false;
+    int unicodeDigits = 0;
+    unsigned int unicodeValue = 0;
+    bool sawRoot = false;
+    bool sawMessageIDs = false;
+    bool failed = false;
+    size_t ids = 0;
+};
+
+// One /getid listing of targetUserID's IDs at or after `since`, page by page: the user and timestamp
+// are pushed down as query parameters, following NextToken. IDs are still decoded and filtered here
+// while each body downloads, which covers servers that ignore the parameters and return everything.
+// Shared by the blocking and coroutine forms, which only differ in how a page is transferred:
+//   MessageIDStreamParser& parser = listing.startPage();
+//   ... GET listing.pageUrl() into parser ...
+//   page = listing.finishPage(result, status);   // until page != More
+class GetIdListing {
+public:
+    enum class Page { More, Done, Failed };
+
+    GetIdListing(const std::string& targetUserID, time_t since, std::function<void(const std::string&)> onMatch)
+        : encodedTarget(Base64UrlEncode(targetUserID)), since(since), onMatch(std::move(onMatch)) {}
+
+    // The parser points back at the listing
+    GetIdListing(const GetIdListing&) = delete;
+    GetIdListing& operator=(const GetIdListing&) = delete;
+
+    std::string pageUrl() const { return getidQueryUrl(encodedTarget, since, after); }
+
+    MessageIDStreamParser& startPage() {
+        parser.emplace([this](std::string_view id) { readID(id); });
+        return *parser;
+    }
+
+    Page finishPage(CURLcode result, long status) {
+        // An error body is JSON too, but not a listing; checked first because the parser may have aborted on it
+        if (status != 0 && status != 200) {
+            std::cerr << "HTTP " << status << " from /getid" << std::endl;
+            return Page::Failed;
+        }
+        if (result != CURLE_OK) {
+            std::cerr << "Transfer failed: " << curl_easy_strerror(result) << std::endl;
+            return Page::Failed;
+        }
+        listed += parser->idCount();
+        ++pages;
+
+        if (!parser->finish()) {
+            if (parser->foundMessageIDs()) {
+                std::cerr << "Error parsing JSON or filtering MessageIDs: truncated or malformed response" << std::endl;
+            }
+            else {
+                std::cerr << "JSON does not contain 'MessageIDs' key." << std::endl;
+            }
+            return Page::Failed;
+        }
+        // A cursor that does not move would page forever
+        if (!parser->nextPageToken().empty() && parser->nextPageToken() != after) {
+            after = parser->nextPageToken();
+            return Page::More;
+        }
+
+        std::cout << "Skipped " << skipped << " of " << listed << " MessageIDs";
+        if (pages > 1) {
+            std::cout << " (" << pages << " pages)";
+        }
+        std::cout << std::endl;
+        return Page::Done;
+    }
+
+private:
+    // Only matching IDs are copied out of the parser's buffer
+    void readID(std::string_view id) {
+        auto view = MessageIdView::parse(id);
+        if (view.has_value() && view->timestamp >= since && view->hasEncodedUser(encodedTarget)) {
+            messageID.assign(id);
+            onMatch(messageID);
+            return;
+        }
+        ++skipped;
+    }
+
+    std::string encodedTarget;
+    time_t since;
+    std::function<void(const std::string&)> onMatch;
+    std::optional<MessageIDStreamParser> parser;
+    std::string messageID;
+    std::string after;
+    size_t skipped = 0;
+    size_t listed = 0;
+    size_t pages = 0;
+};
+
+// Streams /getid and calls onMatch (on the loop thread) for every MessageID of targetUserID at or
+// after actualTimestamp. Returns false if a request failed or a page was not a valid MessageIDs document.
+Task<bool> streamActualIDsAsync(EventLoop& loop, std::string targetUserID, time_t actualTimestamp,
+    std::function<void(const std::string&)> onMatch, HttpClient& client = defaultHttpClient()) {
+    GetIdListing listing(targetUserID, actualTimestamp, std::move(onMatch));
+    GetIdListing::Page page;
+    do {
+        MessageIDStreamParser& parser = listing.startPage();
+        HttpResponse response = co_await loop.get(client, listing.pageUrl(), MessageIDStreamParser::WriteCallback, &parser);
+        page = listing.finishPage(response.result, response.status);
+    } while (page == GetIdListing::Page::More);
+    co_return page == GetIdListing::Page::Done;
 }
+
+// Blocking form: plain transfers on pooled handles, onMatch runs on the calling thread
+bool streamActualIDs(const std::string& targetUserID, time_t actualTimestamp,
+    const std::function<void(const std::string&)>& onMatch, HttpClient& client = defaultHttpClient()) {
+    GetIdListing listing(targetUserID, actualTimestamp, onMatch);
+    GetIdListing::Page page;
+    do {
+        MessageIDStreamParser& parser = listing.startPage();
+        long status = 0;
+        CURLcode result = client.get(listing.pageUrl(), MessageIDStreamParser::WriteCallback, &parser, &status);
+        page = listing.finishPage(result, status);
+    } while (page == GetIdListing::Page::More);
+    return page == GetIdListing::Page::Done;
+}
+
+// The listed IDs for getActualID/getActualIDAsync, without the ones already stored
+class ActualIdCollector {
+public:
+    explicit ActualIdCollector(const KnownMessageIds* known) : known(known) {}
+
+    void add(const std::string& messageID) {
+        if (known && known->contains(messageID)) {
+            ++alreadyKnown;
+            return;
+        }
+        messageIDs.push_back(messageID);
+    }
+
+    std::vector<std::string> finish(bool complete) {
+        // A partial list could make callers (e.g. the sync cursor) skip IDs that were never seen
+        if (!complete) {
+            messageIDs.clear();
+        }
+        else if (alreadyKnown > 0) {
+            std::cout << "Skipped " << alreadyKnown << " MessageIDs that are already stored" << std::endl;
+        }
+        return std::move(messageIDs);
+    }
+
+private:
+    const KnownMessageIds* known;
+    std::vector<std::string> messageIDs;
+    size_t alreadyKnown = 0;
+};
+
+// Fetches data from API and filters MessageIDs by userID; with `known`, IDs already stored are dropped too
+Task<std::vector<std::string>> getActualIDAsync(EventLoop& loop, std::string targetUserID, time_t actualTimestamp,
+    HttpClient& client = defaultHttpClient(), const KnownMessageIds* known = nullptr) {
+    ActualIdCollector collector(known);
+    bool complete = co_await streamActualIDsAsync(loop, targetUserID, actualTimestamp,
+        [&collector](const std::string& messageID) { collector.add(messageID); }, client);
+    co_return collector.finish(complete);
+}
+
+std::vector<std::string> getActualID(const std::string& targetUserID, time_t actualTimestamp, HttpClient& client = defaultHttpClient(),
+    const KnownMessageIds* known = nullptr) {
+    ActualIdCollector collector(known);
+    bool complete = streamActualIDs(targetUserID, actualTimestamp,
+        [&collector](const std::string& messageID) { collector.add(messageID); }, client);
+    return collector.finish(complete);
+}
+
+#endif // HTTPFUNC_H
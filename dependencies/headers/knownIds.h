@@ -0,0 +1,309 @@
+#ifndef KNOWNIDS_H
+#define KNOWNIDS_H
+#include <iostream>
+#include <cmath>
+#include <string>
+#include <string_view>
+#include <unordered_set>
+#include <vector>
+#include "messageId.h"
+#include "database.h"
+
+//---------------------------------------------------------------------------------------------------
+//------------------BLOOM FILTER---------------------------------------------------------------------
+//---------------------------------------------------------------------------------------------------
+// Sized for an expected count and false-positive rate; probes are derived from one 64-bit hash
+// (h1 + i*h2), so callers hash once.
+class BloomFilter {
+public:
+    explicit BloomFilter(size_t expectedItems = 1 << 20, double falsePositiveRate = 0.01) {
+        resize(expectedItems, falsePositiveRate);
+    }
+
+    void resize(size_t expectedItems, double falsePositiveRate) {
+        expectedItems = std::max<size_t>(expectedItems, 1024);
+        double ln2 = std::log(2.0);
+        size_t bitCount = static_cast<size_t>(std::ceil(-static_cast<double>(expectedItems) * std::log(falsePositiveRate) / (ln2 * ln2)));
+        bitCount = (bitCount + 63) & ~size_t(63);
+        words.assign(bitCount / 64, 0);
+        probes = std::max(1, static_cast<int>(std::round(static_cast<double>(bitCount) / expectedItems * ln2)));
+        capacity = expectedItems;
+        count = 0;
+    }
+
+    void add(uint64_t hash) {
+        uint64_t h1 = hash;
+        uint64_t h2 = mix(hash) | 1;
+        uint64_t bits = static_cast<uint64_t>(words.size()) * 64;
+        for (int i = 0; i < probes; ++i) {
+            uint64_t bit = (h1 + i * h2) % bits;
+            words[bit / 64] |= uint64_t(1) << (bit % 64);
+        }
+        ++count;
+    }
+
+    bool mayContain(uint64_t hash) const {
+        uint64_t h1 = hash;
+        uint64_t h2 = mix(hash) | 1;
+        uint64_t bits = static_cast<uint64_t>(words.size()) * 64;
+        for (int i = 0; i < probes; ++i) {
+            uint64_t bit = (h1 + i * h2) % bits;
+            if ((words[bit / 64] & (uint64_t(1) << (bit % 64))) == 0) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    // Past its expected count the filter still works, it just answers "maybe" more often
+    bool isOverfull() const { return count > capacity; }
+    size_t size() const { return count; }
+    size_t capacityItems() const { return capacity; }
+    size_t memoryBytes() const { return words.size() * sizeof(uint64_t); }
+    int probeCount() const { return probes; }
+
+    // (1 - e^(-k*n/m))^k for the current fill
+    double expectedFalsePositiveRate() const {
+        double m = static_cast<double>(words.size()) * 64;
+        return std::pow(1.0 - std::exp(-probes * static_cast<double>(count) / m), probes);
+    }
+
+    // splitmix64 finalizer: spreads any reasonable hash over all 64 bits
+    static uint64_t mix(uint64_t x) {
+        x ^= x >> 30;
+        x *= 0xBF58476D1CE4E5B9ULL;
+        x ^= x >> 27;
+        x *= 0x94D049BB133111EBULL;
+        x ^= x >> 31;
+        return x;
+    }
+
+private:
+    std::vector<uint64_t> words;
+    int probes = 1;
+    size_t capacity = 0;
+    size_t count = 0;
+};
+
+//---------------------------------------------------------------------------------------------------
+//------------------EXACT SET OF PACKED IDS----------------------------------------------------------
+//---------------------------------------------------------------------------------------------------
+// Open addressing with linear probing over a flat array of 24-byte PackedMessageIds
+// (no per-entry allocation); an empty slot is marked by EMPTY_USER. Grows at 70% load.
+class PackedIdSet {
+public:
+    static constexpr uint32_t EMPTY_USER = 0xFFFFFFFFu;
+
+    explicit PackedIdSet(size_t expectedItems = 0) { rehash(slotCountFor(expectedItems)); }
+
+    bool insert(const PackedMessageId& id, uint64_t hash) {
+        if ((count + 1) * 10 > slots.size() * 7) {
+            rehash(slots.size() * 2);
+        }
+        size_t slot = findSlot(id, hash);
+        if (slots[slot].userKey != EMPTY_USER) {
+            return false;
+        }
+        slots[slot] = id;
+        ++count;
+        return true;
+    }
+
+    bool contains(const PackedMessageId& id, uint64_t hash) const {
+        return slots[findSlot(id, hash)].userKey != EMPTY_USER;
+    }
+
+    size_t size() const { return count; }
+    size_t memoryBytes() const { return slots.size() * sizeof(PackedMessageId); }
+
+    void reserve(size_t items) {
+        size_t slotCount = slotCountFor(items);
+        if (slotCount > slots.size()) {
+            rehash(slotCount);
+        }
+    }
+
+    template <typename Visitor>
+    void forEach(Visitor&& visit) const {
+        for (const auto& id : slots) {
+            if (id.userKey != EMPTY_USER) {
+                visit(id);
+            }
+        }
+    }
+
+private:
+    static size_t slotCountFor(size_t items) {
+        size_t slotCount = 1024;
+        while (slotCount * 7 < items * 10) {
+            slotCount *= 2;
+        }
+        return slotCount;
+    }
+
+    size_t findSlot(const PackedMessageId& id, uint64_t hash) const {
+        size_t mask = slots.size() - 1;
+        size_t slot = static_cast<size_t>(BloomFilter::mix(hash)) & mask;
+        while (slots[slot].userKey != EMPTY_USER && !(slots[slot] == id)) {
+            slot = (slot + 1) & mask;
+        }
+        return slot;
+    }
+
+    void rehash(size_t slotCount) {
+        std::vector<PackedMessageId> old = std::move(slots);
+        PackedMessageId empty;
+        empty.userKey = EMPTY_USER;
+        slots.assign(slotCount, empty);
+        for (const auto& id : old) {
+            if (id.userKey != EMPTY_USER) {
+                slots[findSlot(id, PackedMessageIdHash{}(id))] = id;
+            }
+        }
+    }
+
+    std::vector<PackedMessageId> slots;
+    size_t count = 0;
+};
+
+//---------------------------------------------------------------------------------------------------
+//------------------KNOWN MESSAGEIDS-----------------------------------------------------------------
+//---------------------------------------------------------------------------------------------------
+// Every MessageID already stored in Transactions, so a sync only fetches IDs that are really new.
+// Lookups go Bloom filter first (a few cache lines, answers most new IDs), exact set second.
+// IDs that do not fit the packed form (long or non-hex suffix, or not spelled canonically, see
+// PackedMessageId) are kept as strings, so a respelled ID is never taken for the canonical one.
+class KnownMessageIds {
+public:
+    struct Stats {
+        size_t ids = 0;
+        size_t lookups = 0;
+        size_t bloomChecks = 0;
+        size_t bloomPositives = 0;   // filter said "maybe"
+        size_t falsePositives = 0;   // ... and the exact set said no
+        size_t bloomBytes = 0;
+        size_t setBytes = 0;
+        double expectedFalsePositiveRate = 0;
+    };
+
+    explicit KnownMessageIds(size_t expectedIds = 0, double falsePositiveRate = 0.01)
+        : targetRate(falsePositiveRate), bloom(expectedIds, falsePositiveRate), exact(expectedIds) {}
+
+    // Sizes both structures for `expectedIds` up front instead of growing step by step
+    void reserve(size_t expectedIds) {
+        exact.reserve(expectedIds);
+        if (bloom.capacityItems() < expectedIds) {
+            rebuildBloom(expectedIds);
+        }
+    }
+
+    // Returns false if the ID was already known
+    bool add(std::string_view messageID) {
+        auto view = MessageIdView::parse(messageID);
+        std::optional<PackedMessageId> packed;
+        if (view.has_value()) {
+            packed = PackedMessageId::pack(*view, users);
+        }
+        if (!packed.has_value()) {
+            return unpacked.emplace(messageID).second;
+        }
+
+        uint64_t hash = PackedMessageIdHash{}(*packed);
+        if (!exact.insert(*packed, hash)) {
+            return false;
+        }
+        bloom.add(hash);
+        if (bloom.isOverfull()) {
+            rebuildBloom();
+        }
+        return true;
+    }
+
+    bool contains(std::string_view messageID) const {
+        ++stats.lookups;
+        auto view = MessageIdView::parse(messageID);
+        if (!view.has_value()) {
+            return !unpacked.empty() && unpacked.count(std::string(messageID)) > 0;
+        }
+        std::optional<PackedMessageId> packed = PackedMessageId::pack(*view, static_cast<const UserInterner&>(users));
+        if (!packed.has_value()) {
+            // Unknown user, or a suffix that only the string set can hold
+            return !unpacked.empty() && unpacked.count(std::string(messageID)) > 0;
+        }
+
+        uint64_t hash = PackedMessageIdHash{}(*packed);
+        ++stats.bloomChecks;
+        if (!bloom.mayContain(hash)) {
+            return false;
+        }
+        ++stats.bloomPositives;
+        if (exact.contains(*packed, hash)) {
+            return true;
+        }
+        ++stats.falsePositives;
+        return false;
+    }
+
+    // Loads every MessageID in Transactions; returns how many were added
+    size_t loadFromDatabase(Database& db) {
+        Database::Statement countStmt = db.prepare("SELECT COUNT(*) FROM Transactions;");
+        if (countStmt && sqlite3_step(countStmt) == SQLITE_ROW) {
+            reserve(size() + static_cast<size_t>(sqlite3_column_int64(countStmt, 0)));
+        }
+
+        Database::Statement stmt = db.prepare("SELECT MessageID FROM Transactions;");
+        if (!stmt) {
+            return 0;
+        }
+        size_t added = 0;
+        int rc;
+        while ((rc = sqlite3_step(stmt)) == SQLITE_ROW) {
+            const char* text = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 0));
+            int length = sqlite3_column_bytes(stmt, 0);
+            if (text && add(std::string_view(text, static_cast<size_t>(length)))) {
+                ++added;
+            }
+        }
+        if (rc != SQLITE_DONE) {
+            std::cerr << "Execution failed: " << sqlite3_errmsg(db) << std::endl;
+        }
+        return added;
+    }
+
+    size_t size() const { return exact.size() + unpacked.size(); }
+
+    Stats statistics() const {
+        Stats result = stats;
+        result.ids = size();
+        result.bloomBytes = bloom.memoryBytes();
+        result.setBytes = exact.memoryBytes();
+        result.expectedFalsePositiveRate = bloom.expectedFalsePositiveRate();
+        return result;
+    }
+
+    void printStats() const {
+        Stats current = statistics();
+        size_t negatives = current.bloomChecks - (current.bloomPositives - current.falsePositives);
+        double measuredRate = negatives > 0 ? static_cast<double>(current.falsePositives) / negatives : 0.0;
+        double perMillion = current.ids > 0 ? (current.bloomBytes + current.setBytes) * 1e6 / current.ids / (1024 * 1024) : 0.0;
+        std::cout << "Known IDs: " << current.ids << " ids, bloom " << current.bloomBytes / 1024 << " KiB + set "
+            << current.setBytes / 1024 << " KiB (" << perMillion << " MiB per million), false positives "
+            << current.falsePositives << "/" << negatives << " = " << measuredRate * 100 << "% (expected "
+            << current.expectedFalsePositiveRate * 100 << "%)" << std::endl;
+    }
+
+private:
+    void rebuildBloom(size_t expectedIds = 0) {
+        bloom.resize(std::max(expectedIds, exact.size() * 2), targetRate);
+        exact.forEach([this](const PackedMessageId& id) { bloom.add(PackedMessageIdHash{}(id)); });
+    }
+
+    double targetRate;
+    UserInterner users;
+    BloomFilter bloom;
+    PackedIdSet exact;
+    std::unordered_set<std::string> unpacked;
+    mutable Stats stats;
+};
+
+#endif // KNOWNIDS_H
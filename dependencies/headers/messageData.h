@@ -0,0 +1,349 @@
+#ifndef MESSAGEDATA_H
+#define MESSAGEDATA_H
+#include <iostream>
+#include <string>
+#include <stdexcept>
+#include <string_view>
+#include <charconv>
+#include <cstdint>
+#include <json.hpp>
+
+struct MessageData {
+    std::string userID;
+    std::string message;
+    int categoryID;
+    double amount;
+    std::string messageID;
+    int64_t unixTimestamp;
+
+    // Method to initialize the struct from a JSON object
+    static MessageData FromJSON(const nlohmann::json& json) {
+        if (!json.contains("Item")) {
+            throw std::runtime_error("Missing 'Item' key in JSON response");
+        }
+
+        const auto& itemJson = json.at("Item");
+        MessageData data;
+
+        if (itemJson.contains("UserID")) {
+            data.userID = itemJson.at("UserID").get<std::string>();
+        }
+        else {
+            throw std::runtime_error("Missing 'UserID' key in 'Item'");
+        }
+
+        // Repeat for other fields with appropriate type conversions
+        data.message = itemJson.at("Message").get<std::string>();
+        data.categoryID = itemJson.at("CategoryID").get<int>();
+        data.amount = itemJson.at("Amount").get<double>();
+        data.messageID = itemJson.at("MessageID").get<std::string>();
+        data.unixTimestamp = itemJson.at("Unix").get<int64_t>();
+
+        return data;
+    }
+
+
+    // Single-pass decode of a /receive body straight into the fields, without building a DOM.
+    // Returns false for anything but the expected shape (all six fields, scalar values of the
+    // right kind); callers then fall back to the DOM path, which reports the actual problem.
+    static bool TryDecode(std::string_view body, MessageData& data);
+
+    // For debugging or displaying
+    void Print() const {
+        std::cout << "UserID: " << userID << "\n"
+            << "Message: " << message << "\n"
+            << "CategoryID: " << categoryID << "\n"
+            << "Amount: " << amount << "\n"
+            << "MessageID: " << messageID << "\n"
+            << "Unix Timestamp: " << unixTimestamp << std::endl;
+    }
+};
+
+//---------------------------------------------------------------------------------------------------
+//------------------TYPED /receive DECODER-----------------------------------------------------------
+//---------------------------------------------------------------------------------------------------
+// Hand-written scanner for {"Item": {"UserID": ..., ...}, ...}: one pass over the bytes, values
+// written straight into the struct, numbers read with from_chars (locale independent).
+// Keys outside "Item" and unknown keys inside it are skipped, but still validated
+// with the same grammar checks (escapes, \u surrogates, UTF-8 lead/continuation bytes, number syntax).
+class MessageDataDecoder {
+public:
+    MessageDataDecoder(std::string_view body, MessageData& data)
+        : pos(body.data()), end(body.data() + body.size()), data(data) {}
+
+    bool decode() {
+        if (!consume('{')) return false;
+        if (consume('}')) return false;  // no "Item"
+        do {
+            std::string_view name;
+            if (!rawKey(name)) return false;
+            if (name == "Item") {
+                if (!item()) return false;
+            }
+            else if (!skipValue(0)) {
+                return false;
+            }
+        } while (consume(','));
+        if (!consume('}')) return false;
+        skipWhitespace();
+        return pos == end && seenFields == ALL_FIELDS;
+    }
+
+private:
+    static constexpr unsigned ALL_FIELDS = 0x3F;
+    static constexpr int MAX_SKIP_DEPTH = 64;
+
+    bool item() {
+        if (!consume('{')) return false;
+        if (consume('}')) return true;
+        do {
+            std::string_view name;
+            if (!rawKey(name)) return false;
+            bool ok;
+            if (name == "UserID") ok = string(data.userID) && seen(0);
+            else if (name == "Message") ok = string(data.message) && seen(1);
+            else if (name == "CategoryID") ok = integer(data.categoryID) && seen(2);
+            else if (name == "Amount") ok = number(data.amount) && seen(3);
+            else if (name == "MessageID") ok = string(data.messageID) && seen(4);
+            else if (name == "Unix") ok = integer(data.unixTimestamp) && seen(5);
+            else ok = skipValue(0);
+            if (!ok) return false;
+        } while (consume(','));
+        return consume('}');
+    }
+
+    bool seen(int bit) {
+        seenFields |= 1u << bit;
+        return true;
+    }
+
+    void skipWhitespace() {
+        while (pos < end && (*pos == ' ' || *pos == '\n' || *pos == '\r' || *pos == '\t')) {
+            ++pos;
+        }
+    }
+
+    bool consume(char c) {
+        skipWhitespace();
+        if (pos < end && *pos == c) {
+            ++pos;
+            return true;
+        }
+        return false;
+    }
+
+    // Key followed by ':'; keys with escapes are left to the DOM path
+    bool rawKey(std::string_view& name) {
+        if (!consume('"')) return false;
+        const char* start = pos;
+        while (pos < end && *pos != '"') {
+            unsigned char c = static_cast<unsigned char>(*pos);
+            if (c == '\\' || c < 0x20) return false;
+            if (c < 0x80) {
+                ++pos;
+            }
+            else if (!utf8Sequence()) {
+                return false;
+            }
+        }
+        if (pos == end) return false;
+        name = std::string_view(start, pos - start);
+        ++pos;
+        return consume(':');
+    }
+
+    bool string(std::string& out) {
+        if (!consume('"')) return false;
+        out.clear();
+        for (;;) {
+            // Copy the run up to the next quote/escape in one go
+            const char* run = pos;
+            while (pos < end && *pos != '"' && *pos != '\\') {
+                unsigned char c = static_cast<unsigned char>(*pos);
+                if (c < 0x20) return false;
+                if (c < 0x80) {
+                    ++pos;
+                }
+                else if (!utf8Sequence()) {
+                    return false;
+                }
+            }
+            out.append(run, pos - run);
+            if (pos == end) return false;
+            if (*pos++ == '"') return true;
+            if (!escape(out)) return false;
+        }
+    }
+
+    bool utf8Sequence() {
+        unsigned char lead = static_cast<unsigned char>(*pos);
+        int length = (lead >= 0xC2 && lead <= 0xDF) ? 2 : (lead >= 0xE0 && lead <= 0xEF) ? 3 : (lead >= 0xF0 && lead <= 0xF4) ? 4 : 0;
+        if (length == 0 || end - pos < length) return false;
+        for (int i = 1; i < length; ++i) {
+            if ((static_cast<unsigned char>(pos[i]) & 0xC0) != 0x80) return false;
+        }
+        // Reject overlong forms, UTF-16 surrogates and code points past U+10FFFF
+        unsigned char second = static_cast<unsigned char>(pos[1]);
+        if ((lead == 0xE0 && second < 0xA0) || (lead == 0xED && second > 0x9F)
+            || (lead == 0xF0 && second < 0x90) || (lead == 0xF4 && second > 0x8F)) {
+            return false;
+        }
+        pos += length;
+        return true;
+    }
+
+    bool escape(std::string& out) {
+        if (pos == end) return false;
+        switch (*pos++) {
+        case '"': out += '"'; return true;
+        case '\\': out += '\\'; return true;
+        case '/': out += '/'; return true;
+        case 'b': out += '\b'; return true;
+        case 'f': out += '\f'; return true;
+        case 'n': out += '\n'; return true;
+        case 'r': out += '\r'; return true;
+        case 't': out += '\t'; return true;
+        case 'u': break;
+        default: return false;
+        }
+
+        uint32_t codePoint;
+        if (!hex4(codePoint)) return false;
+        if (codePoint >= 0xD800 && codePoint <= 0xDBFF) {
+            uint32_t low;
+            if (end - pos < 2 || pos[0] != '\\' || pos[1] != 'u') return false;
+            pos += 2;
+            if (!hex4(low) || low < 0xDC00 || low > 0xDFFF) return false;
+            codePoint = 0x10000 + ((codePoint - 0xD800) << 10) + (low - 0xDC00);
+        }
+        else if (codePoint >= 0xDC00 && codePoint <= 0xDFFF) {
+            return false;
+        }
+
+        if (codePoint < 0x80) {
+            out += static_cast<char>(codePoint);
+        }
+        else if (codePoint < 0x800) {
+            out += static_cast<char>(0xC0 | (codePoint >> 6));
+            out += static_cast<char>(0x80 | (codePoint & 0x3F));
+        }
+        else if (codePoint < 0x10000) {
+            out += static_cast<char>(0xE0 | (codePoint >> 12));
+            out += static_cast<char>(0x80 | ((codePoint >> 6) & 0x3F));
+            out += static_cast<char>(0x80 | (codePoint & 0x3F));
+        }
+        else {
+            out += static_cast<char>(0xF0 | (codePoint >> 18));
+            out += static_cast<char>(0x80 | ((codePoint >> 12) & 0x3F));
+            out += static_cast<char>(0x80 | ((codePoint >> 6) & 0x3F));
+            out += static_cast<char>(0x80 | (codePoint & 0x3F));
+        }
+        return true;
+    }
+
+    bool hex4(uint32_t& value) {
+        if (end - pos < 4) return false;
+        auto [next, error] = std::from_chars(pos, pos + 4, value, 16);
+        if (error != std::errc() || next != pos + 4) return false;
+        pos = next;
+        return true;
+    }
+
+    // JSON number token: -?(0|[1-9][0-9]*)(.[0-9]+)?([eE][+-]?[0-9]+)?
+    bool numberToken(std::string_view& token) {
+        skipWhitespace();
+        const char* start = pos;
+        if (pos < end && *pos == '-') ++pos;
+        if (pos < end && *pos == '0') {
+            ++pos;
+        }
+        else if (!digits()) {
+            return false;
+        }
+        if (pos < end && *pos == '.') {
+            ++pos;
+            if (!digits()) return false;
+        }
+        if (pos < end && (*pos == 'e' || *pos == 'E')) {
+            ++pos;
+            if (pos < end && (*pos == '+' || *pos == '-')) ++pos;
+            if (!digits()) return false;
+        }
+        token = std::string_view(start, pos - start);
+        return true;
+    }
+
+    bool digits() {
+        const char* start = pos;
+        while (pos < end && *pos >= '0' && *pos <= '9') {
+            ++pos;
+        }
+        return pos != start;
+    }
+
+    template <typename Integer>
+    bool integer(Integer& out) {
+        std::string_view token;
+        if (!numberToken(token)) return false;
+        auto [next, error] = std::from_chars(token.data(), token.data() + token.size(), out);
+        return error == std::errc() && next == token.data() + token.size();  // 3.0 or 1e3 go to the DOM path
+    }
+
+    bool number(double& out) {
+        std::string_view token;
+        if (!numberToken(token)) return false;
+        auto [next, error] = std::from_chars(token.data(), token.data() + token.size(), out);
+        return error == std::errc() && next == token.data() + token.size();
+    }
+
+    bool skipValue(int depth) {
+        skipWhitespace();
+        if (pos == end || depth > MAX_SKIP_DEPTH) return false;
+        switch (*pos) {
+        case '"': {
+            skipped.clear();
+            return string(skipped);
+        }
+        case '{':
+            ++pos;
+            if (consume('}')) return true;
+            do {
+                std::string_view name;
+                if (!rawKey(name) || !skipValue(depth + 1)) return false;
+            } while (consume(','));
+            return consume('}');
+        case '[':
+            ++pos;
+            if (consume(']')) return true;
+            do {
+                if (!skipValue(depth + 1)) return false;
+            } while (consume(','));
+            return consume(']');
+        case 't': return literal("true");
+        case 'f': return literal("false");
+        case 'n': return literal("null");
+        default: {
+            std::string_view token;
+            return numberToken(token);
+        }
+        }
+    }
+
+    bool literal(std::string_view word) {
+        if (static_cast<size_t>(end - pos) < word.size() || std::string_view(pos, word.size()) != word) return false;
+        pos += word.size();
+        return true;
+    }
+
+    const char* pos;
+    const char* end;
+    MessageData& data;
+    std::string skipped;
+    unsigned seenFields = 0;
+};
+
+bool MessageData::TryDecode(std::string_view body, MessageData& data) {
+    return MessageDataDecoder(body, data).decode();
+}
+
+#endif // MESSAGEDATA_H
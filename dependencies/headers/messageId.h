@@ -0,0 +1,221 @@
+#ifndef MESSAGEID_H
+#define MESSAGEID_H
+#include <array>
+#include <charconv>
+#include <compare>
+#include <cstdint>
+#include <limits>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+#include "base64.h"
+
+//---------------------------------------------------------------------------------------------------
+//------------------MESSAGEID PARSING----------------------------------------------------------------
+//---------------------------------------------------------------------------------------------------
+// MessageID = base64url(userID) "_" hex(unix timestamp) "_" random hex.
+// MessageIdView splits an ID without copying: the segments point into the caller's string,
+// which must outlive the view. Parsing never allocates and never throws.
+// The separators are searched from the right, since '_' is also a base64url character.
+struct MessageIdView {
+    std::string_view encodedUser;   // base64url, as it appears in the ID
+    std::string_view timestampHex;  // as it appears in the ID; may have leading zeros or uppercase digits
+    int64_t timestamp = 0;
+    std::string_view randomHex;
+
+    static std::optional<MessageIdView> parse(std::string_view messageID) noexcept {
+        size_t secondUnderscore = messageID.rfind('_');
+        if (secondUnderscore == std::string_view::npos || secondUnderscore == 0) {
+            return std::nullopt;
+        }
+        size_t firstUnderscore = messageID.rfind('_', secondUnderscore - 1);
+        if (firstUnderscore == std::string_view::npos || firstUnderscore == 0) {
+            return std::nullopt;
+        }
+
+        const char* first = messageID.data() + firstUnderscore + 1;
+        const char* last = messageID.data() + secondUnderscore;
+        uint64_t timestamp = 0;
+        auto [end, error] = std::from_chars(first, last, timestamp, 16);
+        if (error != std::errc() || end != last || first == last
+            || timestamp > static_cast<uint64_t>(std::numeric_limits<int64_t>::max())) {
+            return std::nullopt;
+        }
+
+        MessageIdView view;
+        view.encodedUser = messageID.substr(0, firstUnderscore);
+        view.timestampHex = messageID.substr(firstUnderscore + 1, secondUnderscore - firstUnderscore - 1);
+        view.timestamp = static_cast<int64_t>(timestamp);
+        view.randomHex = messageID.substr(secondUnderscore + 1);
+        return view;
+    }
+
+    // Compares against a user ID encoded once with Base64UrlEncode(); no decoding per ID
+    bool hasEncodedUser(std::string_view encodedTarget) const noexcept {
+        std::string_view user = encodedUser;
+        while (!user.empty() && user.back() == '=') {
+            user.remove_suffix(1);
+        }
+        return user == encodedTarget;
+    }
+
+    std::string decodeUser() const {
+        std::string userID(Base64UrlMaxDecodedSize(encodedUser.size()), '\0');
+        auto written = Base64UrlDecode(encodedUser, userID.data());
+        if (!written.has_value()) {
+            return std::string();
+        }
+        userID.resize(*written);
+        return userID;
+    }
+};
+
+//---------------------------------------------------------------------------------------------------
+//------------------PACKED MESSAGEID-----------------------------------------------------------------
+//---------------------------------------------------------------------------------------------------
+// Interns encoded user segments as small integer keys, so packed IDs stay fixed-size.
+// Keys are stable for the interner's lifetime and only meaningful within it.
+class UserInterner {
+public:
+    uint32_t intern(std::string_view encodedUser) {
+        auto it = keys.find(encodedUser);
+        if (it != keys.end()) {
+            return it->second;
+        }
+        uint32_t key = static_cast<uint32_t>(users.size());
+        users.emplace_back(encodedUser);
+        keys.emplace(users.back(), key);
+        return key;
+    }
+
+    std::optional<uint32_t> find(std::string_view encodedUser) const {
+        auto it = keys.find(encodedUser);
+        if (it == keys.end()) {
+            return std::nullopt;
+        }
+        return it->second;
+    }
+
+    std::string_view encodedUser(uint32_t key) const { return users[key]; }
+    size_t size() const { return users.size(); }
+
+private:
+    struct UserHash {
+        using is_transparent = void;
+        size_t operator()(std::string_view user) const { return std::hash<std::string_view>{}(user); }
+    };
+
+    std::vector<std::string> users;
+    std::unordered_map<std::string, uint32_t, UserHash, std::equal_to<>> keys;
+};
+
+// 24-byte value form of a MessageID: ordered by timestamp, then user, then random suffix.
+// The random suffix is kept as packed nibbles plus its digit count, so its leading zeros survive.
+// Only the canonical spelling packs: lowercase hex and a timestamp without leading zeros. That is
+// what the API issues, and it makes toString() give back exactly the parsed ID, so two packed IDs
+// are equal only if the strings are. Callers keep any other spelling as a string.
+struct PackedMessageId {
+    static constexpr size_t MAX_RANDOM_DIGITS = 16;
+
+    int64_t timestamp = 0;
+    uint32_t userKey = 0;
+    uint8_t randomDigits = 0;
+    std::array<uint8_t, MAX_RANDOM_DIGITS / 2> random{};
+
+    auto operator<=>(const PackedMessageId&) const = default;
+
+    // Fails (nullopt) for a non-canonical ID or a random suffix longer than MAX_RANDOM_DIGITS
+    static std::optional<PackedMessageId> pack(const MessageIdView& view, UserInterner& users) {
+        PackedMessageId packed;
+        if (!packSuffix(view, packed)) {
+            return std::nullopt;
+        }
+        packed.userKey = users.intern(view.encodedUser);
+        return packed;
+    }
+
+    // Lookup form: never adds a user, so an ID of a user the interner has not seen gives nullopt
+    static std::optional<PackedMessageId> pack(const MessageIdView& view, const UserInterner& users) {
+        auto userKey = users.find(view.encodedUser);
+        if (!userKey.has_value()) {
+            return std::nullopt;
+        }
+        PackedMessageId packed;
+        if (!packSuffix(view, packed)) {
+            return std::nullopt;
+        }
+        packed.userKey = *userKey;
+        return packed;
+    }
+
+    std::string toString(const UserInterner& users) const {
+        constexpr char digits[] = "0123456789abcdef";
+        std::string messageID(users.encodedUser(userKey));
+        messageID += '_';
+
+        char buffer[16];
+        auto [end, error] = std::to_chars(buffer, buffer + sizeof(buffer), static_cast<uint64_t>(timestamp), 16);
+        messageID.append(buffer, end);
+        messageID += '_';
+
+        for (size_t i = 0; i < randomDigits; ++i) {
+            uint8_t byte = random[i / 2];
+            messageID += digits[(i % 2 == 0) ? byte >> 4 : byte & 0x0F];
+        }
+        return messageID;
+    }
+
+private:
+    static bool packSuffix(const MessageIdView& view, PackedMessageId& packed) {
+        if (view.randomHex.size() > MAX_RANDOM_DIGITS || !isCanonicalTimestamp(view.timestampHex)) {
+            return false;
+        }
+        for (size_t i = 0; i < view.randomHex.size(); ++i) {
+            int nibble = hexValue(view.randomHex[i]);
+            if (nibble < 0) {
+                return false;
+            }
+            packed.random[i / 2] |= static_cast<uint8_t>((i % 2 == 0) ? nibble << 4 : nibble);
+        }
+        packed.timestamp = view.timestamp;
+        packed.randomDigits = static_cast<uint8_t>(view.randomHex.size());
+        return true;
+    }
+
+    // Lowercase only: an uppercase digit would come back lowercase from toString()
+    static int hexValue(char c) {
+        if (c >= '0' && c <= '9') return c - '0';
+        if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+        return -1;
+    }
+
+    // As std::to_chars writes it: no leading zero unless the value is 0, no uppercase digit
+    static bool isCanonicalTimestamp(std::string_view hex) {
+        if (hex.size() > 1 && hex.front() == '0') {
+            return false;
+        }
+        for (char c : hex) {
+            if (hexValue(c) < 0) {
+                return false;
+            }
+        }
+        return true;
+    }
+};
+
+struct PackedMessageIdHash {
+    size_t operator()(const PackedMessageId& id) const {
+        uint64_t random = 0;
+        for (uint8_t byte : id.random) {
+            random = (random << 8) | byte;
+        }
+        uint64_t h = static_cast<uint64_t>(id.timestamp) * 0x9E3779B97F4A7C15ULL;
+        h ^= (static_cast<uint64_t>(id.userKey) << 8 | id.randomDigits) + 0x9E3779B97F4A7C15ULL + (h << 6) + (h >> 2);
+        h ^= random + 0x9E3779B97F4A7C15ULL + (h << 6) + (h >> 2);
+        return static_cast<size_t>(h);
+    }
+};
+
+#endif // MESSAGEID_H
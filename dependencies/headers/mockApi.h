@@ -0,0 +1,657 @@
+#ifndef MOCKAPI_H
+#define MOCKAPI_H
+#include <iostream>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <unordered_map>
+#include <random>
+#include <thread>
+#include <atomic>
+#include <mutex>
+#include <chrono>
+#include <algorithm>
+#include <cstring>
+#include <charconv>
+#include <curl/curl.h>
+#include <json.hpp>
+#ifdef _WIN32
+#include <winsock2.h>
+#else
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <poll.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+#include "messageData.h"
+#include "base64.h"
+#include "messageId.h"
+#include "responseCache.h"
+
+//---------------------------------------------------------------------------------------------------
+//------------------MOCK API CORPUS------------------------------------------------------------------
+//---------------------------------------------------------------------------------------------------
+// The messages a mock API serves: /getid lists ids in order (or one user's, see MockApiServer),
+// /receive returns bodies[id].
+// A corpus is either synthetic (deterministic for a seed) or replayed from a ResponseCache,
+// which records every response septim fetched from the real API.
+struct MockCorpus {
+    std::vector<std::string> ids;
+    std::unordered_map<std::string, std::string> bodies;   // MessageID -> /receive body
+
+    void add(const MessageData& data) {
+        nlohmann::json item = {
+            { "UserID", data.userID },
+            { "Message", data.message },
+            { "CategoryID", data.categoryID },
+            { "Amount", data.amount },
+            { "MessageID", data.messageID },
+            { "Unix", data.unixTimestamp }
+        };
+        if (bodies.emplace(data.messageID, nlohmann::json{ { "Item", item } }.dump()).second) {
+            ids.push_back(data.messageID);
+        }
+    }
+
+    size_t size() const { return ids.size(); }
+
+    // `messages` messages spread over `users` users ("Draybin" first, so the default sync finds data)
+    // and one year of timestamps in increasing order
+    static MockCorpus synthetic(size_t messages, size_t users = 10, uint64_t seed = 1) {
+        MockCorpus corpus;
+        users = std::max<size_t>(users, 1);
+        std::vector<std::string> userIDs{ "Draybin" };
+        for (size_t u = 1; u < users; ++u) {
+            userIDs.push_back("user" + std::to_string(u + 1));
+        }
+
+        std::mt19937_64 random(seed);
+        const int64_t firstTimestamp = 1735689600;   // 2025-01-01 00:00:00 UTC
+        const int64_t span = 365LL * 24 * 3600;
+        corpus.ids.reserve(messages);
+        corpus.bodies.reserve(messages);
+        for (size_t i = 0; i < messages; ++i) {
+            MessageData data;
+            data.userID = userIDs[random() % userIDs.size()];
+            data.unixTimestamp = firstTimestamp + static_cast<int64_t>(i * span / std::max<size_t>(messages, 1));
+            data.categoryID = static_cast<int>(random() % 8) + 1;
+            data.amount = static_cast<double>(static_cast<int64_t>(random() % 100000) - 50000) / 100.0;
+            data.message = "Synthetic message " + std::to_string(i + 1);
+
+            // base64url(user) _ hex timestamp _ four hex digits, like the real IDs
+            constexpr char digits[] = "0123456789abcdef";
+            char timestamp[16];
+            auto [timestampEnd, error] = std::to_chars(timestamp, timestamp + sizeof(timestamp), static_cast<uint64_t>(data.unixTimestamp), 16);
+            data.messageID = Base64UrlEncode(data.userID) + "_" + std::string(timestamp, timestampEnd) + "_";
+            uint64_t suffix = random();
+            for (int shift = 12; shift >= 0; shift -= 4) {
+                data.messageID += digits[(suffix >> shift) & 0xF];
+            }
+            corpus.add(data);
+        }
+        return corpus;
+    }
+
+    // Replays what a ResponseCache recorded from earlier syncs
+    static MockCorpus fromCache(ResponseCache& cache) {
+        MockCorpus corpus;
+        for (const auto& messageID : cache.messageIDs()) {
+            if (auto data = cache.get(messageID)) {
+                corpus.add(*data);
+            }
+        }
+        return corpus;
+    }
+};
+
+//---------------------------------------------------------------------------------------------------
+//------------------MOCK API SERVER------------------------------------------------------------------
+//---------------------------------------------------------------------------------------------------
+// Minimal HTTP/1.1 server for /getid and /receive (any path prefix, e.g. /production/receive) on
+// 127.0.0.1, one background thread, keep-alive connections. Every response can be shaped:
+//   latency +- jitter   delay before the first byte (uniform jitter)
+//   bandwidth           bytes per second per connection while sending (0 = unlimited)
+//   errorRate           share of /receive requests answered 500
+//   throttleRate        share of /receive requests answered 429 (with Retry-After when set)
+//   maxRequestsPerSecond  token bucket over /receive, like a gateway's rate limit: a request
+//                       finding the bucket empty is answered 429 (with Retry-After when set);
+//                       the bucket holds burstRequests tokens (0 = a tenth of a second's worth)
+// /getid is the reference for the filtered listing: with user (base64url user segment), since
+// (unix seconds) and limit it returns that user's IDs from `since` on, ordered by timestamp then
+// ID, at most `limit` per page plus a NextToken (the page's last ID) to pass back as `after`.
+// Without parameters, or with ignoreGetIdFilters, it returns the full list like the old API.
+// The random choices come from one seeded generator, so a run is repeatable request for request
+// (their order still depends on the client's timing).
+struct MockApiSettings {
+    uint16_t port = 0;                       // 0 = any free port, see MockApiServer::port()
+    std::chrono::milliseconds latency{ 0 };
+    std::chrono::milliseconds jitter{ 0 };
+    size_t bandwidth = 0;
+    double errorRate = 0.0;
+    double throttleRate = 0.0;
+    int retryAfterSeconds = 0;               // 0 = no Retry-After header on 429
+    double maxRequestsPerSecond = 0.0;       // 0 = no rate limit
+    size_t burstRequests = 0;
+    bool ignoreGetIdFilters = false;         // behave like an API without /getid query parameters
+    uint64_t seed = 1;
+};
+
+class MockApiServer {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    struct Stats {
+        size_t connections = 0;
+        size_t requests = 0;
+        size_t notFound = 0;
+        size_t filteredListings = 0;   // /getid pages answered with filters applied
+        size_t injectedErrors = 0;
+        size_t throttled = 0;
+        size_t rateLimited = 0;        // 429s from the token bucket
+        size_t bodiesServed = 0;       // /receive answered 200
+        uint64_t bytesSent = 0;
+    };
+
+    MockApiServer(MockCorpus corpus, MockApiSettings settings = MockApiSettings())
+        : corpus(std::move(corpus)), settings(settings), random(settings.seed) {}
+
+    ~MockApiServer() { stop(); }
+
+    MockApiServer(const MockApiServer&) = delete;
+    MockApiServer& operator=(const MockApiServer&) = delete;
+
+    // Binds and starts serving on a background thread; false if the port could not be bound
+    bool start() {
+        // Winsock is initialized by curl_global_init in main
+        listener = socket(AF_INET, SOCK_STREAM, 0);
+        if (listener == CURL_SOCKET_BAD) {
+            std::cerr << "Mock API: failed to create socket" << std::endl;
+            return false;
+        }
+        int reuse = 1;
+        setsockopt(listener, SOL_SOCKET, SO_REUSEADDR, reinterpret_cast<const char*>(&reuse), sizeof(reuse));
+
+        sockaddr_in address{};
+        address.sin_family = AF_INET;
+        address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        address.sin_port = htons(settings.port);
+#ifdef _WIN32
+        int length = sizeof(address);
+#else
+        socklen_t length = sizeof(address);
+#endif
+        if (bind(listener, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0
+            || listen(listener, SOMAXCONN) != 0
+            || getsockname(listener, reinterpret_cast<sockaddr*>(&address), &length) != 0) {
+            std::cerr << "Mock API: cannot listen on port " << settings.port << std::endl;
+            closeSocket(listener);
+            listener = CURL_SOCKET_BAD;
+            return false;
+        }
+        boundPort = ntohs(address.sin_port);
+        setNonBlocking(listener);
+
+        stopping = false;
+        worker = std::thread([this] { serve(); });
+        return true;
+    }
+
+    void stop() {
+        if (!worker.joinable()) {
+            return;
+        }
+        stopping = true;
+        worker.join();
+        for (auto& connection : connections) {
+            closeSocket(connection.socket);
+        }
+        connections.clear();
+        closeSocket(listener);
+        listener = CURL_SOCKET_BAD;
+    }
+
+    uint16_t port() const { return boundPort; }
+    std::string baseUrl() const { return "http://127.0.0.1:" + std::to_string(boundPort); }
+    const MockCorpus& messages() const { return corpus; }
+
+    Stats statistics() const {
+        std::lock_guard<std::mutex> lock(statsMutex);
+        return stats;
+    }
+
+    void printStats() const {
+        Stats current = statistics();
+        std::cout << "Mock API: " << current.requests << " requests on " << current.connections << " connections, "
+            << current.filteredListings << " filtered /getid pages, " << current.notFound << " not found, " << current.injectedErrors << " injected 500s, "
+            << current.throttled << " injected 429s, " << current.rateLimited << " rate-limited, " << current.bytesSent / 1024 << " KiB sent" << std::endl;
+    }
+
+private:
+    struct Connection {
+        curl_socket_t socket = CURL_SOCKET_BAD;
+        std::string input;
+        std::string output;
+        size_t sent = 0;
+        bool responding = false;
+        bool closeAfter = false;
+        Clock::time_point readyAt;   // first byte may go out at this time
+    };
+
+    void serve() {
+#ifdef _WIN32
+        std::vector<WSAPOLLFD> pollSet;
+#else
+        std::vector<pollfd> pollSet;
+#endif
+        while (!stopping) {
+            auto now = Clock::now();
+            int timeoutMs = 50;   // also how quickly stop() is noticed
+            pollSet.clear();
+            pollSet.push_back({});
+            pollSet.back().fd = listener;
+            pollSet.back().events = POLLIN;
+            for (const auto& connection : connections) {
+                pollSet.push_back({});
+                pollSet.back().fd = connection.socket;
+                if (!connection.responding) {
+                    pollSet.back().events = POLLIN;
+                }
+                else if (now < connection.readyAt) {
+                    auto wait = std::chrono::duration_cast<std::chrono::milliseconds>(connection.readyAt - now).count() + 1;
+                    timeoutMs = std::min<int>(timeoutMs, static_cast<int>(wait));
+                }
+                else if (settings.bandwidth > 0 && allowedBytes(connection, now) <= connection.sent) {
+                    timeoutMs = std::min(timeoutMs, 2);
+                }
+                else {
+                    pollSet.back().events = POLLOUT;
+                }
+            }
+
+#ifdef _WIN32
+            WSAPoll(pollSet.data(), static_cast<ULONG>(pollSet.size()), timeoutMs);
+#else
+            poll(pollSet.data(), pollSet.size(), timeoutMs);
+#endif
+            now = Clock::now();
+            if (pollSet[0].revents & POLLIN) {
+                acceptConnections(now);
+            }
+            // Connections accepted just now are past the end of pollSet and wait for the next round
+            for (size_t i = 1; i < pollSet.size(); ++i) {
+                Connection& connection = connections[i - 1];
+                short revents = pollSet[i].revents;
+                if (revents & (POLLERR | POLLHUP | POLLNVAL)) {
+                    connection.closeAfter = true;
+                    connection.responding = false;
+                    connection.output.clear();
+                }
+                else if (revents & POLLIN) {
+                    readRequest(connection, now);
+                }
+                else if (revents & POLLOUT) {
+                    writeResponse(connection, now);
+                }
+            }
+
+            // Drop closed connections; keep-alive ones stay for the client's next request
+            auto closed = std::remove_if(connections.begin(), connections.end(), [this](Connection& connection) {
+                if (connection.closeAfter && !connection.responding) {
+                    closeSocket(connection.socket);
+                    return true;
+                }
+                return false;
+            });
+            connections.erase(closed, connections.end());
+        }
+    }
+
+    void acceptConnections(Clock::time_point now) {
+        while (true) {
+            curl_socket_t client = accept(listener, nullptr, nullptr);
+            if (client == CURL_SOCKET_BAD) {
+                return;
+            }
+            setNonBlocking(client);
+            Connection connection;
+            connection.socket = client;
+            connection.readyAt = now;
+            connections.push_back(std::move(connection));
+            std::lock_guard<std::mutex> lock(statsMutex);
+            ++stats.connections;
+        }
+    }
+
+    void readRequest(Connection& connection, Clock::time_point now) {
+        char buffer[4096];
+        int received = static_cast<int>(recv(connection.socket, buffer, static_cast<int>(sizeof(buffer)), 0));
+        if (received <= 0) {
+            connection.closeAfter = true;
+            return;
+        }
+        connection.input.append(buffer, static_cast<size_t>(received));
+        startNextResponse(connection, now);
+    }
+
+    // Builds the response for the first complete request in the input buffer, if there is one
+    void startNextResponse(Connection& connection, Clock::time_point now) {
+        size_t headerEnd = connection.input.find("\r\n\r\n");
+        if (headerEnd == std::string::npos) {
+            if (connection.input.size() > 64 * 1024) {
+                connection.closeAfter = true;
+            }
+            return;
+        }
+        std::string_view request(connection.input.data(), headerEnd);
+        size_t lineEnd = request.find("\r\n");
+        std::string_view requestLine = request.substr(0, lineEnd);
+        std::string_view headers = lineEnd == std::string_view::npos ? std::string_view() : request.substr(lineEnd);
+
+        size_t methodEnd = requestLine.find(' ');
+        size_t targetEnd = requestLine.rfind(' ');
+        std::string_view target = (methodEnd == std::string_view::npos || targetEnd <= methodEnd)
+            ? std::string_view() : requestLine.substr(methodEnd + 1, targetEnd - methodEnd - 1);
+        connection.closeAfter = headers.find("Connection: close") != std::string_view::npos
+            || headers.find("connection: close") != std::string_view::npos;
+
+        int status = 200;
+        std::string body = handle(target, status);
+        connection.input.erase(0, headerEnd + 4);
+
+        connection.output = "HTTP/1.1 " + std::to_string(status) + " " + reasonPhrase(status) + "\r\n"
+            "Content-Type: application/json\r\n"
+            "Content-Length: " + std::to_string(body.size()) + "\r\n";
+        if (status == 429 && settings.retryAfterSeconds > 0) {
+            connection.output += "Retry-After: " + std::to_string(settings.retryAfterSeconds) + "\r\n";
+        }
+        connection.output += connection.closeAfter ? "Connection: close\r\n\r\n" : "\r\n";
+        connection.output += body;
+        connection.sent = 0;
+        connection.responding = true;
+        connection.readyAt = now + responseDelay();
+    }
+
+    void writeResponse(Connection& connection, Clock::time_point now) {
+        size_t limit = connection.output.size();
+        if (settings.bandwidth > 0) {
+            limit = std::min(limit, allowedBytes(connection, now));
+        }
+        if (limit <= connection.sent) {
+            return;
+        }
+#ifdef MSG_NOSIGNAL
+        int flags = MSG_NOSIGNAL;
+#else
+        int flags = 0;
+#endif
+        int written = static_cast<int>(send(connection.socket, connection.output.data() + connection.sent,
+            static_cast<int>(limit - connection.sent), flags));
+        if (written <= 0) {
+            connection.closeAfter = true;
+            connection.responding = false;
+            return;
+        }
+        connection.sent += static_cast<size_t>(written);
+        {
+            std::lock_guard<std::mutex> lock(statsMutex);
+            stats.bytesSent += static_cast<uint64_t>(written);
+        }
+        if (connection.sent == connection.output.size()) {
+            connection.responding = false;
+            connection.output.clear();
+            if (!connection.closeAfter) {
+                startNextResponse(connection, now);   // a pipelined request may already be waiting
+            }
+        }
+    }
+
+    // Bytes the bandwidth limit allows to have been sent since the response became ready
+    size_t allowedBytes(const Connection& connection, Clock::time_point now) const {
+        double elapsed = std::chrono::duration<double>(now - connection.readyAt).count();
+        return static_cast<size_t>(std::max(elapsed, 0.0) * static_cast<double>(settings.bandwidth)) + 1;
+    }
+
+    Clock::duration responseDelay() {
+        auto delay = std::chrono::duration_cast<Clock::duration>(settings.latency);
+        if (settings.jitter.count() > 0) {
+            std::uniform_int_distribution<int64_t> spread(-settings.jitter.count(), settings.jitter.count());
+            delay += std::chrono::milliseconds(spread(random));
+        }
+        return std::max(delay, Clock::duration::zero());
+    }
+
+    std::string handle(std::string_view target, int& status) {
+        size_t queryStart = target.find('?');
+        std::string_view path = target.substr(0, queryStart);
+        std::string_view query = queryStart == std::string_view::npos ? std::string_view() : target.substr(queryStart + 1);
+
+        std::lock_guard<std::mutex> lock(statsMutex);
+        ++stats.requests;
+        if (path.ends_with("/getid")) {
+            if (query.empty() || settings.ignoreGetIdFilters) {
+                return idList();
+            }
+            ++stats.filteredListings;
+            return filteredIdList(query);
+        }
+        if (path.ends_with("/receive")) {
+            if (!takeToken()) {
+                ++stats.rateLimited;
+                status = 429;
+                return "{\"message\": \"Too Many Requests\"}";
+            }
+            std::uniform_real_distribution<double> chance(0.0, 1.0);
+            double roll = chance(random);
+            if (roll < settings.errorRate) {
+                ++stats.injectedErrors;
+                status = 500;
+                return "{\"message\": \"Internal server error\"}";
+            }
+            if (roll < settings.errorRate + settings.throttleRate) {
+                ++stats.throttled;
+                status = 429;
+                return "{\"message\": \"Too Many Requests\"}";
+            }
+            auto it = corpus.bodies.find(queryValue(query, "message_id"));
+            if (it != corpus.bodies.end()) {
+                ++stats.bodiesServed;
+                return it->second;
+            }
+        }
+        ++stats.notFound;
+        status = 404;
+        return "{\"message\": \"Not Found\"}";
+    }
+
+    // Token bucket for maxRequestsPerSecond, refilled by the time since the last request
+    bool takeToken() {
+        if (settings.maxRequestsPerSecond <= 0) {
+            return true;
+        }
+        double capacity = settings.burstRequests > 0
+            ? static_cast<double>(settings.burstRequests) : std::max(1.0, settings.maxRequestsPerSecond / 10);
+        auto now = Clock::now();
+        if (bucketFilledAt == Clock::time_point{}) {
+            bucketTokens = capacity;
+        }
+        else {
+            bucketTokens += std::chrono::duration<double>(now - bucketFilledAt).count() * settings.maxRequestsPerSecond;
+            bucketTokens = std::min(bucketTokens, capacity);
+        }
+        bucketFilledAt = now;
+        if (bucketTokens < 1.0) {
+            return false;
+        }
+        bucketTokens -= 1.0;
+        return true;
+    }
+
+    // The whole /getid document is rendered once and reused
+    const std::string& idList() {
+        if (idListBody.empty()) {
+            idListBody = nlohmann::json{ { "MessageIDs", corpus.ids } }.dump();
+        }
+        return idListBody;
+    }
+
+    // A /getid page: IDs of `user` (all users if absent) with timestamp >= since, after the `after`
+    // cursor, at most `limit` of them. Per-user lists are sorted once, so a page costs
+    // O(log n + limit) whatever the size of the corpus.
+    std::string filteredIdList(std::string_view query) {
+        if (userListings.empty()) {
+            buildListings();
+        }
+        std::string user = queryValue(query, "user");
+        while (!user.empty() && user.back() == '=') {
+            user.pop_back();
+        }
+        const std::vector<ListingEntry>* listing = &allListing;
+        if (!user.empty()) {
+            auto it = userListings.find(user);
+            if (it == userListings.end()) {
+                return "{\"MessageIDs\":[]}";
+            }
+            listing = &it->second;
+        }
+
+        int64_t since = 0;
+        std::string sinceText = queryValue(query, "since");
+        std::from_chars(sinceText.data(), sinceText.data() + sinceText.size(), since);
+        size_t limit = 0;
+        std::string limitText = queryValue(query, "limit");
+        std::from_chars(limitText.data(), limitText.data() + limitText.size(), limit);
+        if (limit == 0) {
+            limit = listing->size();
+        }
+
+        auto first = std::lower_bound(listing->begin(), listing->end(), since,
+            [](const ListingEntry& entry, int64_t timestamp) { return entry.timestamp < timestamp; });
+        std::string after = queryValue(query, "after");
+        if (auto cursor = MessageIdView::parse(after)) {
+            ListingEntry key{ cursor->timestamp, after };
+            first = std::upper_bound(first, listing->end(), key);
+        }
+
+        size_t count = std::min<size_t>(limit, static_cast<size_t>(listing->end() - first));
+        std::string body = "{\"MessageIDs\":[";
+        for (size_t i = 0; i < count; ++i) {
+            if (i > 0) {
+                body += ',';
+            }
+            body += '"';
+            body += first[i].id;
+            body += '"';
+        }
+        body += ']';
+        if (first + count != listing->end()) {
+            body += ",\"NextToken\":\"";
+            body += first[count - 1].id;
+            body += '"';
+        }
+        body += '}';
+        return body;
+    }
+
+    void buildListings() {
+        for (const auto& messageID : corpus.ids) {
+            auto view = MessageIdView::parse(messageID);
+            if (!view.has_value()) {
+                continue;
+            }
+            std::string_view user = view->encodedUser;
+            while (!user.empty() && user.back() == '=') {
+                user.remove_suffix(1);
+            }
+            ListingEntry entry{ view->timestamp, messageID };
+            allListing.push_back(entry);
+            userListings[std::string(user)].push_back(entry);
+        }
+        std::sort(allListing.begin(), allListing.end());
+        for (auto& [user, listing] : userListings) {
+            std::sort(listing.begin(), listing.end());
+        }
+    }
+
+    // Percent-decoded value of name in a query string, as curl_easy_escape encodes it on the client
+    static std::string queryValue(std::string_view query, std::string_view name) {
+        while (!query.empty()) {
+            size_t end = query.find('&');
+            std::string_view pair = query.substr(0, end);
+            size_t equals = pair.find('=');
+            if (equals != std::string_view::npos && pair.substr(0, equals) == name) {
+                std::string_view value = pair.substr(equals + 1);
+                int length = 0;
+                char* decoded = curl_easy_unescape(nullptr, value.data(), static_cast<int>(value.size()), &length);
+                if (!decoded) {
+                    return std::string();
+                }
+                std::string result(decoded, static_cast<size_t>(length));
+                curl_free(decoded);
+                return result;
+            }
+            if (end == std::string_view::npos) {
+                break;
+            }
+            query.remove_prefix(end + 1);
+        }
+        return std::string();
+    }
+
+    static const char* reasonPhrase(int status) {
+        switch (status) {
+        case 200: return "OK";
+        case 400: return "Bad Request";
+        case 404: return "Not Found";
+        case 429: return "Too Many Requests";
+        default: return "Internal Server Error";
+        }
+    }
+
+    static void setNonBlocking(curl_socket_t socket) {
+#ifdef _WIN32
+        u_long nonBlocking = 1;
+        ioctlsocket(socket, FIONBIO, &nonBlocking);
+#else
+        fcntl(socket, F_SETFL, fcntl(socket, F_GETFL, 0) | O_NONBLOCK);
+#endif
+    }
+
+    static void closeSocket(curl_socket_t socket) {
+        if (socket == CURL_SOCKET_BAD) {
+            return;
+        }
+#ifdef _WIN32
+        closesocket(socket);
+#else
+        close(socket);
+#endif
+    }
+
+    MockCorpus corpus;
+    MockApiSettings settings;
+    std::mt19937_64 random;
+    double bucketTokens = 0;
+    Clock::time_point bucketFilledAt{};
+    std::string idListBody;
+
+    struct ListingEntry {
+        int64_t timestamp;
+        std::string_view id;      // points into corpus.ids
+        auto operator<=>(const ListingEntry&) const = default;
+    };
+    std::vector<ListingEntry> allListing;
+    std::unordered_map<std::string, std::vector<ListingEntry>> userListings;   // key: user segment without '='
+
+    curl_socket_t listener = CURL_SOCKET_BAD;
+    uint16_t boundPort = 0;
+    std::vector<Connection> connections;   // touched only by the server thread while it runs
+    std::atomic<bool> stopping{ false };
+    std::thread worker;
+
+    mutable std::mutex statsMutex;
+    Stats stats;
+};
+
+#endif // MOCKAPI_H
@@ -0,0 +1,537 @@
+#ifndef PIPELINE_H
+#define PIPELINE_H
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include "httpFunc.h"
+#include "sqliteFunc.h"
+
+//---------------------------------------------------------------------------------------------------
+//------------------BOUNDED QUEUE--------------------------------------------------------------------
+//---------------------------------------------------------------------------------------------------
+// Multi-producer/multi-consumer queue with a fixed capacity: push blocks while the queue is full,
+// which is what slows a fast stage down to the pace of the one after it (backpressure).
+// close() lets consumers drain what is left and then see nullopt.
+template <typename T>
+class BoundedQueue {
+public:
+    explicit BoundedQueue(size_t capacity) : maxItems(capacity > 0 ? capacity : 1) {}
+
+    // Returns false if the queue was closed
+    bool push(T&& item) {
+        std::unique_lock<std::mutex> lock(mutex);
+        if (items.size() >= maxItems && !closed) {
+            ++fullWaits;
+            notFull.wait(lock, [this] { return items.size() < maxItems || closed; });
+        }
+        if (closed) {
+            return false;
+        }
+        items.push_back(std::move(item));
+        highWater = std::max(highWater, items.size());
+        notEmpty.notify_one();
+        return true;
+    }
+
+    // Blocks until an item arrives; nullopt once the queue is closed and empty
+    std::optional<T> pop() {
+        std::unique_lock<std::mutex> lock(mutex);
+        notEmpty.wait(lock, [this] { return !items.empty() || closed; });
+        return takeFront();
+    }
+
+    // Never blocks; nullopt if nothing is queued right now
+    std::optional<T> tryPop() {
+        std::lock_guard<std::mutex> lock(mutex);
+        return takeFront();
+    }
+
+    void close() {
+        std::lock_guard<std::mutex> lock(mutex);
+        closed = true;
+        notEmpty.notify_all();
+        notFull.notify_all();
+    }
+
+    size_t capacity() const { return maxItems; }
+
+    size_t depth() const {
+        std::lock_guard<std::mutex> lock(mutex);
+        return items.size();
+    }
+
+    size_t maxDepth() const {
+        std::lock_guard<std::mutex> lock(mutex);
+        return highWater;
+    }
+
+    // How many pushes had to wait for room
+    size_t producerWaits() const {
+        std::lock_guard<std::mutex> lock(mutex);
+        return fullWaits;
+    }
+
+private:
+    std::optional<T> takeFront() {
+        if (items.empty()) {
+            return std::nullopt;
+        }
+        T item = std::move(items.front());
+        items.pop_front();
+        notFull.notify_one();
+        return item;
+    }
+
+    mutable std::mutex mutex;
+    std::condition_variable notEmpty;
+    std::condition_variable notFull;
+    std::deque<T> items;
+    size_t maxItems;
+    size_t highWater = 0;
+    size_t fullWaits = 0;
+    bool closed = false;
+};
+
+//---------------------------------------------------------------------------------------------------
+//------------------INGESTION PIPELINE---------------------------------------------------------------
+//---------------------------------------------------------------------------------------------------
+// fetch (curl_multi, AIMD-controlled transfers) -> bodies queue -> parse workers -> rows queue -> writer
+// The writer thread is the only one touching the Database while the pipeline runs. It commits whatever
+// has queued up (up to commitBatchSize rows) in one transaction, so commits grow when the disk falls behind.
+struct PipelineOptions {
+    ConcurrencySettings fetch;  // in-flight /receive requests; set fetch.adaptive = false for a fixed count
+    size_t parseWorkers = 1;
+    size_t queueCapacity = 1024;
+    size_t commitBatchSize = 256;
+    const std::atomic<bool>* stopRequested = nullptr;  // when set: stop fetching, drain what is queued
+    ResponseCache* cache = nullptr;                     // consulted before fetching, filled after parsing
+    bool eventLoop = false;                             // syncUser: ingestMessagesAsync on this thread's event loop
+};
+
+struct StageStats {
+    size_t items = 0;
+    size_t failed = 0;
+    double busySeconds = 0;     // time spent doing the stage's own work
+    double blockedSeconds = 0;  // time spent waiting for room in the next queue
+};
+
+struct PipelineStats {
+    StageStats fetch;
+    StageStats parse;
+    StageStats write;
+    size_t commits = 0;
+    size_t cacheHits = 0;
+    ConcurrencyController::Stats concurrency;
+    size_t bodiesQueueMax = 0;
+    size_t rowsQueueMax = 0;
+    size_t queueCapacity = 0;
+    double elapsedSeconds = 0;
+
+    void print() const {
+        auto rate = [this](size_t items) { return elapsedSeconds > 0 ? items / elapsedSeconds : 0.0; };
+        std::cout << std::fixed << std::setprecision(2)
+            << "Pipeline: " << elapsedSeconds << " s\n"
+            << "  fetch: " << fetch.items << " bodies (" << rate(fetch.items) << "/s), " << cacheHits << " from cache, "
+            << fetch.blockedSeconds << " s blocked on a full queue, in-flight limit "
+            << static_cast<size_t>(concurrency.finalLimit) << " (peak " << concurrency.peakLimit << ", "
+            << concurrency.decreases << " cuts, " << concurrency.throttled << " throttled)\n"
+            << "  parse: " << parse.items << " rows, " << parse.failed << " failed, "
+            << parse.busySeconds << " s busy, " << parse.blockedSeconds << " s blocked\n"
+            << "  write: " << write.items << " rows in " << commits << " commits (" << rate(write.items) << "/s), "
+            << write.failed << " failed, " << write.busySeconds << " s busy\n"
+            << "  queue high-water: bodies " << bodiesQueueMax << "/" << queueCapacity
+            << ", rows " << rowsQueueMax << "/" << queueCapacity << std::endl;
+        std::cout.unsetf(std::ios::floatfield);
+        std::cout << std::setprecision(6);
+    }
+};
+
+// Fetches, parses and stores the messages of the feed as they are listed; onStored runs on the writer
+// thread for every row that is in the database afterwards (inserted now or already present).
+PipelineStats ingestMessages(Database& db, MessageIdFeed& messageIDs,
+    const std::function<void(const std::string& messageID)>& onStored,
+    const PipelineOptions& options = PipelineOptions(),
+    const std::string& endpoint = receiveEndpoint(),
+    HttpClient& client = defaultHttpClient()) {
+    using Clock = std::chrono::steady_clock;
+    auto seconds = [](Clock::duration d) { return std::chrono::duration<double>(d).count(); };
+
+    PipelineStats stats;
+    stats.queueCapacity = options.queueCapacity;
+    auto started = Clock::now();
+
+    struct Body {
+        std::string messageID;
+        std::string body;
+    };
+    BoundedQueue<Body> bodies(options.queueCapacity);
+    BoundedQueue<MessageData> rows(options.queueCapacity);
+    std::mutex parseStatsMutex;
+
+    std::thread writer([&]() {
+        std::vector<MessageData> batch;
+        batch.reserve(options.commitBatchSize);
+        while (auto first = rows.pop()) {
+            batch.push_back(std::move(*first));
+            while (batch.size() < options.commitBatchSize) {
+                auto next = rows.tryPop();
+                if (!next) {
+                    break;
+                }
+                batch.push_back(std::move(*next));
+            }
+
+            auto commitStart = Clock::now();
+            BatchInsertResult inserted = addTransactions(db, batch);
+            stats.write.busySeconds += seconds(Clock::now() - commitStart);
+            ++stats.commits;
+            for (size_t i = 0; i < batch.size(); ++i) {
+                if (inserted.outcomes[i] == InsertOutcome::Failed) {
+                    ++stats.write.failed;
+                    continue;
+                }
+                ++stats.write.items;
+                if (onStored) {
+                    onStored(batch[i].messageID);
+                }
+            }
+            batch.clear();
+        }
+    });
+
+    std::vector<std::thread> parsers;
+    for (size_t i = 0; i < std::max<size_t>(options.parseWorkers, 1); ++i) {
+        parsers.emplace_back([&]() {
+            StageStats local;
+            while (auto item = bodies.pop()) {
+                auto parseStart = Clock::now();
+                auto data = ParseMessageData(item->body);
+                local.busySeconds += seconds(Clock::now() - parseStart);
+                if (!data) {
+                    std::cerr << "Failed to retrieve data for MessageID: " << item->messageID << std::endl;
+                    ++local.failed;
+                    continue;
+                }
+                ++local.items;
+                if (options.cache) {
+                    options.cache->put(item->messageID, *data);
+                }
+                auto pushStart = Clock::now();
+                rows.push(std::move(*data));
+                local.blockedSeconds += seconds(Clock::now() - pushStart);
+            }
+            std::lock_guard<std::mutex> lock(parseStatsMutex);
+            stats.parse.items += local.items;
+            stats.parse.failed += local.failed;
+            stats.parse.busySeconds += local.busySeconds;
+            stats.parse.blockedSeconds += local.blockedSeconds;
+        });
+    }
+
+    // Fetch stage runs here. With a cache, a reader thread sends cached messages straight to the writer
+    // and passes the rest on; curl_multi fetches those with as many transfers in flight as the controller allows
+    auto fetchStart = Clock::now();
+    MessageIdFeed uncached;
+    MessageIdFeed& toFetch = options.cache ? uncached : messageIDs;
+    std::thread cacheReader;
+    if (options.cache) {
+        cacheReader = std::thread([&]() {
+            std::string messageID;
+            for (size_t i = 0;; ++i) {
+                messageIDs.waitFor(i);
+                if (!messageIDs.get(i, messageID)) {
+                    break;
+                }
+                if (auto cached = options.cache->get(messageID)) {
+                    ++stats.cacheHits;
+                    rows.push(std::move(*cached));
+                }
+                else {
+                    uncached.push(messageID);
+                }
+            }
+            uncached.close();
+        });
+    }
+
+    ConcurrencyController controller(options.fetch);
+    stats.fetch.items = GetMessageBodiesBatch(toFetch, [&](const std::string& messageID, std::string&& body) {
+        auto pushStart = Clock::now();
+        bodies.push(Body{ messageID, std::move(body) });
+        stats.fetch.blockedSeconds += seconds(Clock::now() - pushStart);
+        return !(options.stopRequested && options.stopRequested->load());
+    }, options.fetch.maximum, endpoint, client, &controller);
+    if (cacheReader.joinable()) {
+        cacheReader.join();
+    }
+    stats.concurrency = controller.statistics();
+    stats.fetch.failed = toFetch.size() - stats.fetch.items;
+    stats.fetch.items += stats.cacheHits;
+    stats.fetch.busySeconds = seconds(Clock::now() - fetchStart) - stats.fetch.blockedSeconds;
+
+    // Drain in stage order: parsers finish the queued bodies, then the writer commits the last rows
+    bodies.close();
+    for (auto& parser : parsers) {
+        parser.join();
+    }
+    rows.close();
+    writer.join();
+
+    stats.bodiesQueueMax = bodies.maxDepth();
+    stats.rowsQueueMax = rows.maxDepth();
+    stats.elapsedSeconds = seconds(Clock::now() - started);
+    return stats;
+}
+
+PipelineStats ingestMessages(Database& db, std::span<const std::string> messageIDs,
+    const std::function<void(const std::string& messageID)>& onStored,
+    const PipelineOptions& options = PipelineOptions(),
+    const std::string& endpoint = receiveEndpoint(),
+    HttpClient& client = defaultHttpClient()) {
+    MessageIdFeed feed(messageIDs);
+    return ingestMessages(db, feed, onStored, options, endpoint, client);
+}
+
+//---------------------------------------------------------------------------------------------------
+//------------------ASYNC INGESTION (coroutines)-----------------------------------------------------
+//---------------------------------------------------------------------------------------------------
+// Same job as ingestMessages, with coroutines in place of stage threads: options.fetch.maximum fetch
+// coroutines share one event loop thread and parse inline (the typed decoder needs well under a
+// microsecond per body); rows go to the writer executor. Rows that arrive while a commit runs wait
+// for the next one (group commit), and a full row queue makes fetchers wait. The AIMD controller
+// gates how many of the coroutines have a request in flight, exactly as in GetMessageBodiesBatch.
+struct AsyncIngestState {
+    AsyncIngestState(EventLoop& loop, WriterExecutor& writer, Database& db, MessageIdFeed& messageIDs,
+        const std::function<void(const std::string& messageID)>& onStored, const PipelineOptions& options,
+        std::string urlPrefix, HttpClient& client)
+        : loop(loop), writer(writer), db(db), messageIDs(messageIDs), onStored(onStored), options(options),
+          urlPrefix(std::move(urlPrefix)), client(client), controller(options.fetch), slotFreed(loop), rowsDrained(loop), idsListed(loop) {}
+
+    EventLoop& loop;
+    WriterExecutor& writer;
+    Database& db;
+    MessageIdFeed& messageIDs;
+    const std::function<void(const std::string& messageID)>& onStored;
+    const PipelineOptions& options;
+    std::string urlPrefix;
+    HttpClient& client;
+
+    ConcurrencyController controller;
+    AsyncCondition slotFreed;
+    AsyncCondition rowsDrained;
+    AsyncCondition idsListed;
+    size_t active = 0;       // requests in flight
+    size_t nextID = 0;
+    std::vector<MessageData> rows;
+    bool flushing = false;
+    PipelineStats stats;
+
+    bool stopping() const { return options.stopRequested && options.stopRequested->load(); }
+
+    // Frees a request slot and wakes as many waiting fetchers as the (possibly grown) limit allows
+    void releaseSlot() {
+        --active;
+        size_t limit = controller.limit();
+        slotFreed.notify(limit > active ? limit - active : 0);
+    }
+};
+
+// Waits for a request slot under the controller's limit, and for any Retry-After pause to end
+Task<void> acquireFetchSlot(AsyncIngestState& state) {
+    while (true) {
+        auto now = std::chrono::steady_clock::now();
+        if (state.controller.paused(now)) {
+            co_await state.loop.sleepFor(state.controller.resumeAt() - now);
+            continue;
+        }
+        if (state.active < state.controller.limit()) {
+            ++state.active;
+            co_return;
+        }
+        co_await state.slotFreed.wait();
+    }
+}
+
+// One /receive body with retries; throttling, gateway errors and timeouts feed the controller
+Task<std::optional<std::string>> fetchBodyAsync(AsyncIngestState& state, const std::string& messageID) {
+    const ConcurrencySettings& settings = state.controller.config();
+    std::string url = state.urlPrefix + messageID;
+    for (int attempt = 1;; ++attempt) {
+        co_await acquireFetchSlot(state);
+        auto started = std::chrono::steady_clock::now();
+        HttpResponse response = co_await state.loop.get(state.client, url, settings.requestTimeout);
+
+        const char* reason = nullptr;
+        if (response.ok()) {
+            state.controller.onSuccess(started, response.latency, state.active - 1);
+            state.releaseSlot();
+            co_return std::move(response.body);
+        }
+        if (response.result == CURLE_OPERATION_TIMEDOUT) {
+            state.controller.onTimeout(started);
+            reason = "timeout";
+        }
+        else if (response.result != CURLE_OK) {
+            std::cerr << "Transfer failed for MessageID " << messageID << ": " << curl_easy_strerror(response.result) << std::endl;
+        }
+        else if (response.status == 429 || response.status == 503) {
+            state.controller.onThrottle(started, response.retryAfter);
+            reason = "throttled";
+        }
+        else if (response.status == 500 || response.status == 502 || response.status == 504) {
+            state.controller.onTimeout(started);
+            reason = "gateway error";
+        }
+        else {
+            std::cerr << "HTTP " << response.status << " for MessageID: " << messageID << std::endl;
+        }
+        state.releaseSlot();
+
+        if (!reason) {
+            co_return std::nullopt;
+        }
+        if (attempt >= settings.maxAttempts) {
+            std::cerr << "Giving up on MessageID " << messageID << " after " << attempt << " attempts: " << reason << std::endl;
+            co_return std::nullopt;
+        }
+    }
+}
+
+// Commits queued rows, up to commitBatchSize per transaction, until the queue is empty
+Task<void> flushRowsAsync(AsyncIngestState& state) {
+    using Clock = std::chrono::steady_clock;
+    state.flushing = true;
+    std::vector<MessageData> batch;
+    while (!state.rows.empty()) {
+        size_t count = std::min(state.rows.size(), std::max<size_t>(state.options.commitBatchSize, 1));
+        batch.assign(std::make_move_iterator(state.rows.begin()), std::make_move_iterator(state.rows.begin() + count));
+        state.rows.erase(state.rows.begin(), state.rows.begin() + count);
+        state.rowsDrained.notifyAll();
+
+        auto commitStart = Clock::now();
+        BatchInsertResult inserted = co_await state.writer.run([&state, &batch] { return addTransactions(state.db, batch); });
+        state.stats.write.busySeconds += std::chrono::duration<double>(Clock::now() - commitStart).count();
+        ++state.stats.commits;
+        for (size_t i = 0; i < batch.size(); ++i) {
+            if (inserted.outcomes[i] == InsertOutcome::Failed) {
+                ++state.stats.write.failed;
+                continue;
+            }
+            ++state.stats.write.items;
+            if (state.onStored) {
+                state.onStored(batch[i].messageID);
+            }
+        }
+    }
+    state.flushing = false;
+}
+
+Task<void> ingestWorkerAsync(AsyncIngestState& state) {
+    using Clock = std::chrono::steady_clock;
+    auto seconds = [](Clock::duration d) { return std::chrono::duration<double>(d).count(); };
+
+    std::string messageID;
+    while (!state.stopping()) {
+        if (!state.messageIDs.get(state.nextID, messageID)) {
+            if (state.messageIDs.exhausted(state.nextID)) {
+                break;
+            }
+            co_await state.idsListed.wait();
+            continue;
+        }
+        ++state.nextID;
+
+        std::optional<MessageData> data;
+        if (state.options.cache) {
+            data = state.options.cache->get(messageID);
+            if (data.has_value()) {
+                ++state.stats.cacheHits;
+            }
+        }
+        if (!data.has_value()) {
+            std::optional<std::string> body = co_await fetchBodyAsync(state, messageID);
+            if (!body.has_value()) {
+                ++state.stats.fetch.failed;
+                continue;
+            }
+            ++state.stats.fetch.items;
+
+            auto parseStart = Clock::now();
+            data = ParseMessageData(*body);
+            state.stats.parse.busySeconds += seconds(Clock::now() - parseStart);
+            if (!data.has_value()) {
+                std::cerr << "Failed to retrieve data for MessageID: " << messageID << std::endl;
+                ++state.stats.parse.failed;
+                continue;
+            }
+            ++state.stats.parse.items;
+            if (state.options.cache) {
+                state.options.cache->put(messageID, *data);
+            }
+        }
+
+        auto pushStart = Clock::now();
+        while (state.rows.size() >= state.options.queueCapacity) {
+            co_await state.rowsDrained.wait();
+        }
+        state.stats.parse.blockedSeconds += seconds(Clock::now() - pushStart);
+        state.rows.push_back(std::move(*data));
+        state.stats.rowsQueueMax = std::max(state.stats.rowsQueueMax, state.rows.size());
+
+        // Whoever finds no commit running becomes the committer until the queue is empty
+        if (!state.flushing) {
+            co_await flushRowsAsync(state);
+        }
+    }
+}
+
+// onStored runs on the loop thread for every row that is in the database afterwards.
+// messageIDs must stay alive until the task finishes; an open feed must be filled from the loop thread
+// (e.g. by streamActualIDsAsync on the same loop), since its listener wakes workers there.
+Task<PipelineStats> ingestMessagesAsync(EventLoop& loop, WriterExecutor& writer, Database& db,
+    MessageIdFeed& messageIDs,
+    std::function<void(const std::string& messageID)> onStored,
+    PipelineOptions options = PipelineOptions(),
+    std::string endpoint = receiveEndpoint(),
+    HttpClient& client = defaultHttpClient()) {
+    using Clock = std::chrono::steady_clock;
+    auto started = Clock::now();
+
+    AsyncIngestState state(loop, writer, db, messageIDs, onStored, options, endpoint + "?message_id=", client);
+    state.stats.queueCapacity = options.queueCapacity;
+
+    messageIDs.setListener([&state] { state.idsListed.notifyAll(); });
+
+    // While the list is still growing every worker may get an ID; idle ones just wait
+    std::vector<Task<void>> workers;
+    size_t workerCount = std::max<size_t>(options.fetch.maximum, 1);
+    if (messageIDs.exhausted(messageIDs.size())) {
+        workerCount = std::min(workerCount, messageIDs.size());
+    }
+    for (size_t i = 0; i < workerCount; ++i) {
+        workers.push_back(ingestWorkerAsync(state));
+    }
+    co_await whenAll(std::move(workers));
+    messageIDs.setListener(nullptr);
+
+    PipelineStats stats = state.stats;
+    stats.fetch.items += stats.cacheHits;
+    stats.concurrency = state.controller.statistics();
+    stats.elapsedSeconds = std::chrono::duration<double>(Clock::now() - started).count();
+    co_return stats;
+}
+
+Task<PipelineStats> ingestMessagesAsync(EventLoop& loop, WriterExecutor& writer, Database& db,
+    std::span<const std::string> messageIDs,
+    std::function<void(const std::string& messageID)> onStored,
+    PipelineOptions options = PipelineOptions(),
+    std::string endpoint = receiveEndpoint(),
+    HttpClient& client = defaultHttpClient()) {
+    MessageIdFeed feed(messageIDs);
+    co_return co_await ingestMessagesAsync(loop, writer, db, feed, std::move(onStored), std::move(options), std::move(endpoint), client);
+}
+
+#endif // PIPELINE_H
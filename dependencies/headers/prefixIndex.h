@@ -0,0 +1,283 @@
+#ifndef PREFIXINDEX_H
+#define PREFIXINDEX_H
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <map>
+#include <optional>
+#include <span>
+#include <unordered_map>
+#include <vector>
+
+//---------------------------------------------------------------------------------------------------
+//------------------FENWICK TREE OF SUMS AND COUNTS--------------------------------------------------
+//---------------------------------------------------------------------------------------------------
+// Binary indexed tree over slots 0..size-1: add to a slot and read any prefix in O(log size).
+// Slots can also be filled as plain values and turned into a tree in O(size) with build().
+class FenwickTree {
+public:
+    struct Totals {
+        double total = 0.0;
+        long long count = 0;
+    };
+
+    explicit FenwickTree(size_t size = 0) : sums(size + 1, 0.0), counts(size + 1, 0) {}
+
+    size_t size() const { return sums.size() - 1; }
+
+    void add(size_t slot, double amount, long long count) {
+        for (size_t i = slot + 1; i < sums.size(); i += i & (~i + 1)) {
+            sums[i] += amount;
+            counts[i] += count;
+        }
+    }
+
+    // Slots [0, end)
+    Totals prefix(size_t end) const {
+        Totals totals;
+        for (size_t i = std::min(end, size()); i > 0; i -= i & (~i + 1)) {
+            totals.total += sums[i];
+            totals.count += counts[i];
+        }
+        return totals;
+    }
+
+    // Slots [first, end)
+    Totals range(size_t first, size_t end) const {
+        Totals upper = prefix(end);
+        Totals lower = prefix(first);
+        return { upper.total - lower.total, upper.count - lower.count };
+    }
+
+    // Plain per-slot values -> tree, and back; both O(size)
+    void build() {
+        for (size_t i = 1; i < sums.size(); ++i) {
+            size_t parent = i + (i & (~i + 1));
+            if (parent < sums.size()) {
+                sums[parent] += sums[i];
+                counts[parent] += counts[i];
+            }
+        }
+    }
+
+    void unbuild() {
+        for (size_t i = sums.size() - 1; i > 0; --i) {
+            size_t parent = i + (i & (~i + 1));
+            if (parent < sums.size()) {
+                sums[parent] -= sums[i];
+                counts[parent] -= counts[i];
+            }
+        }
+    }
+
+    // Slot values; only meaningful between unbuild() and build()
+    double& slotSum(size_t slot) { return sums[slot + 1]; }
+    long long& slotCount(size_t slot) { return counts[slot + 1]; }
+
+    size_t memoryBytes() const { return sums.capacity() * sizeof(double) + counts.capacity() * sizeof(long long); }
+
+private:
+    std::vector<double> sums;         // 1-based
+    std::vector<long long> counts;
+};
+
+//---------------------------------------------------------------------------------------------------
+//------------------DAILY PREFIX SUMS PER USER-------------------------------------------------------
+//---------------------------------------------------------------------------------------------------
+// One Fenwick tree per user (and one per user and category) over UTC days, so the total of any
+// run of whole days is two prefix reads. Callers add the partial days at either end of a range
+// with an exact scan (see TransactionColumns). A tree covers a window of days that grows by
+// doubling when a row falls outside it. Deletes subtract, so totals carry the usual
+// floating-point rounding of a running sum.
+// Windows stay inside the indexed days, 1970-01-01 to 2099-12-31, so a tree never exceeds
+// INDEXED_DAYS slots (about 742 KiB) whatever Unix values the API sends. Days outside go to a
+// sorted map of the tree, summed one day at a time by the queries that reach them.
+class DailyPrefixSums {
+public:
+    static constexpr int64_t SECONDS_PER_DAY = 86400;
+    static constexpr int64_t FIRST_INDEXED_DAY = 0;        // 1970-01-01
+    static constexpr int64_t END_INDEXED_DAY = 47482;      // 2100-01-01
+    static constexpr int64_t INDEXED_DAYS = END_INDEXED_DAY - FIRST_INDEXED_DAY;
+
+    static int64_t dayOf(int64_t unixTime) {
+        return unixTime >= 0 ? unixTime / SECONDS_PER_DAY : -((-unixTime + SECONDS_PER_DAY - 1) / SECONDS_PER_DAY);
+    }
+
+    // count is +1 for an inserted row and -1 for a deleted one (with the amount negated)
+    void add(uint32_t user, int category, int64_t unixTime, double amount, long long count) {
+        int64_t day = dayOf(unixTime);
+        for (DayWindow* window : windowsOf(user, category)) {
+            addToDay(*window, day, amount, count);
+        }
+    }
+
+    // Whole days [firstDay, endDay) of one user, optionally one category
+    FenwickTree::Totals days(uint32_t user, std::optional<int> category, int64_t firstDay, int64_t endDay) const {
+        const DayWindow* window = nullptr;
+        if (category.has_value()) {
+            auto it = categoryTrees.find(categoryKey(user, *category));
+            window = it != categoryTrees.end() ? &it->second : nullptr;
+        }
+        else {
+            auto it = userTrees.find(user);
+            window = it != userTrees.end() ? &it->second : nullptr;
+        }
+        if (window == nullptr || endDay <= firstDay) {
+            return {};
+        }
+        FenwickTree::Totals totals;
+        int64_t last = window->firstDay + static_cast<int64_t>(window->tree.size());
+        int64_t first = std::max(firstDay, window->firstDay);
+        int64_t end = std::min(endDay, last);
+        if (first < end) {
+            totals = window->tree.range(static_cast<size_t>(first - window->firstDay), static_cast<size_t>(end - window->firstDay));
+        }
+        for (auto it = window->outliers.lower_bound(firstDay); it != window->outliers.end() && it->first < endDay; ++it) {
+            totals.total += it->second.total;
+            totals.count += it->second.count;
+        }
+        return totals;
+    }
+
+    // Recomputes every tree from the columns of a mirror in O(rows + days)
+    void rebuild(std::span<const int64_t> unixTimes, std::span<const double> amounts, std::span<const int32_t> categories,
+        std::span<const uint32_t> users) {
+        clear();
+        // Windows first, so no tree has to grow while it is filled
+        std::unordered_map<DayWindow*, std::pair<int64_t, int64_t>> spans;
+        for (size_t row = 0; row < unixTimes.size(); ++row) {
+            int64_t day = dayOf(unixTimes[row]);
+            for (DayWindow* window : windowsOf(users[row], categories[row])) {
+                if (indexed(day)) {
+                    auto [it, inserted] = spans.try_emplace(window, day, day);
+                    it->second.first = std::min(it->second.first, day);
+                    it->second.second = std::max(it->second.second, day);
+                }
+            }
+        }
+        for (const auto& [window, span] : spans) {
+            window->firstDay = span.first;
+            window->tree = FenwickTree(static_cast<size_t>(span.second - span.first + 1));
+        }
+        for (size_t row = 0; row < unixTimes.size(); ++row) {
+            int64_t day = dayOf(unixTimes[row]);
+            for (DayWindow* window : windowsOf(users[row], categories[row])) {
+                if (indexed(day)) {
+                    size_t slot = static_cast<size_t>(day - window->firstDay);
+                    window->tree.slotSum(slot) += amounts[row];
+                    window->tree.slotCount(slot) += 1;
+                }
+                else {
+                    addOutlier(*window, day, amounts[row], 1);
+                }
+            }
+        }
+        for (auto& [user, window] : userTrees) {
+            window.tree.build();
+        }
+        for (auto& [key, window] : categoryTrees) {
+            window.tree.build();
+        }
+    }
+
+    void eraseUser(uint32_t user) {
+        userTrees.erase(user);
+        std::erase_if(categoryTrees, [user](const auto& entry) { return static_cast<uint32_t>(entry.first >> 32) == user; });
+    }
+
+    void clear() {
+        userTrees.clear();
+        categoryTrees.clear();
+    }
+
+    size_t memoryBytes() const {
+        size_t bytes = 0;
+        for (const auto& [user, window] : userTrees) {
+            bytes += window.memoryBytes();
+        }
+        for (const auto& [key, window] : categoryTrees) {
+            bytes += window.memoryBytes();
+        }
+        return bytes;
+    }
+
+private:
+    struct DayWindow {
+        int64_t firstDay = 0;
+        FenwickTree tree;                                    // days [firstDay, firstDay + size), all indexed
+        std::map<int64_t, FenwickTree::Totals> outliers;     // days outside the indexed ones
+
+        size_t memoryBytes() const {
+            return tree.memoryBytes() + outliers.size() * (sizeof(int64_t) + sizeof(FenwickTree::Totals) + 4 * sizeof(void*));
+        }
+    };
+
+    static bool indexed(int64_t day) {
+        return day >= FIRST_INDEXED_DAY && day < END_INDEXED_DAY;
+    }
+
+    // Any int32 category is a key of its own; the all-categories tree lives in userTrees
+    static uint64_t categoryKey(uint32_t user, int category) {
+        return (static_cast<uint64_t>(user) << 32) | static_cast<uint32_t>(category);
+    }
+
+    std::array<DayWindow*, 2> windowsOf(uint32_t user, int category) {
+        return { &userTrees[user], &categoryTrees[categoryKey(user, category)] };
+    }
+
+    static void addOutlier(DayWindow& window, int64_t day, double amount, long long count) {
+        FenwickTree::Totals& totals = window.outliers[day];
+        totals.total += amount;
+        totals.count += count;
+        if (totals.count == 0) {
+            window.outliers.erase(day);
+        }
+    }
+
+    void addToDay(DayWindow& window, int64_t day, double amount, long long count) {
+        if (!indexed(day)) {
+            addOutlier(window, day, amount, count);
+            return;
+        }
+        if (window.tree.size() == 0) {
+            window.firstDay = std::min(day, END_INDEXED_DAY - INITIAL_WINDOW_DAYS);
+            window.tree = FenwickTree(INITIAL_WINDOW_DAYS);
+        }
+        int64_t end = window.firstDay + static_cast<int64_t>(window.tree.size());
+        if (day < window.firstDay || day >= end) {
+            grow(window, day);
+        }
+        window.tree.add(static_cast<size_t>(day - window.firstDay), amount, count);
+    }
+
+    static constexpr int64_t INITIAL_WINDOW_DAYS = 64;
+
+    // At least doubles the window, extending it towards `day`, but never past the indexed days
+    void grow(DayWindow& window, int64_t day) {
+        size_t oldSize = window.tree.size();
+        int64_t oldEnd = window.firstDay + static_cast<int64_t>(oldSize);
+        int64_t newFirst = std::min(window.firstDay, day);
+        int64_t newEnd = std::max(oldEnd, day + 1);
+        int64_t newSize = std::max(newEnd - newFirst, static_cast<int64_t>(oldSize) * 2);
+        if (day < window.firstDay) {
+            newFirst = std::max(newEnd - newSize, FIRST_INDEXED_DAY);   // room to grow further back
+        }
+        newEnd = std::min(newFirst + newSize, END_INDEXED_DAY);
+
+        window.tree.unbuild();
+        FenwickTree grown(static_cast<size_t>(newEnd - newFirst));
+        size_t offset = static_cast<size_t>(window.firstDay - newFirst);
+        for (size_t slot = 0; slot < oldSize; ++slot) {
+            grown.slotSum(offset + slot) = window.tree.slotSum(slot);
+            grown.slotCount(offset + slot) = window.tree.slotCount(slot);
+        }
+        grown.build();
+        window.firstDay = newFirst;
+        window.tree = std::move(grown);
+    }
+
+    std::unordered_map<uint32_t, DayWindow> userTrees;       // all categories of a user
+    std::unordered_map<uint64_t, DayWindow> categoryTrees;   // key: categoryKey(user, category)
+};
+
+#endif // PREFIXINDEX_H
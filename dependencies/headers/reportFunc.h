@@ -1,35 +1,501 @@
+#ifndef REPORTFUNC_H
+#define REPORTFUNC_H
 #include <util.h>
 #include <sqlite3.h>
+#include "database.h"
+#include "columnStore.h"
+#include <optional>
+#include <span>
+#include <vector>
+#include <algorithm>
 
-double getReport(sqlite3* db, time_t boundary_first, time_t boundary_last) {
-    double totalMoney = 0.0;
-    sqlite3_stmt* stmt;
-    std::string sql = "SELECT amount FROM Transactions WHERE date_unix >= ? AND date_unix <= ?;";
+struct ReportTotals {
+    double total = 0.0;
+    long long count = 0;
+};
 
-    // Prepare the SQL statement
-    int rc = sqlite3_prepare_v2(db, sql.c_str(), -1, &stmt, 0);
-    if (rc != SQLITE_OK) {
-        std::cerr << "Failed to prepare statement: " << sqlite3_errmsg(db) << std::endl;
-        return 0.0;
+// Sums and counts raw rows in SQLite over [boundary_first, boundary_last] for one user (optionally one category).
+// Answered from idx_transactions_user_unix_amount alone, so the cost follows the size of the range.
+ReportTotals getReportTotalsRaw(Database& db, const std::string& user_id, time_t boundary_first, time_t boundary_last,
+    std::optional<int> category_id = std::nullopt) {
+    ReportTotals totals;
+    const char* sql = category_id
+        ? "SELECT TOTAL(Amount), COUNT(*) FROM Transactions "
+          "WHERE UserID = ? AND Unix >= ? AND Unix <= ? AND CategoryID = ?;"
+        : "SELECT TOTAL(Amount), COUNT(*) FROM Transactions "
+          "WHERE UserID = ? AND Unix >= ? AND Unix <= ?;";
+
+    Database::Statement stmt = db.prepare(sql);
+    if (!stmt) {
+        return totals;
     }
 
     // Bind the parameters
+    sqlite3_bind_text(stmt, 1, user_id.c_str(), static_cast<int>(user_id.size()), SQLITE_STATIC);
+    sqlite3_bind_int64(stmt, 2, boundary_first);
+    sqlite3_bind_int64(stmt, 3, boundary_last);
+    if (category_id) {
+        sqlite3_bind_int(stmt, 4, *category_id);
+    }
+
+    int rc = sqlite3_step(stmt);
+    if (rc == SQLITE_ROW) {
+        totals.total = sqlite3_column_double(stmt, 0);
+        totals.count = sqlite3_column_int64(stmt, 1);
+    }
+    else {
+        std::cerr << "Execution failed: " << sqlite3_errmsg(db) << std::endl;
+    }
+
+    return totals;
+}
+
+// Sums whole local days [day_first, day_end) from the DailyTotals rollup
+ReportTotals getRollupTotals(Database& db, const std::string& user_id, time_t day_first, time_t day_end,
+    std::optional<int> category_id = std::nullopt) {
+    ReportTotals totals;
+    const char* sql = category_id
+        ? "SELECT TOTAL(sum_amount), TOTAL(count) FROM DailyTotals "
+          "WHERE user_id = ? AND day_start >= ? AND day_start < ? AND category_id = ?;"
+        : "SELECT TOTAL(sum_amount), TOTAL(count) FROM DailyTotals "
+          "WHERE user_id = ? AND day_start >= ? AND day_start < ?;";
+
+    Database::Statement stmt = db.prepare(sql);
+    if (!stmt) {
+        return totals;
+    }
+
+    sqlite3_bind_text(stmt, 1, user_id.c_str(), static_cast<int>(user_id.size()), SQLITE_STATIC);
+    sqlite3_bind_int64(stmt, 2, day_first);
+    sqlite3_bind_int64(stmt, 3, day_end);
+    if (category_id) {
+        sqlite3_bind_int(stmt, 4, *category_id);
+    }
+
+    if (sqlite3_step(stmt) == SQLITE_ROW) {
+        totals.total = sqlite3_column_double(stmt, 0);
+        totals.count = static_cast<long long>(sqlite3_column_double(stmt, 1));
+    }
+    else {
+        std::cerr << "Execution failed: " << sqlite3_errmsg(db) << std::endl;
+    }
+
+    return totals;
+}
+
+// Ranges spanning at least one whole local day read those days from DailyTotals (one row per
+// day and category) and only scan raw rows for the partial days at either end.
+ReportTotals getReportTotals(Database& db, const std::string& user_id, time_t boundary_first, time_t boundary_last,
+    std::optional<int> category_id = std::nullopt) {
+    time_t firstDay = getStartOfDay(boundary_first);
+    time_t fullFirst = (firstDay == boundary_first) ? firstDay : getStartOfDay(firstDay + 26 * 3600);
+    time_t fullEnd = getStartOfDay(boundary_last + 1);  // exclusive end of the last whole day
+
+    if (fullFirst >= fullEnd) {
+        return getReportTotalsRaw(db, user_id, boundary_first, boundary_last, category_id);
+    }
+
+    ReportTotals totals = getRollupTotals(db, user_id, fullFirst, fullEnd, category_id);
+    if (boundary_first < fullFirst) {
+        ReportTotals head = getReportTotalsRaw(db, user_id, boundary_first, fullFirst - 1, category_id);
+        totals.total += head.total;
+        totals.count += head.count;
+    }
+    if (fullEnd <= boundary_last) {
+        ReportTotals tail = getReportTotalsRaw(db, user_id, fullEnd, boundary_last, category_id);
+        totals.total += tail.total;
+        totals.count += tail.count;
+    }
+    return totals;
+}
+
+double getReport(Database& db, const std::string& user_id, time_t boundary_first, time_t boundary_last,
+    std::optional<int> category_id = std::nullopt) {
+    return getReportTotals(db, user_id, boundary_first, boundary_last, category_id).total;
+}
+
+// Total over all users; the sum is still computed inside SQLite
+double getReport(Database& db, time_t boundary_first, time_t boundary_last) {
+    const char* sql = "SELECT TOTAL(Amount) FROM Transactions WHERE Unix >= ? AND Unix <= ?;";
+
+    Database::Statement stmt = db.prepare(sql);
+    if (!stmt) {
+        return 0.0;
+    }
+
     sqlite3_bind_int64(stmt, 1, boundary_first);
     sqlite3_bind_int64(stmt, 2, boundary_last);
 
-    // Execute the query and iterate over the result set
+    double totalMoney = 0.0;
+    if (sqlite3_step(stmt) == SQLITE_ROW) {
+        totalMoney = sqlite3_column_double(stmt, 0);
+    }
+    else {
+        std::cerr << "Execution failed: " << sqlite3_errmsg(db) << std::endl;
+    }
+
+    return totalMoney;
+}
+
+//---------------------------------------------------------------------------------------------------
+//------------------BATCHED RANGE REPORTS------------------------------------------------------------
+//---------------------------------------------------------------------------------------------------
+// A dashboard asks for today, this week, this month, last month, year to date and the last 30 days
+// at once; those ranges overlap heavily.
+struct ReportRange {
+    time_t first = 0;
+    time_t last = 0;    // inclusive, like getReport()
+};
+
+struct SweepInterval {
+    int64_t first = 0;
+    int64_t last = 0;   // inclusive
+    size_t target = 0;  // index of the result this interval adds to
+};
+
+// Answers many overlapping intervals with one pass over their union. The start and end points of
+// all intervals cut the time line into elementary segments; sum(first, last) is asked once for
+// each segment that some interval covers, and each interval adds up the segments it spans.
+// Every row is therefore read once however many intervals cover it, and the per-row work stays
+// inside the caller's aggregate (SQL TOTAL/COUNT) instead of being stepped out row by row. That is
+// one statement per covered segment rather than one ORDER BY Unix scan: the partial days of a
+// dashboard lie months apart, and a single scan from the first to the last of them would read
+// every row in between.
+template <typename SumSegment>
+void sweepIntervals(std::span<const SweepInterval> intervals, std::vector<ReportTotals>& results, SumSegment&& sum) {
+    if (intervals.empty()) {
+        return;
+    }
+    std::vector<int64_t> cuts;
+    cuts.reserve(intervals.size() * 2);
+    for (const SweepInterval& interval : intervals) {
+        cuts.push_back(interval.first);
+        cuts.push_back(interval.last + 1);
+    }
+    std::sort(cuts.begin(), cuts.end());
+    cuts.erase(std::unique(cuts.begin(), cuts.end()), cuts.end());
+
+    // Intervals by start; the active ones are those started at or before a segment and not yet ended
+    std::vector<size_t> order(intervals.size());
+    for (size_t i = 0; i < order.size(); ++i) {
+        order[i] = i;
+    }
+    std::sort(order.begin(), order.end(), [&](size_t a, size_t b) { return intervals[a].first < intervals[b].first; });
+
+    std::vector<size_t> active;
+    size_t nextStart = 0;
+    for (size_t c = 0; c + 1 < cuts.size(); ++c) {
+        int64_t segmentFirst = cuts[c];
+        int64_t segmentLast = cuts[c + 1] - 1;
+        for (; nextStart < order.size() && intervals[order[nextStart]].first <= segmentFirst; ++nextStart) {
+            active.push_back(order[nextStart]);
+        }
+        std::erase_if(active, [&](size_t i) { return intervals[i].last < segmentFirst; });
+        if (active.empty()) {
+            continue;   // a gap between intervals: nothing is read there
+        }
+        ReportTotals segment = sum(segmentFirst, segmentLast);
+        for (size_t i : active) {
+            results[intervals[i].target].total += segment.total;
+            results[intervals[i].target].count += segment.count;
+        }
+    }
+}
+
+// Answers getReportTotals() for each range, in the same order. Each range is split the same way
+// (whole local days from DailyTotals, partial days from the covering index) and both parts are swept
+// over the union of all ranges, so the rows read follow the union of the ranges, not their sum.
+// Counts are identical; totals add the same amounts in a different order (segment by segment), so
+// they can differ from getReportTotals() in the last bits of the double.
+std::vector<ReportTotals> getReports(Database& db, const std::string& user_id, std::span<const ReportRange> ranges,
+    std::optional<int> category_id = std::nullopt) {
+    std::vector<ReportTotals> results(ranges.size());
+
+    // Split every range the way getReportTotals() does
+    std::vector<SweepInterval> days;
+    std::vector<SweepInterval> partials;
+    for (size_t i = 0; i < ranges.size(); ++i) {
+        time_t boundary_first = ranges[i].first;
+        time_t boundary_last = ranges[i].last;
+        if (boundary_last < boundary_first) {
+            continue;
+        }
+        time_t firstDay = getStartOfDay(boundary_first);
+        time_t fullFirst = (firstDay == boundary_first) ? firstDay : getStartOfDay(firstDay + 26 * 3600);
+        time_t fullEnd = getStartOfDay(boundary_last + 1);
+
+        if (fullFirst >= fullEnd) {
+            partials.push_back({ boundary_first, boundary_last, i });
+            continue;
+        }
+        days.push_back({ fullFirst, fullEnd - 1, i });
+        if (boundary_first < fullFirst) {
+            partials.push_back({ boundary_first, fullFirst - 1, i });
+        }
+        if (fullEnd <= boundary_last) {
+            partials.push_back({ fullEnd, boundary_last, i });
+        }
+    }
+
+    // Segments are summed with the same statements getReportTotals() uses
+    sweepIntervals(days, results, [&](int64_t first, int64_t last) {
+        return getRollupTotals(db, user_id, static_cast<time_t>(first), static_cast<time_t>(last + 1), category_id);
+    });
+    sweepIntervals(partials, results, [&](int64_t first, int64_t last) {
+        return getReportTotalsRaw(db, user_id, static_cast<time_t>(first), static_cast<time_t>(last), category_id);
+    });
+    return results;
+}
+
+//---------------------------------------------------------------------------------------------------
+//------------------GROUPED REPORTS------------------------------------------------------------------
+//---------------------------------------------------------------------------------------------------
+// TimeBucket is defined with the calendar (calendar.h)
+struct GroupBy {
+    bool category = true;
+    TimeBucket bucket = TimeBucket::Day;
+};
+
+struct ReportBucket {
+    time_t bucketStart = 0;  // start of the day/week/month (util.h boundaries); 'from' when not grouped by time
+    int categoryID = -1;     // -1 when not grouped by category
+    double total = 0.0;
+    long long count = 0;
+    double min = 0.0;
+    double max = 0.0;
+};
+
+// Start of the bucket that follows the one starting at bucketStart
+time_t nextBucketStart(time_t bucketStart, TimeBucket bucket) {
+    return static_cast<time_t>(TimeZoneTable::local().nextBucketStart(bucketStart, bucket));
+}
+
+time_t bucketStartOf(time_t timestamp, TimeBucket bucket) {
+    return static_cast<time_t>(TimeZoneTable::local().bucketStart(timestamp, bucket));
+}
+
+// Folds rows that arrive in Unix order into time buckets with per-category slots.
+// A bucket's boundaries are only recomputed when a row crosses into the next bucket; its slots
+// are emitted in category order when it ends.
+class GroupedReportBuilder {
+public:
+    GroupedReportBuilder(time_t from, GroupBy groupBy) : groupBy(groupBy), currentStart(from), currentEnd(from) {}
+
+    void add(time_t unix_time, double amount, int categoryID) {
+        int category = groupBy.category ? categoryID : -1;
+        if (groupBy.bucket != TimeBucket::None && unix_time >= currentEnd) {
+            flush();
+            currentStart = bucketStartOf(unix_time, groupBy.bucket);
+            currentEnd = nextBucketStart(currentStart, groupBy.bucket);
+        }
+
+        // A handful of categories per bucket: a linear search beats a map
+        ReportBucket* bucket = nullptr;
+        for (auto& slot : current) {
+            if (slot.categoryID == category) {
+                bucket = &slot;
+                break;
+            }
+        }
+        if (!bucket) {
+            bucket = &current.emplace_back();
+            bucket->bucketStart = currentStart;
+            bucket->categoryID = category;
+            bucket->min = amount;
+            bucket->max = amount;
+        }
+        bucket->total += amount;
+        bucket->count += 1;
+        bucket->min = std::min(bucket->min, amount);
+        bucket->max = std::max(bucket->max, amount);
+    }
+
+    std::vector<ReportBucket> finish() {
+        flush();
+        return std::move(buckets);
+    }
+
+private:
+    void flush() {
+        std::sort(current.begin(), current.end(),
+            [](const ReportBucket& a, const ReportBucket& b) { return a.categoryID < b.categoryID; });
+        buckets.insert(buckets.end(), current.begin(), current.end());
+        current.clear();
+    }
+
+    GroupBy groupBy;
+    time_t currentStart;
+    time_t currentEnd;   // exclusive; equal to start until the first row opens a bucket
+    std::vector<ReportBucket> current;
+    std::vector<ReportBucket> buckets;
+};
+
+// All bucket totals, counts, min and max for one user from a single ordered scan of the covering index.
+std::vector<ReportBucket> getGroupedReport(Database& db, const std::string& user_id, time_t from, time_t to,
+    GroupBy groupBy = GroupBy{}) {
+    const char* sql = "SELECT Unix, Amount, CategoryID FROM Transactions "
+        "WHERE UserID = ? AND Unix >= ? AND Unix <= ? ORDER BY Unix;";
+
+    Database::Statement stmt = db.prepare(sql);
+    if (!stmt) {
+        return {};
+    }
+
+    sqlite3_bind_text(stmt, 1, user_id.c_str(), static_cast<int>(user_id.size()), SQLITE_STATIC);
+    sqlite3_bind_int64(stmt, 2, from);
+    sqlite3_bind_int64(stmt, 3, to);
+
+    GroupedReportBuilder builder(from, groupBy);
+    int rc;
     while ((rc = sqlite3_step(stmt)) == SQLITE_ROW) {
-        double amount = sqlite3_column_double(stmt, 0);  // Fetch the 'amount' value
-        totalMoney += amount;  // Accumulate the total money
+        builder.add(static_cast<time_t>(sqlite3_column_int64(stmt, 0)), sqlite3_column_double(stmt, 1), sqlite3_column_int(stmt, 2));
     }
 
-    // Check for any errors during execution
     if (rc != SQLITE_DONE) {
         std::cerr << "Execution failed: " << sqlite3_errmsg(db) << std::endl;
     }
+    return builder.finish();
+}
 
-    // Finalize the statement to release resources
-    sqlite3_finalize(stmt);
+//---------------------------------------------------------------------------------------------------
+//------------------COLUMNAR REPORTS-----------------------------------------------------------------
+//---------------------------------------------------------------------------------------------------
+// The reports above, answered from a TransactionColumns mirror instead of SQLite.
+// Sums over rows [begin, end) of the mirror. Four independent accumulators and a 0/1 multiplier
+// instead of a branch let the compiler vectorize the loop without -ffast-math; the filters are
+// template flags so the all-users loop carries no compare at all. The result can differ from
+// SQLite's TOTAL() in the last bits of the double.
+template <bool ByUser, bool ByCategory>
+ReportTotals sumColumnKernel(const TransactionColumns& columns, size_t begin, size_t end, uint32_t userKey, int32_t category) {
+    const double* amounts = columns.amountColumn().data();
+    const uint32_t* users = columns.userColumn().data();
+    const int32_t* categories = columns.categoryColumn().data();
 
-    return totalMoney;
+    double sums[4] = { 0.0, 0.0, 0.0, 0.0 };
+    long long counts[4] = { 0, 0, 0, 0 };
+    size_t i = begin;
+    for (; i + 4 <= end; i += 4) {
+        for (size_t lane = 0; lane < 4; ++lane) {
+            bool hit = (!ByUser || users[i + lane] == userKey) & (!ByCategory || categories[i + lane] == category);
+            sums[lane] += amounts[i + lane] * static_cast<double>(hit);
+            counts[lane] += hit;
+        }
+    }
+    for (; i < end; ++i) {
+        bool hit = (!ByUser || users[i] == userKey) & (!ByCategory || categories[i] == category);
+        sums[0] += amounts[i] * static_cast<double>(hit);
+        counts[0] += hit;
+    }
+
+    ReportTotals totals;
+    totals.total = (sums[0] + sums[1]) + (sums[2] + sums[3]);
+    totals.count = (counts[0] + counts[1]) + (counts[2] + counts[3]);
+    return totals;
+}
+
+// All users when user is empty, all categories when category_id is empty
+ReportTotals sumColumnRange(const TransactionColumns& columns, size_t begin, size_t end,
+    std::optional<uint32_t> user, std::optional<int> category_id = std::nullopt) {
+    uint32_t userKey = user.value_or(0);
+    int32_t category = category_id.value_or(0);
+    if (user.has_value()) {
+        return category_id.has_value()
+            ? sumColumnKernel<true, true>(columns, begin, end, userKey, category)
+            : sumColumnKernel<true, false>(columns, begin, end, userKey, category);
+    }
+    return category_id.has_value()
+        ? sumColumnKernel<false, true>(columns, begin, end, userKey, category)
+        : sumColumnKernel<false, false>(columns, begin, end, userKey, category);
+}
+
+// Plain scan of every mirrored row in [boundary_first, boundary_last]
+ReportTotals getReportTotalsScan(const TransactionColumns& columns, const std::string& user_id, time_t boundary_first,
+    time_t boundary_last, std::optional<int> category_id = std::nullopt) {
+    std::optional<uint32_t> user = columns.userKey(user_id);
+    if (!user.has_value()) {
+        return ReportTotals{};
+    }
+    auto [begin, end] = columns.rangeOf(boundary_first, boundary_last);
+    return sumColumnRange(columns, begin, end, user, category_id);
+}
+
+// Whole UTC days inside the range come from the mirror's daily prefix sums in O(log days); only the
+// partial days at either end are scanned, so the cost no longer follows the length of the range
+ReportTotals getReportTotals(const TransactionColumns& columns, const std::string& user_id, time_t boundary_first,
+    time_t boundary_last, std::optional<int> category_id = std::nullopt) {
+    std::optional<uint32_t> user = columns.userKey(user_id);
+    if (!user.has_value()) {
+        return ReportTotals{};
+    }
+    const int64_t day = DailyPrefixSums::SECONDS_PER_DAY;
+    int64_t firstDay = DailyPrefixSums::dayOf(static_cast<int64_t>(boundary_first) + day - 1);  // first day starting in range
+    int64_t endDay = DailyPrefixSums::dayOf(static_cast<int64_t>(boundary_last) + 1);          // first day not ending in range
+    if (firstDay >= endDay) {
+        auto [begin, end] = columns.rangeOf(boundary_first, boundary_last);
+        return sumColumnRange(columns, begin, end, user, category_id);
+    }
+
+    FenwickTree::Totals days = columns.dailySums().days(*user, category_id, firstDay, endDay);
+    ReportTotals totals;
+    totals.total = days.total;
+    totals.count = days.count;
+    if (boundary_first < firstDay * day) {
+        auto [begin, end] = columns.rangeOf(boundary_first, static_cast<time_t>(firstDay * day - 1));
+        ReportTotals head = sumColumnRange(columns, begin, end, user, category_id);
+        totals.total += head.total;
+        totals.count += head.count;
+    }
+    if (endDay * day <= boundary_last) {
+        auto [begin, end] = columns.rangeOf(static_cast<time_t>(endDay * day), boundary_last);
+        ReportTotals tail = sumColumnRange(columns, begin, end, user, category_id);
+        totals.total += tail.total;
+        totals.count += tail.count;
+    }
+    return totals;
 }
+
+double getReport(const TransactionColumns& columns, const std::string& user_id, time_t boundary_first, time_t boundary_last,
+    std::optional<int> category_id = std::nullopt) {
+    return getReportTotals(columns, user_id, boundary_first, boundary_last, category_id).total;
+}
+
+// Total over all users
+double getReport(const TransactionColumns& columns, time_t boundary_first, time_t boundary_last) {
+    auto [begin, end] = columns.rangeOf(boundary_first, boundary_last);
+    return sumColumnRange(columns, begin, end, std::nullopt).total;
+}
+
+// Each range costs O(log days) from the daily prefix sums, so there is nothing to share between them
+std::vector<ReportTotals> getReports(const TransactionColumns& columns, const std::string& user_id, std::span<const ReportRange> ranges,
+    std::optional<int> category_id = std::nullopt) {
+    std::vector<ReportTotals> results;
+    results.reserve(ranges.size());
+    for (const ReportRange& range : ranges) {
+        results.push_back(range.last < range.first
+            ? ReportTotals{} : getReportTotals(columns, user_id, range.first, range.last, category_id));
+    }
+    return results;
+}
+
+std::vector<ReportBucket> getGroupedReport(const TransactionColumns& columns, const std::string& user_id, time_t from, time_t to,
+    GroupBy groupBy = GroupBy{}) {
+    std::optional<uint32_t> user = columns.userKey(user_id);
+    if (!user.has_value()) {
+        return {};
+    }
+    const int64_t* unixTimes = columns.unixColumn().data();
+    const double* amounts = columns.amountColumn().data();
+    const uint32_t* users = columns.userColumn().data();
+    const int32_t* categories = columns.categoryColumn().data();
+
+    GroupedReportBuilder builder(from, groupBy);
+    auto [begin, end] = columns.rangeOf(from, to);
+    for (size_t i = begin; i < end; ++i) {
+        if (users[i] == *user) {
+            builder.add(static_cast<time_t>(unixTimes[i]), amounts[i], categories[i]);
+        }
+    }
+    return builder.finish();
+}
+
+#endif // REPORTFUNC_H
@@ -0,0 +1,387 @@
+#ifndef RESPONSECACHE_H
+#define RESPONSECACHE_H
+#include <iostream>
+#include <fstream>
+#include <filesystem>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <unordered_map>
+#include <cstring>
+#include <cstdio>
+#include <charconv>
+#include <algorithm>
+#include "messageData.h"
+
+//---------------------------------------------------------------------------------------------------
+//------------------ON-DISK /receive RESPONSE CACHE--------------------------------------------------
+//---------------------------------------------------------------------------------------------------
+// Messages never change once created, so a fetched /receive response can be kept forever.
+// Records are appended to segment files (segment-000001.dat, ...) in one directory:
+//   header { magic, kind, key length, value length, FNV-1a checksum } + MessageID + value
+// kind Packed stores the decoded fields in a compact binary form (no JSON keys, nothing to parse on a hit);
+// kind Raw keeps the JSON body for shapes the typed decoder does not accept.
+// The MessageID -> record index lives in memory and is rebuilt by scanning the record headers on open;
+// a torn record at the end of a segment (crash during append) ends the scan of that segment.
+// When the total size passes maxBytes the oldest segment is deleted as a whole.
+class ResponseCache {
+public:
+    struct Stats {
+        size_t hits = 0;
+        size_t misses = 0;
+        size_t stored = 0;
+        size_t evictedSegments = 0;
+        size_t entries = 0;
+        uint64_t bytes = 0;
+    };
+
+    explicit ResponseCache(const std::filesystem::path& directory,
+        uint64_t maxBytes = 256ULL * 1024 * 1024, uint64_t segmentBytes = 8ULL * 1024 * 1024)
+        : directory(directory), maxBytes(maxBytes), segmentBytes(segmentBytes) {
+        std::error_code error;
+        std::filesystem::create_directories(directory, error);
+        if (error) {
+            std::cerr << "Response cache disabled, cannot create " << directory.string() << ": " << error.message() << std::endl;
+            return;
+        }
+        loadSegments();
+        usable = true;
+    }
+
+    ResponseCache(const ResponseCache&) = delete;
+    ResponseCache& operator=(const ResponseCache&) = delete;
+
+    bool isOpen() const { return usable; }
+
+    bool contains(std::string_view messageID) const {
+        std::lock_guard<std::mutex> lock(mutex);
+        return index.find(messageID) != index.end();
+    }
+
+    // Stores an already decoded message; an ID that is already cached is left as it is
+    bool put(std::string_view messageID, const MessageData& data) {
+        return append(messageID, RecordKind::Packed, pack(data));
+    }
+
+    // Stores a successful /receive body; an ID that is already cached is left as it is
+    bool put(std::string_view messageID, std::string_view body) {
+        MessageData decoded;
+        if (MessageData::TryDecode(body, decoded)) {
+            return append(messageID, RecordKind::Packed, pack(decoded));
+        }
+        return append(messageID, RecordKind::Raw, std::string(body));
+    }
+
+    std::optional<MessageData> get(std::string_view messageID) {
+        std::lock_guard<std::mutex> lock(mutex);
+        auto it = index.find(messageID);
+        if (it == index.end()) {
+            ++stats.misses;
+            return std::nullopt;
+        }
+
+        std::string value;
+        RecordKind kind;
+        if (!readRecord(it->second, messageID, kind, value)) {
+            index.erase(it);
+            ++stats.misses;
+            return std::nullopt;
+        }
+
+        std::optional<MessageData> data;
+        if (kind == RecordKind::Packed) {
+            data = unpack(value);
+        }
+        else {
+            MessageData decoded;
+            if (MessageData::TryDecode(value, decoded)) {
+                data = std::move(decoded);
+            }
+            else {
+                try {
+                    data = MessageData::FromJSON(nlohmann::json::parse(value));
+                }
+                catch (const std::exception& e) {
+                    std::cerr << "Cached response for " << messageID << " is unreadable: " << e.what() << std::endl;
+                }
+            }
+        }
+        if (data.has_value()) {
+            ++stats.hits;
+        }
+        else {
+            ++stats.misses;
+        }
+        return data;
+    }
+
+    // Every cached MessageID, oldest segment first
+    std::vector<std::string> messageIDs() const {
+        std::lock_guard<std::mutex> lock(mutex);
+        std::vector<std::pair<Location, std::string>> ordered;
+        ordered.reserve(index.size());
+        for (const auto& [messageID, location] : index) {
+            ordered.emplace_back(location, messageID);
+        }
+        std::sort(ordered.begin(), ordered.end(), [](const auto& a, const auto& b) {
+            return a.first.segment != b.first.segment ? a.first.segment < b.first.segment : a.first.offset < b.first.offset;
+        });
+        std::vector<std::string> ids;
+        ids.reserve(ordered.size());
+        for (auto& entry : ordered) {
+            ids.push_back(std::move(entry.second));
+        }
+        return ids;
+    }
+
+    Stats statistics() const {
+        std::lock_guard<std::mutex> lock(mutex);
+        Stats result = stats;
+        result.entries = index.size();
+        result.bytes = totalBytes;
+        return result;
+    }
+
+    void printStats() const {
+        Stats current = statistics();
+        std::cout << "Response cache: " << current.hits << " hits, " << current.misses << " misses, "
+            << current.stored << " stored, " << current.entries << " entries in "
+            << current.bytes / 1024 << " KiB, " << current.evictedSegments << " segments evicted" << std::endl;
+    }
+
+private:
+    enum class RecordKind : uint8_t {
+        Raw = 0,
+        Packed = 1
+    };
+
+#pragma pack(push, 1)
+    struct RecordHeader {
+        uint32_t magic;
+        uint8_t kind;
+        uint16_t keyLength;
+        uint32_t valueLength;
+        uint32_t checksum;
+    };
+#pragma pack(pop)
+    static constexpr uint32_t RECORD_MAGIC = 0x31435053;  // "SPC1"
+
+    struct Location {
+        uint32_t segment;
+        uint64_t offset;
+    };
+
+    struct IdHash {
+        using is_transparent = void;
+        size_t operator()(std::string_view id) const { return std::hash<std::string_view>{}(id); }
+    };
+
+    static uint32_t checksum(std::string_view key, std::string_view value) {
+        uint32_t hash = 2166136261u;
+        for (std::string_view part : { key, value }) {
+            for (unsigned char c : part) {
+                hash = (hash ^ c) * 16777619u;
+            }
+        }
+        return hash;
+    }
+
+    std::filesystem::path segmentPath(uint32_t segment) const {
+        char name[32];
+        std::snprintf(name, sizeof(name), "segment-%06u.dat", segment);
+        return directory / name;
+    }
+
+    void loadSegments() {
+        std::error_code error;
+        for (const auto& entry : std::filesystem::directory_iterator(directory, error)) {
+            std::string name = entry.path().filename().string();
+            if (name.size() != 18 || name.rfind("segment-", 0) != 0 || name.substr(14) != ".dat") {
+                continue;
+            }
+            uint32_t segment = 0;
+            auto [end, parseError] = std::from_chars(name.data() + 8, name.data() + 14, segment);
+            if (parseError == std::errc() && end == name.data() + 14) {
+                segmentSizes[segment] = 0;
+            }
+        }
+        for (auto& [segment, size] : segmentSizes) {
+            size = scanSegment(segment);
+            totalBytes += size;
+        }
+        // Always append to a fresh segment, so nothing is written after a torn tail
+        activeSegment = segmentSizes.empty() ? 1 : segmentSizes.rbegin()->first + 1;
+    }
+
+    uint64_t scanSegment(uint32_t segment) {
+        std::error_code error;
+        uint64_t fileSize = std::filesystem::file_size(segmentPath(segment), error);
+        std::ifstream in(segmentPath(segment), std::ios::binary);
+        if (error || !in) {
+            return 0;
+        }
+
+        uint64_t offset = 0;
+        RecordHeader header;
+        std::string key;
+        while (in.read(reinterpret_cast<char*>(&header), sizeof(header)) && header.magic == RECORD_MAGIC) {
+            uint64_t next = offset + sizeof(header) + header.keyLength + header.valueLength;
+            if (next > fileSize) {
+                break;
+            }
+            key.resize(header.keyLength);
+            if (!in.read(key.data(), header.keyLength) || !in.seekg(header.valueLength, std::ios::cur)) {
+                break;
+            }
+            index.insert_or_assign(key, Location{ segment, offset });
+            offset = next;
+        }
+        return offset;
+    }
+
+    bool append(std::string_view messageID, RecordKind kind, const std::string& value) {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (!usable || index.find(messageID) != index.end()) {
+            return false;
+        }
+
+        if (!writer.is_open() || segmentSizes[activeSegment] >= segmentBytes) {
+            if (writer.is_open()) {
+                writer.close();
+                ++activeSegment;
+            }
+            writer.open(segmentPath(activeSegment), std::ios::binary | std::ios::app);
+            if (!writer) {
+                std::cerr << "Failed to open cache segment " << segmentPath(activeSegment).string() << std::endl;
+                return false;
+            }
+            segmentSizes.try_emplace(activeSegment, 0);
+        }
+
+        RecordHeader header{ RECORD_MAGIC, static_cast<uint8_t>(kind), static_cast<uint16_t>(messageID.size()),
+            static_cast<uint32_t>(value.size()), checksum(messageID, value) };
+        writer.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        writer.write(messageID.data(), messageID.size());
+        writer.write(value.data(), value.size());
+        writer.flush();
+        if (!writer) {
+            std::cerr << "Failed to write cache segment " << segmentPath(activeSegment).string() << std::endl;
+            return false;
+        }
+
+        uint64_t& size = segmentSizes[activeSegment];
+        index.emplace(std::string(messageID), Location{ activeSegment, size });
+        uint64_t recordSize = sizeof(header) + messageID.size() + value.size();
+        size += recordSize;
+        totalBytes += recordSize;
+        ++stats.stored;
+
+        evictIfNeeded();
+        return true;
+    }
+
+    // Drops whole segments, oldest first, never the one being written
+    void evictIfNeeded() {
+        while (totalBytes > maxBytes && segmentSizes.size() > 1) {
+            auto oldest = segmentSizes.begin();
+            uint32_t segment = oldest->first;
+            for (auto it = index.begin(); it != index.end();) {
+                it = (it->second.segment == segment) ? index.erase(it) : std::next(it);
+            }
+            readers.erase(segment);
+            totalBytes -= oldest->second;
+            segmentSizes.erase(oldest);
+            std::error_code error;
+            std::filesystem::remove(segmentPath(segment), error);
+            ++stats.evictedSegments;
+        }
+    }
+
+    bool readRecord(const Location& location, std::string_view messageID, RecordKind& kind, std::string& value) {
+        auto& reader = readers[location.segment];
+        if (!reader) {
+            reader = std::make_unique<std::ifstream>(segmentPath(location.segment), std::ios::binary);
+        }
+        reader->clear();
+        reader->seekg(static_cast<std::streamoff>(location.offset));
+
+        RecordHeader header;
+        std::string key;
+        if (reader->read(reinterpret_cast<char*>(&header), sizeof(header)) && header.magic == RECORD_MAGIC) {
+            key.resize(header.keyLength);
+            value.resize(header.valueLength);
+            if (reader->read(key.data(), key.size()) && reader->read(value.data(), value.size())
+                && key == messageID && header.checksum == checksum(key, value)) {
+                kind = static_cast<RecordKind>(header.kind);
+                return true;
+            }
+        }
+        std::cerr << "Corrupt cache record for " << messageID << " in " << segmentPath(location.segment).string() << std::endl;
+        return false;
+    }
+
+    // Packed record: int64 unix, double amount, int32 category, then three u32-length-prefixed strings
+    static std::string pack(const MessageData& data) {
+        std::string out;
+        out.reserve(8 + 8 + 4 + 12 + data.userID.size() + data.message.size() + data.messageID.size());
+        auto raw = [&out](const void* bytes, size_t size) { out.append(static_cast<const char*>(bytes), size); };
+        auto text = [&raw](const std::string& s) {
+            uint32_t size = static_cast<uint32_t>(s.size());
+            raw(&size, sizeof(size));
+            raw(s.data(), s.size());
+        };
+        raw(&data.unixTimestamp, sizeof(data.unixTimestamp));
+        raw(&data.amount, sizeof(data.amount));
+        int32_t category = data.categoryID;
+        raw(&category, sizeof(category));
+        text(data.userID);
+        text(data.message);
+        text(data.messageID);
+        return out;
+    }
+
+    static std::optional<MessageData> unpack(std::string_view in) {
+        MessageData data;
+        size_t pos = 0;
+        auto raw = [&](void* bytes, size_t size) {
+            if (in.size() - pos < size) return false;
+            std::memcpy(bytes, in.data() + pos, size);
+            pos += size;
+            return true;
+        };
+        auto text = [&](std::string& s) {
+            uint32_t size = 0;
+            if (!raw(&size, sizeof(size)) || in.size() - pos < size) return false;
+            s.assign(in.data() + pos, size);
+            pos += size;
+            return true;
+        };
+        int32_t category = 0;
+        if (!raw(&data.unixTimestamp, sizeof(data.unixTimestamp)) || !raw(&data.amount, sizeof(data.amount))
+            || !raw(&category, sizeof(category)) || !text(data.userID) || !text(data.message) || !text(data.messageID)) {
+            return std::nullopt;
+        }
+        data.categoryID = category;
+        return data;
+    }
+
+    std::filesystem::path directory;
+    uint64_t maxBytes;
+    uint64_t segmentBytes;
+    bool usable = false;
+
+    mutable std::mutex mutex;
+    std::unordered_map<std::string, Location, IdHash, std::equal_to<>> index;
+    std::map<uint32_t, uint64_t> segmentSizes;   // segment number -> bytes of valid records
+    std::map<uint32_t, std::unique_ptr<std::ifstream>> readers;
+    std::ofstream writer;
+    uint32_t activeSegment = 1;
+    uint64_t totalBytes = 0;
+    Stats stats;
+};
+
+#endif // RESPONSECACHE_H
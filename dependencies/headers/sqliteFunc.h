@@ -1,3 +1,5 @@
+#ifndef SQLITEFUNC_H
+#define SQLITEFUNC_H
 #include <iostream>
 #include <string>
 #include <sqlite3.h>
@@ -5,6 +7,13 @@
 #include <optional>
 #include <locale>
 #include <codecvt>
+#include <span>
+#include <vector>
+#include "messageData.h"
+#include "database.h"
+#include "columnStore.h"
+#include "asyncIo.h"
+#include "calendar.h"
 
 
 int callback(void* data, int argc, char** argv, char** colName) {
@@ -15,13 +24,11 @@ int callback(void* data, int argc, char** argv, char** colName) {
     return 0;
 }
 
-void addUser(sqlite3* db, std::string username, std::string hashed_password, std::string email) {
-    sqlite3_stmt* stmt;
+void addUser(Database& db, std::string username, std::string hashed_password, std::string email) {
     std::string sql = "INSERT INTO Users (username, password, email) VALUES (?, ?, ?);";
 
-    int rc = sqlite3_prepare_v2(db, sql.c_str(), -1, &stmt, 0);
-    if (rc != SQLITE_OK) {
-        std::cerr << "Failed to prepare statement: " << sqlite3_errmsg(db) << std::endl;
+    Database::Statement stmt = db.prepare(sql);
+    if (!stmt) {
         return;
     }
 
@@ -30,33 +37,29 @@ void addUser(sqlite3* db, std::string username, std::string hashed_password, std
     sqlite3_bind_text(stmt, 3, email.c_str(), -1, SQLITE_STATIC);
 
     // Execute the query
-    rc = sqlite3_step(stmt);
+    int rc = sqlite3_step(stmt);
     if (rc != SQLITE_DONE) {
         std::cerr << "Execution failed: " << sqlite3_errmsg(db) << std::endl;
     }
     else {
         std::cout << "User inserted successfully\n";
     }
-
-    sqlite3_finalize(stmt);
 }
 
-void addTransaction(sqlite3* db, const std::string& message_id, const std::string& user_id,
+// Returns true if the row was inserted; on false, sqlite3_extended_errcode(db) tells why
+bool addTransaction(Database& db, const std::string& message_id, const std::string& user_id,
     double amount, unsigned int category_id, const std::string& message,
     time_t unix_time) {
-    sqlite3_stmt* stmt;
     const char* sql = "INSERT INTO Transactions (MessageID, UserID, Amount, CategoryID, Message, Unix) "
         "VALUES (?, ?, ?, ?, ?, ?);";
 
-    // Prepare the SQL statement
-    int rc = sqlite3_prepare_v2(db, sql, -1, &stmt, nullptr);
-    if (rc != SQLITE_OK) {
-        std::cerr << "Failed to prepare statement: " << sqlite3_errmsg(db) << std::endl;
-        return;
+    Database::Statement stmt = db.prepare(sql);
+    if (!stmt) {
+        return false;
     }
 
     // Bind parameters
-    rc = sqlite3_bind_text(stmt, 1, message_id.c_str(), -1, SQLITE_TRANSIENT);  // MessageID
+    int rc = sqlite3_bind_text(stmt, 1, message_id.c_str(), -1, SQLITE_TRANSIENT);  // MessageID
     if (rc != SQLITE_OK) goto BIND_ERROR;
     rc = sqlite3_bind_text(stmt, 2, user_id.c_str(), -1, SQLITE_TRANSIENT);     // UserID
     if (rc != SQLITE_OK) goto BIND_ERROR;
@@ -76,51 +79,179 @@ void addTransaction(sqlite3* db, const std::string& message_id, const std::strin
     }
     else {
         std::cout << "Transaction added successfully\n";
+        if (TransactionColumns* columns = db.attachedColumns()) {
+            columns->insert(message_id, user_id, amount, static_cast<int>(category_id), unix_time);
+        }
     }
 
-    sqlite3_finalize(stmt);
-    return;
+    return rc == SQLITE_DONE;
 
 BIND_ERROR:
     std::cerr << "Error binding parameters: " << sqlite3_errmsg(db) << std::endl;
-    sqlite3_finalize(stmt);
+    return false;
 }
 
 
 
-void deleteRow(sqlite3* db, const std::string& table, const std::string& column, const std::string& value) {
-    sqlite3_stmt* stmt;
-    std::string sql = "DELETE FROM " + table + " WHERE " + column + " = ?;";
+enum class InsertOutcome {
+    Inserted,
+    Duplicate,  // MessageID already present (primary key conflict)
+    Failed
+};
+
+struct BatchInsertResult {
+    std::vector<InsertOutcome> outcomes;  // one per input row, same order
+    size_t inserted = 0;
+    size_t duplicates = 0;
+    size_t failed = 0;
+};
 
-    int rc = sqlite3_prepare_v2(db, sql.c_str(), -1, &stmt, 0);
+// Inserts a whole batch inside one BEGIN IMMEDIATE/COMMIT with a single reused prepared statement.
+// A failing row is recorded and the batch carries on; only a failed COMMIT turns the batch into failures.
+BatchInsertResult addTransactions(Database& db, std::span<const MessageData> rows) {
+    BatchInsertResult result;
+    result.outcomes.assign(rows.size(), InsertOutcome::Failed);
+    if (rows.empty()) {
+        return result;
+    }
+
+    const char* sql = "INSERT INTO Transactions (MessageID, UserID, Amount, CategoryID, Message, Unix) "
+        "VALUES (?, ?, ?, ?, ?, ?);";
+
+    Database::Statement stmt = db.prepare(sql);
+    if (!stmt) {
+        result.failed = rows.size();
+        return result;
+    }
+
+    int rc = sqlite3_exec(db, "BEGIN IMMEDIATE;", nullptr, nullptr, nullptr);
     if (rc != SQLITE_OK) {
-        std::cerr << "Failed to prepare statement: " << sqlite3_errmsg(db) << std::endl;
+        std::cerr << "Failed to begin transaction: " << sqlite3_errmsg(db) << std::endl;
+        result.failed = rows.size();
+        return result;
+    }
+
+    size_t transactionStart = 0;  // first row of the currently open transaction
+    for (size_t i = 0; i < rows.size(); ++i) {
+        const MessageData& row = rows[i];
+
+        // Text is bound SQLITE_STATIC: rows outlive the step below
+        sqlite3_bind_text(stmt, 1, row.messageID.c_str(), static_cast<int>(row.messageID.size()), SQLITE_STATIC);
+        sqlite3_bind_text(stmt, 2, row.userID.c_str(), static_cast<int>(row.userID.size()), SQLITE_STATIC);
+        sqlite3_bind_double(stmt, 3, row.amount);
+        sqlite3_bind_int(stmt, 4, row.categoryID);
+        sqlite3_bind_text(stmt, 5, row.message.c_str(), static_cast<int>(row.message.size()), SQLITE_STATIC);
+        sqlite3_bind_int64(stmt, 6, row.unixTimestamp);
+
+        rc = sqlite3_step(stmt);
+        if (rc == SQLITE_DONE) {
+            result.outcomes[i] = InsertOutcome::Inserted;
+        }
+        else if (sqlite3_extended_errcode(db) == SQLITE_CONSTRAINT_PRIMARYKEY) {
+            result.outcomes[i] = InsertOutcome::Duplicate;
+        }
+        else {
+            std::cerr << "Insert failed for MessageID " << row.messageID << ": " << sqlite3_errmsg(db) << std::endl;
+            result.outcomes[i] = InsertOutcome::Failed;
+
+            // Errors like SQLITE_FULL roll the whole transaction back: earlier rows are lost, start a new one
+            if (sqlite3_get_autocommit(db)) {
+                for (size_t j = transactionStart; j < i; ++j) {
+                    if (result.outcomes[j] == InsertOutcome::Inserted) {
+                        result.outcomes[j] = InsertOutcome::Failed;
+                    }
+                }
+                transactionStart = i + 1;
+                if (sqlite3_exec(db, "BEGIN IMMEDIATE;", nullptr, nullptr, nullptr) != SQLITE_OK) {
+                    std::cerr << "Failed to begin transaction: " << sqlite3_errmsg(db) << std::endl;
+                    sqlite3_reset(stmt);
+                    break;
+                }
+            }
+        }
+
+        sqlite3_reset(stmt);
+        sqlite3_clear_bindings(stmt);
+    }
+
+    if (!sqlite3_get_autocommit(db)) {
+        if (sqlite3_exec(db, "COMMIT;", nullptr, nullptr, nullptr) != SQLITE_OK) {
+            std::cerr << "Failed to commit transaction: " << sqlite3_errmsg(db) << std::endl;
+            sqlite3_exec(db, "ROLLBACK;", nullptr, nullptr, nullptr);
+            for (size_t j = transactionStart; j < rows.size(); ++j) {
+                if (result.outcomes[j] == InsertOutcome::Inserted) {
+                    result.outcomes[j] = InsertOutcome::Failed;
+                }
+            }
+        }
+    }
+
+    std::vector<const MessageData*> committed;
+    for (size_t i = 0; i < rows.size(); ++i) {
+        switch (result.outcomes[i]) {
+        case InsertOutcome::Inserted: ++result.inserted; committed.push_back(&rows[i]); break;
+        case InsertOutcome::Duplicate: ++result.duplicates; break;
+        case InsertOutcome::Failed: ++result.failed; break;
+        }
+    }
+    if (TransactionColumns* columns = db.attachedColumns()) {
+        columns->insert(committed);
+    }
+    return result;
+}
+
+// Runs addTransaction on the writer thread; the awaiting coroutine resumes on the writer's event loop
+Task<bool> addTransactionAsync(WriterExecutor& writer, Database& db, MessageData row) {
+    co_return co_await writer.run([&db, &row] {
+        return addTransaction(db, row.messageID, row.userID, row.amount, row.categoryID, row.message, row.unixTimestamp);
+    });
+}
+
+// Runs addTransactions (one transaction for the whole batch) on the writer thread
+Task<BatchInsertResult> addTransactionsAsync(WriterExecutor& writer, Database& db, std::vector<MessageData> rows) {
+    co_return co_await writer.run([&db, &rows] { return addTransactions(db, rows); });
+}
+
+void deleteRow(Database& db, const std::string& table, const std::string& column, const std::string& value) {
+    std::string sql = "DELETE FROM " + table + " WHERE " + column + " = ?;";
+
+    Database::Statement stmt = db.prepare(sql);
+    if (!stmt) {
         return;
     }
 
     sqlite3_bind_text(stmt, 1, value.c_str(), -1, SQLITE_STATIC);
 
-    rc = sqlite3_step(stmt);
+    int rc = sqlite3_step(stmt);
     if (rc != SQLITE_DONE) {
         std::cerr << "Execution failed: " << sqlite3_errmsg(db) << std::endl;
+        return;
     }
-    else {
-        std::cout << "Row deleted successfully\n";
-    }
+    std::cout << "Row deleted successfully\n";
 
-    sqlite3_finalize(stmt);
+    TransactionColumns* columns = db.attachedColumns();
+    if (columns && table == "Transactions" && sqlite3_changes(db) > 0) {
+        if (column == "MessageID") {
+            columns->erase(value);
+        }
+        else if (column == "UserID") {
+            columns->eraseUser(value);
+        }
+        else {
+            columns->loadFromDatabase(db);   // no cheaper way to find the rows of other columns
+        }
+    }
 }
 
-void selectTable(sqlite3* db, std::string object, std::string place) {
-    sqlite3_stmt* stmt;
+void selectTable(Database& db, std::string object, std::string place) {
     std::string sql = "SELECT " + object + " FROM '" + place + "';";
 
-    int rc = sqlite3_prepare_v2(db, sql.c_str(), -1, &stmt, 0);
-    if (rc != SQLITE_OK) {
-        std::cerr << "Failed to prepare statement: " << sqlite3_errmsg(db) << std::endl;
+    Database::Statement stmt = db.prepare(sql);
+    if (!stmt) {
         return;
     }
 
+    int rc;
     while ((rc = sqlite3_step(stmt)) == SQLITE_ROW) {
         int numColumns = sqlite3_column_count(stmt);
         char** colNames = new char* [numColumns]; 
@@ -140,32 +271,329 @@ void selectTable(sqlite3* db, std::string object, std::string place) {
     if (rc != SQLITE_DONE) {
         std::cerr << "Execution failed: " << sqlite3_errmsg(db) << std::endl;
     }
-
-    sqlite3_finalize(stmt);
 }
 
 
-std::optional<std::string> getItem(sqlite3* db, const std::string& table, const std::string& column, const std::string& conditionColumn, const std::string& conditionValue) {
-    sqlite3_stmt* stmt;
+std::optional<std::string> getItem(Database& db, const std::string& table, const std::string& column, const std::string& conditionColumn, const std::string& conditionValue) {
     std::string sql = "SELECT " + column + " FROM " + table + " WHERE " + conditionColumn + " = ?;";
 
-    int rc = sqlite3_prepare_v2(db, sql.c_str(), -1, &stmt, 0);
-    if (rc != SQLITE_OK) {
-        std::cerr << "Failed to prepare statement: " << sqlite3_errmsg(db) << std::endl;
+    Database::Statement stmt = db.prepare(sql);
+    if (!stmt) {
         return std::nullopt;
     }
 
     sqlite3_bind_text(stmt, 1, conditionValue.c_str(), -1, SQLITE_STATIC);
 
-    rc = sqlite3_step(stmt);
+    int rc = sqlite3_step(stmt);
     if (rc == SQLITE_ROW) {
         std::string result = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 0));
-        sqlite3_finalize(stmt);
         return result;
     }
     else {
         std::cerr << "No data found or execution failed: " << sqlite3_errmsg(db) << std::endl;
-        sqlite3_finalize(stmt);
         return std::nullopt;
     }
-}
\ No newline at end of file
+}
+
+//---------------------------------------------------------------------------------------------------
+//------------------PER-USER SETTINGS----------------------------------------------------------------
+//---------------------------------------------------------------------------------------------------
+std::optional<std::string> getSetting(Database& db, const std::string& user_id, const std::string& setting_name) {
+    const char* sql = "SELECT setting_value FROM Settings WHERE user_id = ? AND setting_name = ? "
+        "ORDER BY setting_id DESC LIMIT 1;";
+
+    Database::Statement stmt = db.prepare(sql);
+    if (!stmt) {
+        return std::nullopt;
+    }
+
+    sqlite3_bind_text(stmt, 1, user_id.c_str(), -1, SQLITE_STATIC);
+    sqlite3_bind_text(stmt, 2, setting_name.c_str(), -1, SQLITE_STATIC);
+
+    std::optional<std::string> result;
+    if (sqlite3_step(stmt) == SQLITE_ROW) {
+        result = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 0));
+    }
+
+    return result;
+}
+
+// Settings has no unique key on (user_id, setting_name), so update first and insert only if nothing matched
+bool setSetting(Database& db, const std::string& user_id, const std::string& setting_name, const std::string& setting_value) {
+    const char* updateSql = "UPDATE Settings SET setting_value = ? WHERE user_id = ? AND setting_name = ?;";
+
+    Database::Statement stmt = db.prepare(updateSql);
+    if (!stmt) {
+        return false;
+    }
+
+    sqlite3_bind_text(stmt, 1, setting_value.c_str(), -1, SQLITE_STATIC);
+    sqlite3_bind_text(stmt, 2, user_id.c_str(), -1, SQLITE_STATIC);
+    sqlite3_bind_text(stmt, 3, setting_name.c_str(), -1, SQLITE_STATIC);
+    int rc = sqlite3_step(stmt);
+
+    if (rc != SQLITE_DONE) {
+        std::cerr << "Execution failed: " << sqlite3_errmsg(db) << std::endl;
+        return false;
+    }
+    if (sqlite3_changes(db) > 0) {
+        return true;
+    }
+
+    const char* insertSql = "INSERT INTO Settings (user_id, setting_name, setting_value) VALUES (?, ?, ?);";
+    stmt = db.prepare(insertSql);
+    if (!stmt) {
+        return false;
+    }
+
+    sqlite3_bind_text(stmt, 1, user_id.c_str(), -1, SQLITE_STATIC);
+    sqlite3_bind_text(stmt, 2, setting_name.c_str(), -1, SQLITE_STATIC);
+    sqlite3_bind_text(stmt, 3, setting_value.c_str(), -1, SQLITE_STATIC);
+    rc = sqlite3_step(stmt);
+
+    if (rc != SQLITE_DONE) {
+        std::cerr << "Execution failed: " << sqlite3_errmsg(db) << std::endl;
+        return false;
+    }
+    return true;
+}
+
+//---------------------------------------------------------------------------------------------------
+//------------------INCREMENTAL SYNC CURSOR----------------------------------------------------------
+//---------------------------------------------------------------------------------------------------
+// High-water mark of what has been ingested for a user: everything at or before
+// (timestamp, lastMessageID) is already stored in Transactions.
+struct SyncCursor {
+    int64_t timestamp = 0;
+    std::string lastMessageID;
+
+    // True if a MessageID with the given timestamp sorts after the cursor (timestamp first, then MessageID)
+    bool isBefore(int64_t messageTimestamp, const std::string& messageID) const {
+        if (messageTimestamp != timestamp) {
+            return messageTimestamp > timestamp;
+        }
+        return messageID > lastMessageID;
+    }
+};
+
+const std::string SYNC_CURSOR_TIMESTAMP = "sync_cursor_unix";
+const std::string SYNC_CURSOR_MESSAGE_ID = "sync_cursor_message_id";
+
+SyncCursor getSyncCursor(Database& db, const std::string& user_id) {
+    SyncCursor cursor;
+    auto timestamp = getSetting(db, user_id, SYNC_CURSOR_TIMESTAMP);
+    auto messageID = getSetting(db, user_id, SYNC_CURSOR_MESSAGE_ID);
+    if (!timestamp || !messageID) {
+        return cursor;
+    }
+
+    try {
+        cursor.timestamp = std::stoll(*timestamp);
+        cursor.lastMessageID = *messageID;
+    }
+    catch (const std::exception& e) {
+        std::cerr << "Invalid sync cursor for user " << user_id << ": " << e.what() << std::endl;
+        return SyncCursor{};
+    }
+    return cursor;
+}
+
+// Both settings are written in one transaction so the cursor is never half-updated
+bool setSyncCursor(Database& db, const std::string& user_id, const SyncCursor& cursor) {
+    if (sqlite3_exec(db, "BEGIN;", nullptr, nullptr, nullptr) != SQLITE_OK) {
+        std::cerr << "Failed to begin transaction: " << sqlite3_errmsg(db) << std::endl;
+        return false;
+    }
+
+    bool ok = setSetting(db, user_id, SYNC_CURSOR_TIMESTAMP, std::to_string(cursor.timestamp)) &&
+        setSetting(db, user_id, SYNC_CURSOR_MESSAGE_ID, cursor.lastMessageID);
+
+    sqlite3_exec(db, ok ? "COMMIT;" : "ROLLBACK;", nullptr, nullptr, nullptr);
+    return ok;
+}
+
+//---------------------------------------------------------------------------------------------------
+//------------------SCHEMA MIGRATIONS----------------------------------------------------------------
+//---------------------------------------------------------------------------------------------------
+// Local start of day in SQL: septim_day_start() is registered on every connection (database.h) and
+// calls the zone table behind getStartOfDay(), so rollup rows and report boundaries always agree.
+// The zone it used is recorded and checked at startup by ensureRollupZone()
+#define DAY_START_SQL(column) "septim_day_start(" column ")"
+
+// What migration 2 used: SQLite's own 'localtime', whose start of day differs from getStartOfDay()
+// where DST begins at midnight (the day then starts at 01:00, not at 23:00 of the day before)
+#define LIBRARY_DAY_START_SQL(column) "CAST(strftime('%s', " column ", 'unixepoch', 'localtime', 'start of day', 'utc') AS INTEGER)"
+
+#define ROLLUP_FILL_WITH(DAY_START) \
+    "INSERT INTO DailyTotals (user_id, category_id, day_start, sum_amount, count) " \
+    "SELECT UserID, CategoryID, " DAY_START("Unix") ", TOTAL(Amount), COUNT(*) " \
+    "FROM Transactions GROUP BY 1, 2, 3;"
+
+#define ROLLUP_FILL_SQL ROLLUP_FILL_WITH(DAY_START_SQL)
+
+#define ROLLUP_TRIGGERS_WITH(DAY_START) \
+    "CREATE TRIGGER IF NOT EXISTS trg_transactions_rollup_insert AFTER INSERT ON Transactions BEGIN " \
+    "    INSERT INTO DailyTotals (user_id, category_id, day_start, sum_amount, count) " \
+    "    VALUES (NEW.UserID, NEW.CategoryID, " DAY_START("NEW.Unix") ", NEW.Amount, 1) " \
+    "    ON CONFLICT (user_id, day_start, category_id) DO UPDATE SET " \
+    "        sum_amount = sum_amount + excluded.sum_amount, count = count + 1;" \
+    "END;" \
+    "CREATE TRIGGER IF NOT EXISTS trg_transactions_rollup_delete AFTER DELETE ON Transactions BEGIN " \
+    "    UPDATE DailyTotals SET sum_amount = sum_amount - OLD.Amount, count = count - 1 " \
+    "    WHERE user_id = OLD.UserID AND category_id = OLD.CategoryID AND day_start = " DAY_START("OLD.Unix") ";" \
+    "    DELETE FROM DailyTotals WHERE user_id = OLD.UserID AND category_id = OLD.CategoryID " \
+    "        AND day_start = " DAY_START("OLD.Unix") " AND count <= 0;" \
+    "END;" \
+    "CREATE TRIGGER IF NOT EXISTS trg_transactions_rollup_update AFTER UPDATE OF UserID, CategoryID, Amount, Unix ON Transactions BEGIN " \
+    "    UPDATE DailyTotals SET sum_amount = sum_amount - OLD.Amount, count = count - 1 " \
+    "    WHERE user_id = OLD.UserID AND category_id = OLD.CategoryID AND day_start = " DAY_START("OLD.Unix") ";" \
+    "    DELETE FROM DailyTotals WHERE user_id = OLD.UserID AND category_id = OLD.CategoryID " \
+    "        AND day_start = " DAY_START("OLD.Unix") " AND count <= 0;" \
+    "    INSERT INTO DailyTotals (user_id, category_id, day_start, sum_amount, count) " \
+    "    VALUES (NEW.UserID, NEW.CategoryID, " DAY_START("NEW.Unix") ", NEW.Amount, 1) " \
+    "    ON CONFLICT (user_id, day_start, category_id) DO UPDATE SET " \
+    "        sum_amount = sum_amount + excluded.sum_amount, count = count + 1;" \
+    "END;"
+
+// Each step upgrades the schema by one version; PRAGMA user_version stores how many have been applied.
+// Append new steps at the end, never edit or reorder existing ones.
+const std::vector<const char*> SCHEMA_MIGRATIONS = {
+    // 1: covering index for per-user range reports (SUM/COUNT of Amount over Unix, optionally per category)
+    "CREATE INDEX IF NOT EXISTS idx_transactions_user_unix_amount "
+    "ON Transactions (UserID, Unix, Amount, CategoryID);",
+
+    // 2: DailyTotals rollup, kept in step with Transactions by triggers (same transaction as the write)
+    "CREATE TABLE IF NOT EXISTS DailyTotals ("
+    "    user_id TEXT NOT NULL,"
+    "    category_id INTEGER NOT NULL,"
+    "    day_start INTEGER NOT NULL,"
+    "    sum_amount REAL NOT NULL,"
+    "    count INTEGER NOT NULL,"
+    "    PRIMARY KEY (user_id, day_start, category_id)"
+    ") WITHOUT ROWID;"
+    ROLLUP_TRIGGERS_WITH(LIBRARY_DAY_START_SQL)
+    "DELETE FROM DailyTotals;"
+    ROLLUP_FILL_WITH(LIBRARY_DAY_START_SQL),
+
+    // 3: day_start from the calendar code instead of SQLite's 'localtime'; triggers replaced, rollup refilled
+    "DROP TRIGGER IF EXISTS trg_transactions_rollup_insert;"
+    "DROP TRIGGER IF EXISTS trg_transactions_rollup_delete;"
+    "DROP TRIGGER IF EXISTS trg_transactions_rollup_update;"
+    ROLLUP_TRIGGERS_WITH(DAY_START_SQL)
+    "DELETE FROM DailyTotals;"
+    ROLLUP_FILL_SQL,
+};
+
+bool migrateSchema(Database& db) {
+    int version = 0;
+    {
+        Database::Statement stmt = db.prepare("PRAGMA user_version;");
+        if (!stmt) {
+            return false;
+        }
+        if (sqlite3_step(stmt) == SQLITE_ROW) {
+            version = sqlite3_column_int(stmt, 0);
+        }
+    }
+
+    for (size_t step = static_cast<size_t>(version); step < SCHEMA_MIGRATIONS.size(); ++step) {
+        std::string sql = std::string("BEGIN IMMEDIATE;") + SCHEMA_MIGRATIONS[step] +
+            "PRAGMA user_version = " + std::to_string(step + 1) + ";COMMIT;";
+
+        char* errorMessage = nullptr;
+        if (sqlite3_exec(db, sql.c_str(), nullptr, nullptr, &errorMessage) != SQLITE_OK) {
+            std::cerr << "Schema migration " << (step + 1) << " failed: "
+                << (errorMessage ? errorMessage : sqlite3_errmsg(db)) << std::endl;
+            sqlite3_free(errorMessage);
+            sqlite3_exec(db, "ROLLBACK;", nullptr, nullptr, nullptr);
+            return false;
+        }
+        std::cout << "Applied schema migration " << (step + 1) << std::endl;
+    }
+    return true;
+}
+
+//---------------------------------------------------------------------------------------------------
+//------------------DAILY ROLLUP MAINTENANCE---------------------------------------------------------
+//---------------------------------------------------------------------------------------------------
+// day_start is computed when a row is written, so DailyTotals is only valid for the zone rules and the
+// day-start code it was built with. Both are fingerprinted (calendar.h) and kept in Settings under the
+// database's own user_id ""; ensureRollupZone() rebuilds the rollup when the fingerprint no longer matches.
+const std::string DATABASE_SETTINGS_USER = "";
+const std::string ROLLUP_ZONE_SETTING = "rollup_zone";
+
+// Bump when DAY_START_SQL changes meaning: rollups recorded under the old code are rebuilt
+constexpr int ROLLUP_DAY_START_VERSION = 2;   // 2: septim_day_start() instead of SQLite 'localtime'
+
+std::string rollupZoneFingerprint() {
+    return std::to_string(ROLLUP_DAY_START_VERSION) + ":" + std::to_string(TimeZoneTable::local().fingerprint());
+}
+
+// Recomputes DailyTotals from Transactions and records the zone it was built for
+bool rebuildDailyTotals(Database& db) {
+    std::string sql = std::string("BEGIN IMMEDIATE;DELETE FROM DailyTotals;") + ROLLUP_FILL_SQL;
+
+    char* errorMessage = nullptr;
+    if (sqlite3_exec(db, sql.c_str(), nullptr, nullptr, &errorMessage) != SQLITE_OK
+        || !setSetting(db, DATABASE_SETTINGS_USER, ROLLUP_ZONE_SETTING, rollupZoneFingerprint())
+        || sqlite3_exec(db, "COMMIT;", nullptr, nullptr, &errorMessage) != SQLITE_OK) {
+        std::cerr << "Failed to rebuild DailyTotals: " << (errorMessage ? errorMessage : sqlite3_errmsg(db)) << std::endl;
+        sqlite3_free(errorMessage);
+        sqlite3_exec(db, "ROLLBACK;", nullptr, nullptr, nullptr);
+        return false;
+    }
+    std::cout << "DailyTotals rebuilt" << std::endl;
+    return true;
+}
+
+// Call at startup, after migrateSchema(): a rollup built under other zone rules (or under unknown
+// ones, before the fingerprint was recorded) would mix stale whole days with fresh partial days
+bool ensureRollupZone(Database& db) {
+    std::optional<std::string> stored = getSetting(db, DATABASE_SETTINGS_USER, ROLLUP_ZONE_SETTING);
+    if (stored == rollupZoneFingerprint()) {
+        return true;
+    }
+    std::cout << (stored ? "Time zone rules changed since DailyTotals was built" : "DailyTotals has no recorded time zone")
+        << ", rebuilding it" << std::endl;
+    return rebuildDailyTotals(db);
+}
+
+// Compares DailyTotals with an aggregate of the raw rows; returns the number of mismatching
+// (user, category, day) entries, or -1 if the check could not run
+long long checkDailyTotals(Database& db) {
+    const char* sql =
+        "WITH raw AS ("
+        "    SELECT UserID AS user_id, CategoryID AS category_id, " DAY_START_SQL("Unix") " AS day_start,"
+        "           TOTAL(Amount) AS sum_amount, COUNT(*) AS count "
+        "    FROM Transactions GROUP BY 1, 2, 3) "
+        "SELECT COALESCE(r.user_id, d.user_id), COALESCE(r.category_id, d.category_id), COALESCE(r.day_start, d.day_start),"
+        "       r.sum_amount, r.count, d.sum_amount, d.count "
+        "FROM raw r FULL OUTER JOIN DailyTotals d "
+        "    ON r.user_id = d.user_id AND r.category_id = d.category_id AND r.day_start = d.day_start "
+        "WHERE r.count IS NOT d.count OR ABS(COALESCE(r.sum_amount, 0) - COALESCE(d.sum_amount, 0)) > 0.005;";
+
+    Database::Statement stmt = db.prepare(sql);
+    if (!stmt) {
+        return -1;
+    }
+
+    long long mismatches = 0;
+    int rc;
+    while ((rc = sqlite3_step(stmt)) == SQLITE_ROW) {
+        ++mismatches;
+        std::cerr << "DailyTotals mismatch: user " << sqlite3_column_text(stmt, 0)
+            << ", category " << sqlite3_column_int(stmt, 1)
+            << ", day " << sqlite3_column_int64(stmt, 2)
+            << ": raw " << sqlite3_column_double(stmt, 3) << " (" << sqlite3_column_int64(stmt, 4) << ")"
+            << " vs rollup " << sqlite3_column_double(stmt, 5) << " (" << sqlite3_column_int64(stmt, 6) << ")" << std::endl;
+    }
+    if (rc != SQLITE_DONE) {
+        std::cerr << "Execution failed: " << sqlite3_errmsg(db) << std::endl;
+        return -1;
+    }
+
+    std::cout << "DailyTotals check: " << mismatches << " mismatches" << std::endl;
+    return mismatches;
+}
+
+#endif // SQLITEFUNC_H
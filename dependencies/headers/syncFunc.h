@@ -0,0 +1,145 @@
+#ifndef SYNCFUNC_H
+#define SYNCFUNC_H
+#include "pipeline.h"
+#include <algorithm>
+#include <unordered_set>
+#include <thread>
+#include <mutex>
+
+struct SyncResult {
+    size_t candidates = 0;  // IDs newer than the cursor
+    size_t stored = 0;      // inserted now or already present
+    size_t failed = 0;      // fetch or insert failed; retried on the next sync
+    SyncCursor cursor;      // cursor after the sync
+    PipelineStats pipeline;
+};
+
+// Fetches and stores only the messages newer than the user's sync cursor, then advances the cursor.
+// Fetching starts with the first matching ID of the /getid stream, while the rest is still listed.
+// The cursor only moves past a contiguous run of stored messages, and only after a complete listing,
+// so a failed fetch or a broken listing is retried next time.
+// With `known`, IDs already in Transactions are dropped before fetching and newly stored ones are added.
+SyncResult syncUser(Database& db, const std::string& userID, const PipelineOptions& options = PipelineOptions(),
+    HttpClient& client = defaultHttpClient(), KnownMessageIds* known = nullptr) {
+    SyncResult result;
+    result.cursor = getSyncCursor(db, userID);
+
+    // The listing keeps IDs at or after the cursor second; drop the ones already covered by it
+    MessageIdFeed feed;
+    std::vector<std::pair<int64_t, std::string>> pending;
+    size_t alreadyKnown = 0;
+    std::mutex knownMutex;  // the lister reads `known` while the writer adds to it
+    auto onMatch = [&](const std::string& messageID) {
+        auto view = MessageIdView::parse(messageID);
+        if (!view.has_value() || !result.cursor.isBefore(view->timestamp, messageID)) {
+            return;
+        }
+        if (known) {
+            std::lock_guard<std::mutex> lock(knownMutex);
+            if (known->contains(messageID)) {
+                ++alreadyKnown;
+                return;
+            }
+        }
+        pending.emplace_back(view->timestamp, messageID);
+        feed.push(messageID);
+    };
+
+    std::unordered_set<std::string> stored;
+    auto onStored = [&stored, &knownMutex, known](const std::string& messageID) {
+        stored.insert(messageID);
+        if (known) {
+            std::lock_guard<std::mutex> lock(knownMutex);
+            known->add(messageID);
+        }
+    };
+    time_t since = static_cast<time_t>(result.cursor.timestamp);
+    bool listed = false;
+    if (options.eventLoop) {
+        // Lister and fetchers are coroutines on the same loop
+        EventLoop& loop = threadEventLoop();
+        WriterExecutor writer(loop);
+        auto list = [&]() -> Task<void> {
+            listed = co_await streamActualIDsAsync(loop, userID, since, onMatch, client);
+            feed.close();
+        };
+        auto ingest = [&]() -> Task<void> {
+            result.pipeline = co_await ingestMessagesAsync(loop, writer, db, feed, onStored, options, receiveEndpoint(), client);
+        };
+        std::vector<Task<void>> tasks;
+        tasks.push_back(list());
+        tasks.push_back(ingest());
+        syncWait(loop, whenAll(std::move(tasks)));
+    }
+    else {
+        std::thread lister([&]() {
+            listed = streamActualIDs(userID, since, onMatch, client);
+            feed.close();
+        });
+        result.pipeline = ingestMessages(db, feed, onStored, options, receiveEndpoint(), client);
+        lister.join();
+    }
+
+    if (alreadyKnown > 0) {
+        std::cout << "Skipped " << alreadyKnown << " MessageIDs that are already stored" << std::endl;
+    }
+    std::sort(pending.begin(), pending.end());
+    result.candidates = pending.size();
+    if (pending.empty() && listed) {
+        std::cout << "User '" << userID << "' is up to date" << std::endl;
+        return result;
+    }
+
+    result.stored = stored.size();
+    result.failed = pending.size() - stored.size();
+
+    // Advance over the sorted IDs until the first one that did not make it into the database
+    SyncCursor advanced = result.cursor;
+    for (const auto& [timestamp, messageID] : pending) {
+        if (!stored.count(messageID)) {
+            break;
+        }
+        advanced.timestamp = timestamp;
+        advanced.lastMessageID = messageID;
+    }
+
+    // IDs missing from a broken listing may sort before the ones that were stored
+    if (listed && (advanced.timestamp != result.cursor.timestamp || advanced.lastMessageID != result.cursor.lastMessageID)) {
+        if (setSyncCursor(db, userID, advanced)) {
+            result.cursor = advanced;
+        }
+    }
+
+    return result;
+}
+
+// Refills the Transactions table from the response cache alone, with no network calls.
+// Returns the number of cached messages that are in the database afterwards.
+size_t restoreFromCache(Database& db, ResponseCache& cache) {
+    const size_t insertBatchSize = 256;
+    std::vector<MessageData> batch;
+    batch.reserve(insertBatchSize);
+    size_t stored = 0;
+
+    auto flush = [&]() {
+        BatchInsertResult inserted = addTransactions(db, batch);
+        stored += inserted.inserted + inserted.duplicates;
+        batch.clear();
+    };
+
+    std::vector<std::string> messageIDs = cache.messageIDs();
+    for (const auto& messageID : messageIDs) {
+        if (auto data = cache.get(messageID)) {
+            batch.push_back(std::move(*data));
+            if (batch.size() >= insertBatchSize) {
+                flush();
+            }
+        }
+    }
+    flush();
+
+    std::cout << "Restored " << stored << " of " << messageIDs.size() << " cached messages" << std::endl;
+    return stored;
+}
+
+#endif // SYNCFUNC_H
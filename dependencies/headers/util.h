@@ -1,12 +1,16 @@
 ﻿#ifndef UTIL_H
 #define UTIL_H 
 #include <string>
+#include <string_view>
+#include <span>
+#include <algorithm>
 #include <optional>
 #include <iomanip>
 #include <iostream>
 #include <ctime>
 #include <sstream>
-#include <sqlite3.h>
+#include "sqliteFunc.h"
+#include "calendar.h"
 using namespace std;
 
 std::time_t getCurrentTime() {
@@ -16,61 +20,194 @@ std::time_t getCurrentTime() {
 //---------------------------------------------------------------------------------------------------
 //------------------GETTING THE UNIX TIME OF THE STARTS----------------------------------------------
 //---------------------------------------------------------------------------------------------------
+// Local (process time zone) boundaries from the precomputed transition table in calendar.h
 time_t getStartOfDay(time_t timestamp) {
-    struct tm timeInfo;
-    localtime_s(&timeInfo, &timestamp);  // Use localtime_s for safety
-    timeInfo.tm_hour = 0;               // Reset hours
-    timeInfo.tm_min = 0;                // Reset minutes
-    timeInfo.tm_sec = 0;                // Reset seconds
-    return mktime(&timeInfo);           // Convert back to UNIX time
+    return static_cast<time_t>(TimeZoneTable::local().startOfDay(timestamp));
 }
 
+// Weeks start on Monday
 time_t getStartOfWeek(time_t timestamp) {
-    struct tm timeInfo;
-    localtime_s(&timeInfo, &timestamp);  // Convert to broken-down local time
+    return static_cast<time_t>(TimeZoneTable::local().startOfWeek(timestamp));
+}
 
-    // Adjust to the start of the week (Sunday + 0) or Monday(+1)
-    timeInfo.tm_mday -= (timeInfo.tm_wday + 6) % 7; // Subtract the number of days since Sunday
-    timeInfo.tm_hour = 0;                 // Reset hours
-    timeInfo.tm_min = 0;                  // Reset minutes
-    timeInfo.tm_sec = 0;                  // Reset seconds
+time_t getStartOfMonth(time_t timestamp) {
+    return static_cast<time_t>(TimeZoneTable::local().startOfMonth(timestamp));
+}
 
-    return mktime(&timeInfo);             // Convert back to UNIX time
+time_t getStartOfYear(time_t timestamp) {
+    return static_cast<time_t>(TimeZoneTable::local().startOfYear(timestamp));
 }
+//---------------------------------------------------------------------------------------------------
+//------------------DATE-TIME TEXT "dd-mm-yyyy HH:MM:SS"---------------------------------------------
+//---------------------------------------------------------------------------------------------------
+// Hand-rolled instead of get_time/strftime: no stream, no locale, no allocation; local time comes
+// from the zone table in calendar.h.
+constexpr size_t DATE_TIME_LENGTH = 19;
 
-time_t getStartOfMonth(time_t timestamp) {
-    struct tm timeInfo;
-    localtime_s(&timeInfo, &timestamp); // Use localtime_s for safety
-    timeInfo.tm_mday = 1;               // Reset to the first day of the month
-    timeInfo.tm_hour = 0;               // Reset hours
-    timeInfo.tm_min = 0;                // Reset minutes
-    timeInfo.tm_sec = 0;                // Reset seconds
-    return mktime(&timeInfo);           // Convert back to UNIX time
+struct DateTimeFields {
+    int year = 1970;
+    int month = 1;
+    int day = 1;
+    int hour = 0;
+    int minute = 0;
+    int second = 0;
+};
+
+// 1..maxDigits decimal digits at text[pos]
+bool readDateTimeNumber(std::string_view text, size_t& pos, size_t maxDigits, int& value) {
+    size_t first = pos;
+    value = 0;
+    while (pos < text.size() && pos - first < maxDigits && text[pos] >= '0' && text[pos] <= '9') {
+        value = value * 10 + (text[pos++] - '0');
+    }
+    return pos > first;
 }
+
+// Accepts what get_time accepted with this format: leading whitespace, one- or two-digit fields,
+// any run of whitespace between date and time; anything after the seconds is ignored
+std::optional<DateTimeFields> parseDateTimeFields(std::string_view text) {
+    auto isSpace = [](char c) { return c == ' ' || (c >= '\t' && c <= '\r'); };
+    auto skipSpaces = [&](size_t& pos) {
+        while (pos < text.size() && isSpace(text[pos])) {
+            ++pos;
+        }
+    };
+    auto literal = [&](size_t& pos, char c) {
+        return pos < text.size() && text[pos++] == c;
+    };
+
+    DateTimeFields fields;
+    size_t pos = 0;
+    skipSpaces(pos);
+    bool ok = readDateTimeNumber(text, pos, 2, fields.day) && literal(pos, '-')
+        && readDateTimeNumber(text, pos, 2, fields.month) && literal(pos, '-')
+        && readDateTimeNumber(text, pos, 4, fields.year);
+    if (ok) {
+        skipSpaces(pos);
+        ok = readDateTimeNumber(text, pos, 2, fields.hour) && literal(pos, ':')
+            && readDateTimeNumber(text, pos, 2, fields.minute) && literal(pos, ':')
+            && readDateTimeNumber(text, pos, 2, fields.second);
+    }
+    if (!ok || fields.day < 1 || fields.day > 31 || fields.month < 1 || fields.month > 12
+        || fields.hour > 23 || fields.minute > 59 || fields.second > 60) {
+        return std::nullopt;
+    }
+    return fields;
+}
+
+// Local wall-clock text to a Unix timestamp
+std::optional<time_t> parseLocalDateTime(std::string_view text) {
+    std::optional<DateTimeFields> fields = parseDateTimeFields(text);
+    if (!fields) {
+        return std::nullopt;
+    }
+    int64_t local = daysFromCivil(fields->year, fields->month, fields->day) * TimeZoneTable::SECONDS_PER_DAY
+        + fields->hour * 3600 + fields->minute * 60 + fields->second;
+    return static_cast<time_t>(TimeZoneTable::local().toUtc(local));
+}
+
+void writeTwoDigits(char* out, int64_t value) {
+    out[0] = static_cast<char>('0' + value / 10);
+    out[1] = static_cast<char>('0' + value % 10);
+}
+
+// "dd-mm-yyyy " of a local day number
+bool writeLocalDate(char* out, int64_t day) {
+    CivilDate date = civilFromDays(day);
+    if (date.year < 0 || date.year > 9999) {
+        return false;
+    }
+    writeTwoDigits(out, date.day);
+    out[2] = '-';
+    writeTwoDigits(out + 3, date.month);
+    out[5] = '-';
+    writeTwoDigits(out + 6, date.year / 100);
+    writeTwoDigits(out + 8, date.year % 100);
+    out[10] = ' ';
+    return true;
+}
+
+// "HH:MM:SS" of a second of the local day
+void writeLocalTime(char* out, int64_t secondOfDay) {
+    writeTwoDigits(out, secondOfDay / 3600);
+    out[2] = ':';
+    writeTwoDigits(out + 3, secondOfDay / 60 % 60);
+    out[5] = ':';
+    writeTwoDigits(out + 6, secondOfDay % 60);
+}
+
+// Writes DATE_TIME_LENGTH characters (no terminator); returns 0 if out is too small or the year
+// does not have four digits
+size_t formatLocalDateTime(time_t raw_time, std::span<char> out) {
+    if (out.size() < DATE_TIME_LENGTH) {
+        return 0;
+    }
+    int64_t local = TimeZoneTable::local().toLocal(raw_time);
+    int64_t day = floorDiv(local, TimeZoneTable::SECONDS_PER_DAY);
+    if (!writeLocalDate(out.data(), day)) {
+        return 0;
+    }
+    writeLocalTime(out.data() + 11, local - day * TimeZoneTable::SECONDS_PER_DAY);
+    return DATE_TIME_LENGTH;
+}
+
+// Batch form for listings and exports: record i goes to out[i * DATE_TIME_LENGTH], fixed width and
+// unterminated. The date part is reused while consecutive timestamps fall on the same local day.
+// Returns how many records were written; stops at the first one that cannot be formatted.
+size_t formatLocalDateTimes(std::span<const time_t> timestamps, std::span<char> out) {
+    const TimeZoneTable& zone = TimeZoneTable::local();
+    size_t count = std::min(timestamps.size(), out.size() / DATE_TIME_LENGTH);
+    int64_t currentDay = 0;
+    char date[11];
+    bool haveDate = false;
+    for (size_t i = 0; i < count; ++i) {
+        int64_t local = zone.toLocal(timestamps[i]);
+        int64_t day = floorDiv(local, TimeZoneTable::SECONDS_PER_DAY);
+        if (!haveDate || day != currentDay) {
+            if (!writeLocalDate(date, day)) {
+                return i;
+            }
+            currentDay = day;
+            haveDate = true;
+        }
+        char* record = out.data() + i * DATE_TIME_LENGTH;
+        std::copy(date, date + 11, record);
+        writeLocalTime(record + 11, local - day * TimeZoneTable::SECONDS_PER_DAY);
+    }
+    return count;
+}
+
 //---------------------------------------------------------------------------------------------------
 //------------------DATA EXTRACTION FROM SQLite3 DB--------------------------------------------------
 //---------------------------------------------------------------------------------------------------
+// "dd-mm-yyyy HH:MM:SS" in local time. Years outside 0..9999 do not fit the fixed width and go
+// through the C library as before (strftime prints them as they are); "" only if that fails too.
 std::string unixToString(time_t raw_time) {
-    struct tm time_info;
-    localtime_s(&time_info, &raw_time);
-
     char buffer[80];
-    strftime(buffer, sizeof(buffer), "%d-%m-%Y %H:%M:%S", &time_info);
-    return std::string(buffer);
+    size_t length = formatLocalDateTime(raw_time, buffer);
+    if (length == 0) {
+        std::optional<struct tm> timeInfo = TimeZoneTable::libraryLocalTime(raw_time);
+        length = timeInfo ? strftime(buffer, sizeof(buffer), "%d-%m-%Y %H:%M:%S", &*timeInfo) : 0;
+    }
+    return std::string(buffer, length);
 }
 
 std::optional<struct tm> optStringToStructTm(const std::optional<std::string>& dateTimeStr) {
     if (!dateTimeStr) {
         return std::nullopt; // Return empty if the optional doesn't contain a value
     }
-    struct tm timeInfo = {};
-    std::istringstream ss(*dateTimeStr);
-    // Parse the string assuming the format "dd-mm-yyyy HH:MM:SS"
-    ss >> std::get_time(&timeInfo, "%d-%m-%Y %H:%M:%S");
-    if (ss.fail()) {
+    std::optional<DateTimeFields> fields = parseDateTimeFields(*dateTimeStr);
+    if (!fields) {
         std::cerr << "Failed to parse date-time string: " << *dateTimeStr << std::endl;
         return std::nullopt;
     }
+    struct tm timeInfo = {};
+    timeInfo.tm_year = fields->year - 1900;
+    timeInfo.tm_mon = fields->month - 1;
+    timeInfo.tm_mday = fields->day;
+    timeInfo.tm_hour = fields->hour;
+    timeInfo.tm_min = fields->minute;
+    timeInfo.tm_sec = fields->second;
     return timeInfo;
 }
 void showStructTm(struct tm result) {
@@ -85,7 +222,7 @@ time_t structTmToUnix(const std::optional<tm>& timeInfo) {
     return mktime(const_cast<struct tm*>(&(*timeInfo)));
 }
 
-time_t extractDate(sqlite3* db, const std::string& table, const std::string& column, const std::string& conditionColumn, const std::string& conditionValue) {
+time_t extractDate(Database& db, const std::string& table, const std::string& column, const std::string& conditionColumn, const std::string& conditionValue) {
     // Step 1: Retrieve the date string from the database
     auto dateString = getItem(db, table, column, conditionColumn, conditionValue);
     if (!dateString) {
@@ -104,4 +241,4 @@ time_t extractDate(sqlite3* db, const std::string& table, const std::string& col
     return structTmToUnix(*timeStruct);
 }
 
-#endif UTIL_H
\ No newline at end of file
+#endif // UTIL_H
\ No newline at end of file
@@ -1,60 +1,314 @@
 ﻿#define CURL_STATICLIB
 #define NOMINMAX
 #define WIN32_LEAN_AND_MEAN
-#include "httpFunc.h"
-#include <sqliteFunc.h>
+#include "syncFunc.h"
+#include "benchmark.h"
+#include <csignal>
+#include <cstdlib>
+#include <charconv>
+
+std::atomic<bool> stopRequested{ false };
+
+// Reads the value after argv[i] as a number; prints an error and returns false if it is missing or malformed
+template <typename T>
+bool readNumberArgument(int argc, char* argv[], int& i, T& value) {
+    std::string_view name = argv[i];
+    if (i + 1 < argc) {
+        std::string_view text = argv[++i];
+        auto [end, error] = std::from_chars(text.data(), text.data() + text.size(), value);
+        if (error == std::errc() && end == text.data() + text.size()) {
+            return true;
+        }
+    }
+    std::cerr << "Missing or invalid value for " << name << std::endl;
+    return false;
+}
+
+int main(int argc, char* argv[]) {
+    // libcurl (and Winsock on Windows) is initialized once, before any thread uses it. The cleanup
+    // is registered first, so it runs after the static clients and thread loops are destroyed.
+    if (curl_global_init(CURL_GLOBAL_DEFAULT) != CURLE_OK) {
+        std::cerr << "Failed to initialize libcurl" << std::endl;
+        return 1;
+    }
+    std::atexit(curl_global_cleanup);
 
-int main() {
     // ----------------------------------------------------------------------------------
     // Setting the console to UTF-8
     
     std::locale::global(std::locale("uk_UA.UTF-8"));
 
     // ----------------------------------------------------------------------------------
-    sqlite3* db;
-    int rc;
-
     // DB OPENING
-    rc = sqlite3_open("septim.db", &db);
-    if (rc) {
-        std::cerr << "DB Error: " << sqlite3_errmsg(db) << std::endl;
-        sqlite3_close(db);
+    // Arguments: a storage profile (durable | balanced | bulk-load) and/or a maintenance command
+    //   --rebuild-rollup  recompute DailyTotals from Transactions
+    //   --check-rollup    compare DailyTotals with Transactions
+    //   --restore-from-cache  refill Transactions from the response cache without network access
+    //   --columnar        keep an in-memory columnar copy of Transactions for reports
+    // API and benchmarking:
+    //   --api-url URL     use another API deployment, e.g. a mock started with --mock-api
+    //   --mock-api PORT   serve the recorded responses (septim_cache) as a local API until Ctrl+C
+    //   --bench           sync every user of the corpus from an in-process mock API into a scratch database
+    //   --synthetic N     mock/bench corpus: N generated messages instead of the recorded ones
+    //   --latency MS, --jitter MS, --bandwidth BYTES_PER_S, --error-rate P, --throttle-rate P
+    //                     shape the mock's responses (P is a share, 0..1)
+    //   --rate-limit N    the mock answers 429 above N /receive requests per second (token bucket)
+    //   --unfiltered-getid  the mock ignores /getid query parameters, like the API before pushdown
+    //   --event-loop      ingest with coroutines on one event loop instead of stage threads
+    //   --in-flight N     upper limit for concurrent /receive requests
+    //   --report-bench N  time range reports over N synthetic rows: SQLite vs the columnar copy
+    //   --calendar-bench N  day/week/month starts of N random timestamps: localtime+mktime vs the zone table
+    //   --datetime-bench N  format, parse and fuzz N "dd-mm-yyyy HH:MM:SS" strings against strftime/get_time
+    //   --base64-bench N  decode N random base64url inputs with every kernel and the old decoder, then time them
+    //   --message-id-bench N  parse, pack and print N random MessageIDs and check they round-trip
+    //   --decoder-bench N  decode N synthetic /receive bodies: typed decoder vs nlohmann DOM, time and allocations
+    StorageProfile storageProfile = StorageProfile::Balanced;
+    bool rebuildRollup = false;
+    bool checkRollup = false;
+    bool restoreCache = false;
+    bool runBenchmark = false;
+    bool columnar = false;
+    size_t reportBenchmarkRows = 0;
+    size_t calendarBenchmarkTimestamps = 0;
+    size_t dateTimeBenchmarkTimestamps = 0;
+    size_t base64BenchmarkInputs = 0;
+    size_t messageIdBenchmarkIds = 0;
+    size_t decoderBenchmarkMessages = 0;
+    int mockPort = -1;
+    size_t syntheticMessages = 0;
+    MockApiSettings mockSettings;
+
+    PipelineOptions pipelineOptions;
+    pipelineOptions.fetch.initial = 8;
+    pipelineOptions.fetch.maximum = 64;
+    pipelineOptions.stopRequested = &stopRequested;
+
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        long long milliseconds = 0;
+        bool ok = true;
+        if (arg == "--rebuild-rollup") {
+            rebuildRollup = true;
+        }
+        else if (arg == "--check-rollup") {
+            checkRollup = true;
+        }
+        else if (arg == "--restore-from-cache") {
+            restoreCache = true;
+        }
+        else if (arg == "--columnar") {
+            columnar = true;
+        }
+        else if (arg == "--report-bench") {
+            ok = readNumberArgument(argc, argv, i, reportBenchmarkRows) && reportBenchmarkRows > 0;
+        }
+        else if (arg == "--calendar-bench") {
+            ok = readNumberArgument(argc, argv, i, calendarBenchmarkTimestamps) && calendarBenchmarkTimestamps > 0;
+        }
+        else if (arg == "--datetime-bench") {
+            ok = readNumberArgument(argc, argv, i, dateTimeBenchmarkTimestamps) && dateTimeBenchmarkTimestamps > 0;
+        }
+        else if (arg == "--base64-bench") {
+            ok = readNumberArgument(argc, argv, i, base64BenchmarkInputs) && base64BenchmarkInputs > 0;
+        }
+        else if (arg == "--message-id-bench") {
+            ok = readNumberArgument(argc, argv, i, messageIdBenchmarkIds) && messageIdBenchmarkIds > 0;
+        }
+        else if (arg == "--decoder-bench") {
+            ok = readNumberArgument(argc, argv, i, decoderBenchmarkMessages) && decoderBenchmarkMessages > 0;
+        }
+        else if (arg == "--api-url" && i + 1 < argc) {
+            setApiBaseUrl(argv[++i]);
+        }
+        else if (arg == "--mock-api") {
+            ok = readNumberArgument(argc, argv, i, mockPort) && mockPort >= 0 && mockPort <= 65535;
+        }
+        else if (arg == "--bench") {
+            runBenchmark = true;
+        }
+        else if (arg == "--synthetic") {
+            ok = readNumberArgument(argc, argv, i, syntheticMessages);
+        }
+        else if (arg == "--latency") {
+            ok = readNumberArgument(argc, argv, i, milliseconds);
+            mockSettings.latency = std::chrono::milliseconds(milliseconds);
+        }
+        else if (arg == "--jitter") {
+            ok = readNumberArgument(argc, argv, i, milliseconds);
+            mockSettings.jitter = std::chrono::milliseconds(milliseconds);
+        }
+        else if (arg == "--bandwidth") {
+            ok = readNumberArgument(argc, argv, i, mockSettings.bandwidth);
+        }
+        else if (arg == "--error-rate") {
+            ok = readNumberArgument(argc, argv, i, mockSettings.errorRate);
+        }
+        else if (arg == "--throttle-rate") {
+            ok = readNumberArgument(argc, argv, i, mockSettings.throttleRate);
+        }
+        else if (arg == "--rate-limit") {
+            ok = readNumberArgument(argc, argv, i, mockSettings.maxRequestsPerSecond) && mockSettings.maxRequestsPerSecond > 0;
+        }
+        else if (arg == "--unfiltered-getid") {
+            mockSettings.ignoreGetIdFilters = true;
+        }
+        else if (arg == "--event-loop") {
+            pipelineOptions.eventLoop = true;
+        }
+        else if (arg == "--in-flight") {
+            ok = readNumberArgument(argc, argv, i, pipelineOptions.fetch.maximum) && pipelineOptions.fetch.maximum > 0;
+            pipelineOptions.fetch.initial = std::min(pipelineOptions.fetch.initial, pipelineOptions.fetch.maximum);
+        }
+        else if (auto requested = parseStorageProfile(arg)) {
+            storageProfile = *requested;
+        }
+        else {
+            std::cerr << "Unknown argument: " << arg << std::endl;
+            return 1;
+        }
+        if (!ok) {
+            return 1;
+        }
+    }
+    // Ctrl+C stops new fetches (what is already fetched is still parsed and committed) and stops --mock-api
+    std::signal(SIGINT, [](int) { stopRequested = true; });
+
+    if (reportBenchmarkRows > 0) {
+        ReportBenchmarkSettings benchmark;
+        benchmark.rows = reportBenchmarkRows;
+        ReportBenchmarkResult result = runReportBenchmark(benchmark);
+        result.print();
+        return result.mismatches == 0 && result.mutationMismatches == 0 && result.rollupZoneMismatches == 0 ? 0 : 1;
+    }
+    if (calendarBenchmarkTimestamps > 0) {
+        CalendarBenchmarkSettings benchmark;
+        benchmark.timestamps = calendarBenchmarkTimestamps;
+        CalendarBenchmarkResult result = runCalendarBenchmark(benchmark);
+        result.print();
+        return result.mismatches == 0 ? 0 : 1;
+    }
+    if (dateTimeBenchmarkTimestamps > 0) {
+        DateTimeBenchmarkSettings benchmark;
+        benchmark.timestamps = dateTimeBenchmarkTimestamps;
+        DateTimeBenchmarkResult result = runDateTimeBenchmark(benchmark);
+        result.print();
+        return result.mismatches == 0 ? 0 : 1;
+    }
+    if (base64BenchmarkInputs > 0) {
+        Base64BenchmarkSettings benchmark;
+        benchmark.inputs = base64BenchmarkInputs;
+        Base64BenchmarkResult result = runBase64Benchmark(benchmark);
+        result.print();
+        return result.mismatches == 0 ? 0 : 1;
+    }
+    if (messageIdBenchmarkIds > 0) {
+        MessageIdBenchmarkSettings benchmark;
+        benchmark.ids = messageIdBenchmarkIds;
+        MessageIdBenchmarkResult result = runMessageIdBenchmark(benchmark);
+        result.print();
+        return result.mismatches == 0 ? 0 : 1;
+    }
+    if (decoderBenchmarkMessages > 0) {
+        DecoderBenchmarkSettings benchmark;
+        benchmark.messages = decoderBenchmarkMessages;
+        DecoderBenchmarkResult result = runDecoderBenchmark(benchmark);
+        result.print();
+        return result.mismatches == 0 ? 0 : 1;
+    }
+    if (runBenchmark) {
+        IngestBenchmarkSettings benchmark;
+        if (syntheticMessages > 0) {
+            benchmark.messages = syntheticMessages;
+        }
+        else {
+            benchmark.replayCache = "septim_cache";
+        }
+        benchmark.api = mockSettings;
+        benchmark.pipeline = pipelineOptions;
+        IngestBenchmarkResult result = runIngestBenchmark(benchmark);
+        result.print();
+        return result.stored > 0 ? 0 : 1;
+    }
+    if (mockPort >= 0) {
+        MockCorpus corpus;
+        if (syntheticMessages > 0) {
+            corpus = MockCorpus::synthetic(syntheticMessages);
+        }
+        else {
+            ResponseCache recorded("septim_cache");
+            corpus = MockCorpus::fromCache(recorded);
+        }
+        size_t messageCount = corpus.size();
+        mockSettings.port = static_cast<uint16_t>(mockPort);
+        MockApiServer server(std::move(corpus), mockSettings);
+        if (!server.start()) {
+            return 1;
+        }
+        std::cout << "Mock API serving " << messageCount << " messages at " << server.baseUrl() << " (Ctrl+C to stop)" << std::endl;
+        while (!stopRequested) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(200));
+        }
+        server.printStats();
+        return 0;
+    }
+
+    Database db("septim.db", storageProfile);
+    if (!db.isOpen() || !migrateSchema(db)) {
         return 1;
     }
+    if (rebuildRollup || checkRollup) {
+        bool ok = (!rebuildRollup || rebuildDailyTotals(db)) && (!checkRollup || checkDailyTotals(db) == 0);
+        return ok ? 0 : 1;
+    }
+    if (!ensureRollupZone(db)) {
+        return 1;
+    }
+
+    // Reports can read this copy instead of SQLite; the Transactions write helpers keep it current
+    TransactionColumns columns;
+    if (columnar && columns.loadFromDatabase(db)) {
+        db.attachColumns(&columns);
+        columns.printStats();
+    }
+
+    // Every fetched /receive response is kept here, so a rebuilt septim.db does not need the network
+    ResponseCache responseCache("septim_cache");
+    if (restoreCache) {
+        restoreFromCache(db, responseCache);
+        responseCache.printStats();
+        return 0;
+    }
     // ----------------------------------------------------------------------------------
     std::string encoded = "RHJheWJpbg_67894914_013e";
     std::cout << "Decoded: " << Base64Decode(encoded) << std::endl;
 
 
     std::string targetUserID = "Draybin";
-    time_t actualTimestamp = 173000000;
-    auto filteredMessageIDs = getActualID(targetUserID, actualTimestamp);
-
-    // Output filtered MessageIDs
-    std::cout << "Filtered MessageIDs for user '" << targetUserID << "':\n";
-    for (const auto& messageID : filteredMessageIDs) {
-        std::cout << messageID << std::endl;
-    }
-
-    // Iterate over each filtered message ID
-    for (const auto& messageID : filteredMessageIDs) {
-        // Fetch and parse the data
-        auto data = GetMessageData(messageID);
+    HttpClient& httpClient = defaultHttpClient();
+    httpClient.resetStats();
 
-        if (data.has_value()) {
-            const auto& messageData = data.value();
+    // Sync starts from the cursor stored in Settings and only fetches messages newer than it
+    pipelineOptions.cache = &responseCache;
+    // IDs already in Transactions are never fetched again
+    KnownMessageIds knownIDs;
+    knownIDs.loadFromDatabase(db);
+    SyncResult sync = syncUser(db, targetUserID, pipelineOptions, httpClient, &knownIDs);
 
-            addTransaction(db, messageData.messageID, messageData.userID, messageData.amount, 
-                messageData.categoryID, messageData.message, messageData.unixTimestamp);
-        }
-        else {
-            std::cerr << "Failed to retrieve data for MessageID: " << messageID << std::endl;
-        }
+    std::cout << "Synced user '" << targetUserID << "': " << sync.candidates << " new, "
+        << sync.stored << " stored, " << sync.failed << " failed; cursor at "
+        << sync.cursor.timestamp << " (" << sync.cursor.lastMessageID << ")" << std::endl;
+    sync.pipeline.print();
+    httpClient.printStats();
+    responseCache.printStats();
+    knownIDs.printStats();
+    if (db.attachedColumns()) {
+        columns.printStats();
     }
 
     // ----------------------------------------------------------------------------------
 
-    // DB CLOSING
-    sqlite3_close(db);
+    db.printCacheStats();
+
+    // DB CLOSING (statements are finalized and the connection closed by ~Database)
     return 0;
 }